@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * batch-allocation-benchmark.cc
+ *
+ *      Author: hassam
+ *
+ * Compare the batch min-cost flow assignment of BatchAllocator with the
+ * greedy first fit used task by task by manet-routing-compare. Every run
+ * draws nodes with random neighbours, interface rates and link lifetimes,
+ * and a batch of tasks with the sizes and deadlines of the experiment, then
+ * reports the share of tasks each assignment accepts and the time it takes.
+ *
+ * ./waf --run "batch-allocation-benchmark --runs=1000 --tasks=10"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/batch-allocator.h"
+#include <chrono>
+#include <iomanip>
+#include <random>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t runs = 500;
+  uint32_t nodes = 5;
+  uint32_t tasks = 10;
+  uint32_t maxNeighbours = 6;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("runs", "Number of random batches", runs);
+  cmd.AddValue ("nodes", "Nodes offloading tasks", nodes);
+  cmd.AddValue ("tasks", "Tasks per batch", tasks);
+  cmd.AddValue ("maxNeighbours", "Most neighbours of a node", maxNeighbours);
+  cmd.AddValue ("seed", "Seed of the random batches", seed);
+  cmd.Parse (argc, argv);
+
+  // the task mix of manet-routing-compare, in Mbit and seconds
+  const double sizes[5] = {110, 300, 190, 750, 150};
+  const double deadlines[5] = {10, 20, 15, 30, 12};
+
+  std::mt19937 rng (seed);
+  std::uniform_int_distribution<uint32_t> pick (0, 4);
+  std::uniform_int_distribution<uint32_t> neighbours (1, std::max<uint32_t> (maxNeighbours, 1));
+  std::uniform_real_distribution<double> rateW (5, 30);
+  std::uniform_real_distribution<double> rateWD (20, 100);
+  std::uniform_real_distribution<double> lifetime (1, 60);
+  std::bernoulli_distribution hasWD (0.7);
+
+  uint64_t acceptedGreedy = 0, acceptedFlow = 0, offered = 0;
+  double timeGreedy = 0, timeFlow = 0;
+  for (uint32_t r = 0; r < runs; r++)
+    {
+      std::vector<BatchLink> links;
+      for (uint32_t n = 0; n < nodes; n++)
+        {
+          double w = rateW (rng), wd = rateWD (rng);
+          uint32_t count = neighbours (rng);
+          for (uint32_t k = 0; k < count; k++)
+            {
+              BatchLink link = {n, k, 0, w, lifetime (rng)};
+              links.push_back (link);
+              if (hasWD (rng))
+                {
+                  link.iface = 1;
+                  link.rate = wd;
+                  link.lifetime = lifetime (rng);
+                  links.push_back (link);
+                }
+            }
+        }
+      std::vector<BatchTask> batch;
+      for (uint32_t t = 0; t < tasks; t++)
+        {
+          uint32_t kind = pick (rng);
+          BatchTask task = {t, t % nodes, sizes[kind], deadlines[kind]};
+          batch.push_back (task);
+        }
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+      BatchResult greedy = BatchAllocator::AssignGreedy (batch, links);
+      std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now ();
+      BatchResult flow = BatchAllocator::Assign (batch, links);
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+
+      acceptedGreedy += greedy.GetAccepted ();
+      acceptedFlow += flow.GetAccepted ();
+      offered += batch.size ();
+      timeGreedy += std::chrono::duration<double, std::micro> (middle - start).count ();
+      timeFlow += std::chrono::duration<double, std::micro> (end - middle).count ();
+    }
+
+  std::cout << std::fixed << std::setprecision (3)
+            << "Assignment\tAcceptance\tMeanTimeUs" << std::endl
+            << "greedy\t" << static_cast<double> (acceptedGreedy) / offered << "\t" << timeGreedy / runs << std::endl
+            << "min-cost-flow\t" << static_cast<double> (acceptedFlow) / offered << "\t" << timeFlow / runs << std::endl;
+  return 0;
+}
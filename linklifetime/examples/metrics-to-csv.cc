@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * metrics-to-csv.cc
+ *
+ *      Author: hassam
+ *
+ * Convert a columnar metrics file written by ColumnarMetricsOutput back to
+ * CSV. With --node, only the rows of that node are written and the NodeId
+ * column is dropped, which reproduces the per node CSV files of the
+ * manet-routing-compare experiment.
+ *
+ * ./waf --run "metrics-to-csv --input=manet-routing.output.llmc --output=all.csv"
+ * ./waf --run "metrics-to-csv --input=manet-routing.output.llmc --output=0.csv --node=0"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/columnar-metrics.h"
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output = "metrics.csv";
+  int32_t node = -1;
+
+  CommandLine cmd;
+  cmd.AddValue ("input", "Columnar metrics file to read", input);
+  cmd.AddValue ("output", "CSV file to write", output);
+  cmd.AddValue ("node", "Only write the rows of this node (-1 for all)", node);
+  cmd.Parse (argc, argv);
+
+  ColumnarMetricsReader reader;
+  if (!reader.Open (input))
+    {
+      std::cerr << input << " is not a columnar metrics file" << std::endl;
+      return 1;
+    }
+
+  MetricsSchema schema = reader.GetSchema ();
+  bool filter = node >= 0;
+  if (filter && (schema.empty () || schema[0].name != "NodeId"))
+    {
+      std::cerr << input << " has no NodeId column" << std::endl;
+      return 1;
+    }
+  if (filter)
+    {
+      schema.erase (schema.begin ());
+    }
+
+  CsvMetricsOutput csv (output, schema);
+  std::vector<MetricsRecord> rows;
+  for (uint32_t g = 0; g < reader.GetRowGroupCount (); g++)
+    {
+      if (!reader.ReadRowGroup (g, rows))
+        {
+          std::cerr << "row group " << g << " of " << input << " is corrupt" << std::endl;
+          return 1;
+        }
+      for (std::size_t r = 0; r < rows.size (); r++)
+        {
+          if (!filter)
+            {
+              csv.Format (rows[r]);
+              continue;
+            }
+          if (rows[r].GetU64 (0) != static_cast<uint64_t> (node))
+            {
+              continue;
+            }
+          MetricsRecord row;
+          for (uint16_t c = 1; c < rows[r].GetSize (); c++)
+            {
+              if (rows[r].GetKind (c) == METRICS_U64)
+                {
+                  row << rows[r].GetU64 (c);
+                }
+              else
+                {
+                  row << rows[r].GetF64 (c);
+                }
+            }
+          csv.Format (row);
+        }
+      csv.WriteOut ();
+    }
+  csv.Finish ();
+
+  std::cout << "Converted " << reader.GetRowCount () << " rows in "
+            << reader.GetRowGroupCount () << " row groups" << std::endl;
+  return 0;
+}
@@ -0,0 +1,162 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * resource-allocator-benchmark.cc
+ *
+ *      Author: hassam
+ *
+ * Push synthetic (size, deadline, LLTW, LLTWD, bandwidth) tuples through
+ * ResourceAllocator::Split, the Wi-Fi / Wi-Fi Direct split shared by
+ * manet-routing-compare, main.cpp and dce-iperf, and report the decisions
+ * per second. The tuples are drawn up front, with the sizes and deadlines of
+ * the experiment, and cycled through so that the random draws stay out of
+ * the measurement.
+ *
+ * It then evaluates the same tuples as batches of 1k and 100k pairs laid out
+ * one array per field, once pair by pair through Split and once through
+ * ResourceAllocator::SplitBatch, checks that both agree and reports the
+ * speedup. Build with CXXFLAGS="-O3 -mavx2" for the AVX2 kernel.
+ *
+ * ./waf --run "resource-allocator-benchmark --decisions=10000000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/resource-allocator.h"
+#include <chrono>
+#include <iomanip>
+#include <cmath>
+#include <random>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint64_t decisions = 5000000;
+  uint32_t distinct = 65536;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("decisions", "Number of splits to compute", decisions);
+  cmd.AddValue ("distinct", "Distinct tuples cycled through", distinct);
+  cmd.AddValue ("seed", "Seed of the tuples", seed);
+  cmd.Parse (argc, argv);
+  distinct = std::max<uint32_t> (distinct, 1);
+
+  // the task mix of manet-routing-compare, in Mbit and seconds
+  const double sizes[5] = {110, 300, 190, 750, 150};
+  const double deadlines[5] = {10, 20, 15, 30, 12};
+  const double lifetimes[3] = {10, 30, 60};
+
+  std::mt19937 rng (seed);
+  std::uniform_int_distribution<uint32_t> pick (0, 4);
+  std::uniform_int_distribution<uint32_t> interval (0, 2);
+  std::uniform_real_distribution<double> rateW (5, 30);
+  std::uniform_real_distribution<double> rateWD (20, 100);
+  std::vector<SplitRequest> requests (distinct);
+  for (uint32_t i = 0; i < distinct; i++)
+    {
+      uint32_t kind = pick (rng);
+      SplitRequest &r = requests[i];
+      r.size = sizes[kind];
+      r.deadline = deadlines[kind];
+      r.rateW = rateW (rng);
+      r.rateWD = rateWD (rng);
+      r.usableW = std::min (r.deadline, lifetimes[interval (rng)]);
+      r.usableWD = std::min (r.deadline, lifetimes[interval (rng)]);
+      r.delayW = 0;
+      r.delayWD = 0;
+    }
+
+  uint64_t feasible = 0, wdFirst = 0;
+  double completion = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint64_t d = 0, i = 0; d < decisions; d++)
+    {
+      SplitResult s = ResourceAllocator::Split (requests[i]);
+      feasible += s.feasible;
+      wdFirst += s.wdFirst;
+      completion += s.completion;
+      if (++i == distinct)
+        {
+          i = 0;
+        }
+    }
+  double seconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+  std::cout << std::fixed << std::setprecision (3)
+            << "Decisions\tFeasible\tWdFirst\tMeanCompletion\tSeconds\tDecisionsPerSecond" << std::endl
+            << decisions << "\t" << static_cast<double> (feasible) / std::max<uint64_t> (decisions, 1)
+            << "\t" << static_cast<double> (wdFirst) / std::max<uint64_t> (decisions, 1)
+            << "\t" << completion / std::max<uint64_t> (decisions, 1)
+            << "\t" << seconds << "\t" << std::setprecision (0) << (seconds > 0 ? decisions / seconds : 0) << std::endl;
+
+  std::cout << std::setprecision (3) << "Pairs\tScalarNsPerPair\tBatchNsPerPair\tSpeedup\tMismatches\tMaxRelError\tChecksum" << std::endl;
+  const uint32_t pairCounts[2] = {1000, 100000};
+  for (uint32_t pairs : pairCounts)
+    {
+      std::vector<double> size (pairs), deadline (pairs), rW (pairs), rWD (pairs),
+                          uW (pairs), uWD (pairs), dW (pairs), dWD (pairs);
+      for (uint32_t i = 0; i < pairs; i++)
+        {
+          const SplitRequest &r = requests[i % distinct];
+          size[i] = r.size;
+          deadline[i] = r.deadline;
+          rW[i] = r.rateW;
+          rWD[i] = r.rateWD;
+          uW[i] = r.usableW;
+          uWD[i] = r.usableWD;
+          dW[i] = r.delayW;
+          dWD[i] = r.delayWD;
+        }
+      SplitBatchInput in = {size.data (), deadline.data (), rW.data (), rWD.data (),
+                            uW.data (), uWD.data (), dW.data (), dWD.data ()};
+      std::vector<uint8_t> feasibleOut (pairs), wdFirstOut (pairs);
+      std::vector<double> finalOut (pairs), remainingOut (pairs), completionOut (pairs);
+      SplitBatchOutput out = {feasibleOut.data (), wdFirstOut.data (), finalOut.data (),
+                              remainingOut.data (), completionOut.data ()};
+      uint64_t rounds = std::max<uint64_t> (decisions / pairs, 1);
+
+      // scalar reference, reading the same arrays
+      double check = 0;
+      start = std::chrono::steady_clock::now ();
+      for (uint64_t k = 0; k < rounds; k++)
+        {
+          for (uint32_t i = 0; i < pairs; i++)
+            {
+              SplitRequest r = {size[i], deadline[i], rW[i], rWD[i], uW[i], uWD[i], dW[i], dWD[i]};
+              SplitResult s = ResourceAllocator::Split (r);
+              check += s.completion + s.feasible;
+            }
+        }
+      double scalarSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+      start = std::chrono::steady_clock::now ();
+      for (uint64_t k = 0; k < rounds; k++)
+        {
+          ResourceAllocator::SplitBatch (pairs, in, out);
+          check += completionOut[k % pairs];
+        }
+      double batchSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now () - start).count ();
+
+      uint32_t mismatches = 0;
+      double maxError = 0;
+      for (uint32_t i = 0; i < pairs; i++)
+        {
+          SplitRequest r = {size[i], deadline[i], rW[i], rWD[i], uW[i], uWD[i], dW[i], dWD[i]};
+          SplitResult s = ResourceAllocator::Split (r);
+          mismatches += s.feasible != feasibleOut[i] || s.wdFirst != wdFirstOut[i];
+          const double expected[3] = {s.finalData, s.remainingData, s.completion};
+          const double got[3] = {finalOut[i], remainingOut[i], completionOut[i]};
+          for (int f = 0; f < 3; f++)
+            {
+              maxError = std::max (maxError, std::fabs (got[f] - expected[f]) / std::max (std::fabs (expected[f]), 1.0));
+            }
+        }
+
+      double total = static_cast<double> (rounds) * pairs;
+      std::cout << pairs << "\t" << scalarSeconds * 1e9 / total << "\t" << batchSeconds * 1e9 / total
+                << "\t" << (batchSeconds > 0 ? scalarSeconds / batchSeconds : 0) << "\t" << mismatches
+                << "\t" << std::scientific << maxError << std::fixed << "\t" << check << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,98 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * trace-hookup-benchmark.cc
+ *
+ *      Author: hassam
+ *
+ * Compare the cost of connecting the TxWithAddresses trace of a freshly
+ * installed application through its Config path with connecting it on the
+ * pointer the installer already holds. Every node gets more and more
+ * TransferApplications; a path such as
+ * /NodeList/<n>/ApplicationList/<k>/$ns3::TransferApplication/TxWithAddresses
+ * is resolved by walking the node and application lists and matching every
+ * entry against the index, so each install costs more than the one before,
+ * while TraceConnectWithoutContext on the pointer costs the same throughout.
+ * Reports the mean time per install for each block of installs.
+ *
+ * ./waf --run "trace-hookup-benchmark --nodes=20 --maxTasks=4096"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/transfer-application.h"
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+using namespace ns3;
+
+static uint64_t g_packets = 0;
+
+static void
+TxWithAddresses (Ptr<const Packet> packet, const Address &from, const Address &to)
+{
+  g_packets++;
+}
+
+// Install apps on every node until each has count of them, and return the mean microseconds per install
+static double
+InstallUpTo (NodeContainer nodes, uint32_t count, bool direct)
+{
+  uint64_t installs = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Node> node = nodes.Get (i);
+      while (node->GetNApplications () < count)
+        {
+          Ptr<TransferApplication> app = CreateObject<TransferApplication> ();
+          uint32_t index = node->AddApplication (app);
+          if (direct)
+            {
+              app->TraceConnectWithoutContext ("TxWithAddresses", MakeCallback (&TxWithAddresses));
+            }
+          else
+            {
+              std::ostringstream path;
+              path << "/NodeList/" << node->GetId () << "/ApplicationList/" << index
+                   << "/$ns3::TransferApplication/TxWithAddresses";
+              Config::ConnectWithoutContext (path.str (), MakeCallback (&TxWithAddresses));
+            }
+          installs++;
+        }
+    }
+  double micros = std::chrono::duration<double, std::micro> (std::chrono::steady_clock::now () - start).count ();
+  return installs > 0 ? micros / installs : 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 10;
+  uint32_t maxTasks = 4096;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes", nodes);
+  cmd.AddValue ("maxTasks", "Applications per node at the end", maxTasks);
+  cmd.Parse (argc, argv);
+
+  NodeContainer pathNodes, directNodes;
+  pathNodes.Create (nodes);
+  directNodes.Create (nodes);
+
+  std::cout << std::fixed << std::setprecision (3)
+            << "TasksPerNode\tConfigPathUs\tDirectUs\tSpeedup" << std::endl;
+  for (uint32_t count = std::min<uint32_t> (16, maxTasks); ; count = std::min (count * 2, maxTasks))
+    {
+      double path = InstallUpTo (pathNodes, count, false);
+      double direct = InstallUpTo (directNodes, count, true);
+      std::cout << count << "\t" << path << "\t" << direct << "\t" << (direct > 0 ? path / direct : 0) << std::endl;
+      if (count >= maxTasks)
+        {
+          break;
+        }
+    }
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * bandwidth-ledger.cc
+ *
+ *      Author: hassam
+ */
+
+#include "bandwidth-ledger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+BandwidthLedger::BandwidthLedger (Time slot, Time window)
+  : m_slot (slot),
+    m_slots (1),
+    m_base (0),
+    m_nextId (1)
+{
+  uint64_t needed = window.GetTimeStep () / m_slot.GetTimeStep () + 1;
+  while (m_slots < needed)
+    {
+      m_slots <<= 1;
+    }
+}
+
+uint64_t
+BandwidthLedger::SlotOf (Time t) const
+{
+  if (!t.IsStrictlyPositive ())
+    {
+      return 0;
+    }
+  return t.GetTimeStep () / m_slot.GetTimeStep ();
+}
+
+uint64_t
+BandwidthLedger::SlotAfter (Time t) const
+{
+  if (!t.IsStrictlyPositive ())
+    {
+      return 0;
+    }
+  uint64_t step = m_slot.GetTimeStep ();
+  return (t.GetTimeStep () + step - 1) / step;
+}
+
+void
+BandwidthLedger::Advance (Time now)
+{
+  uint64_t base = SlotOf (now);
+  if (base <= m_base)
+    {
+      return;
+    }
+  if (m_max.empty () || base >= m_base + m_slots)
+    {
+      // every slot of the old window is behind
+      std::fill (m_max.begin (), m_max.end (), 0);
+      std::fill (m_pending.begin (), m_pending.end (), 0);
+    }
+  else
+    {
+      for (uint64_t s = m_base; s < base; s++)
+        {
+          uint32_t leaf = s % m_slots;
+          Add (1, 0, m_slots, leaf, leaf + 1, -Max (1, 0, m_slots, leaf, leaf + 1));
+        }
+    }
+  m_base = base;
+}
+
+void
+BandwidthLedger::AddSlots (uint64_t first, uint64_t end, int64_t delta)
+{
+  first = std::max (first, m_base);
+  end = std::min (end, m_base + m_slots);
+  if (end <= first)
+    {
+      return;
+    }
+  uint32_t lo = first % m_slots;
+  uint64_t hi = lo + (end - first);
+  if (hi <= m_slots)
+    {
+      Add (1, 0, m_slots, lo, hi, delta);
+    }
+  else
+    {
+      // the range wraps around the end of the tree
+      Add (1, 0, m_slots, lo, m_slots, delta);
+      Add (1, 0, m_slots, 0, hi - m_slots, delta);
+    }
+}
+
+void
+BandwidthLedger::Add (uint32_t node, uint32_t lo, uint32_t hi, uint32_t first, uint32_t end, int64_t delta)
+{
+  if (end <= lo || hi <= first)
+    {
+      return;
+    }
+  if (first <= lo && hi <= end)
+    {
+      m_pending[node] += delta;
+      m_max[node] += delta;
+      return;
+    }
+  uint32_t mid = lo + (hi - lo) / 2;
+  Add (2 * node, lo, mid, first, end, delta);
+  Add (2 * node + 1, mid, hi, first, end, delta);
+  m_max[node] = std::max (m_max[2 * node], m_max[2 * node + 1]) + m_pending[node];
+}
+
+int64_t
+BandwidthLedger::Max (uint32_t node, uint32_t lo, uint32_t hi, uint32_t first, uint32_t end) const
+{
+  if (first <= lo && hi <= end)
+    {
+      return m_max[node];
+    }
+  uint32_t mid = lo + (hi - lo) / 2;
+  // a subtree may hold a negative sum, cancelled by the additions pending above it
+  int64_t best;
+  if (end <= mid)
+    {
+      best = Max (2 * node, lo, mid, first, end);
+    }
+  else if (mid <= first)
+    {
+      best = Max (2 * node + 1, mid, hi, first, end);
+    }
+  else
+    {
+      best = std::max (Max (2 * node, lo, mid, first, end), Max (2 * node + 1, mid, hi, first, end));
+    }
+  return best + m_pending[node];
+}
+
+BandwidthLedger::ReservationId
+BandwidthLedger::Reserve (Time start, Time duration, double rate)
+{
+  if (m_max.empty ())
+    {
+      m_max.assign (2 * m_slots, 0);
+      m_pending.assign (2 * m_slots, 0);
+    }
+  Reservation r;
+  r.first = SlotOf (start);
+  r.end = std::min (SlotAfter (start + duration), m_base + m_slots);
+  r.stop = start + duration;
+  r.rate = static_cast<int64_t> (std::ceil (rate * 1e6));
+  AddSlots (r.first, r.end, r.rate);
+  ReservationId id = m_nextId++;
+  m_reservations[id] = r;
+  m_byStop.insert (std::make_pair (r.stop, id));
+  return id;
+}
+
+bool
+BandwidthLedger::Release (ReservationId id, Time now)
+{
+  std::map<ReservationId, Reservation>::iterator it = m_reservations.find (id);
+  if (it == m_reservations.end ())
+    {
+      return false;
+    }
+  Reservation &r = it->second;
+  AddSlots (std::max (r.first, SlotOf (now)), r.end, -r.rate);
+  m_byStop.erase (std::make_pair (r.stop, id));
+  m_reservations.erase (it);
+  return true;
+}
+
+void
+BandwidthLedger::Expire (Time now)
+{
+  Advance (now);
+  while (!m_byStop.empty () && m_byStop.begin ()->first <= now)
+    {
+      m_reservations.erase (m_byStop.begin ()->second);
+      m_byStop.erase (m_byStop.begin ());
+    }
+}
+
+double
+BandwidthLedger::GetReserved (Time start, Time duration) const
+{
+  uint64_t first = std::max (SlotOf (start), m_base);
+  uint64_t end = std::min (std::max (SlotAfter (start + duration), first + 1), m_base + m_slots);
+  if (m_max.empty () || end <= first)
+    {
+      return 0;
+    }
+  uint32_t lo = first % m_slots;
+  uint64_t hi = lo + (end - first);
+  if (hi <= m_slots)
+    {
+      return Max (1, 0, m_slots, lo, hi) / 1e6;
+    }
+  return std::max (Max (1, 0, m_slots, lo, m_slots), Max (1, 0, m_slots, 0, hi - m_slots)) / 1e6;
+}
+
+} // namespace ns3
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * bandwidth-ledger.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef BANDWIDTH_LEDGER_H
+#define BANDWIDTH_LEDGER_H
+
+#include "ns3/nstime.h"
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Rate committed to admitted transfers on one interface, over time.
+ *
+ * Every admitted transfer reserves a rate over a time window. The ledger
+ * splits time into fixed slots and keeps the reserved rate of the slots of a
+ * sliding window in a segment tree with lazy range additions, so Reserve,
+ * Release and GetReserved all cost O(log slots) whatever the number of
+ * reservations. The window starts at the last time passed to Expire and
+ * spans at least \p window; the slots it leaves behind are cleared and
+ * reused for the times it moves on to. Windows are widened to whole slots,
+ * which can only overestimate what is reserved; anything outside the window
+ * when it is reserved is ignored. The tree is only allocated on
+ * the first Reserve, so a node that never sends costs next to nothing.
+ *
+ * A reservation is released early by Release, e.g. when its transfer
+ * completes, and otherwise simply expires at the end of its window; the
+ * bookkeeping of expired reservations is dropped by Expire.
+ */
+class BandwidthLedger
+{
+public:
+  typedef uint64_t ReservationId;
+
+  /**
+   * \param slot time resolution of the ledger
+   * \param window how far ahead of the present the ledger looks, e.g. the longest deadline
+   */
+  BandwidthLedger (Time slot, Time window);
+
+  /**
+   * Commit \p rate Mbps over [\p start, \p start + \p duration).
+   * \returns the id to release the reservation with
+   */
+  ReservationId Reserve (Time start, Time duration, double rate);
+  /**
+   * Give back what is left of reservation \p id from \p now on.
+   * \returns false if \p id is unknown, already released or expired
+   */
+  bool Release (ReservationId id, Time now);
+  /// Forget reservations that ended at or before \p now and move the window on to \p now
+  void Expire (Time now);
+
+  /// \returns the highest rate, in Mbps, reserved at any time of [\p start, \p start + \p duration)
+  double GetReserved (Time start, Time duration) const;
+
+  /// \returns the number of reservations neither released nor expired
+  uint32_t GetReservations (void) const
+  {
+    return m_reservations.size ();
+  }
+
+private:
+  struct Reservation
+  {
+    uint64_t first;  //!< first slot
+    uint64_t end;    //!< slot past the last one, within the window when reserved
+    Time stop;
+    int64_t rate;    //!< in bit/s
+  };
+
+  /// \returns the slot holding \p t
+  uint64_t SlotOf (Time t) const;
+  /// \returns the first slot starting at or after \p t
+  uint64_t SlotAfter (Time t) const;
+  /// Clear the slots before the one holding \p now and let the window start there
+  void Advance (Time now);
+  /// Add \p delta to the slots [\p first, \p end) that are within the window
+  void AddSlots (uint64_t first, uint64_t end, int64_t delta);
+  void Add (uint32_t node, uint32_t lo, uint32_t hi, uint32_t first, uint32_t end, int64_t delta);
+  int64_t Max (uint32_t node, uint32_t lo, uint32_t hi, uint32_t first, uint32_t end) const;
+
+  Time m_slot;
+  uint32_t m_slots;               //!< leaves of the tree, a power of two; slot s is leaf s % m_slots
+  uint64_t m_base;                //!< first slot of the window
+  std::vector<int64_t> m_max;     //!< highest rate of the slots under a node, its own pending addition included
+  std::vector<int64_t> m_pending; //!< addition applying to every slot under a node
+  std::map<ReservationId, Reservation> m_reservations;
+  std::set<std::pair<Time, ReservationId> > m_byStop;  //!< reservations ordered by end of window
+  ReservationId m_nextId;
+};
+
+} // namespace ns3
+
+#endif /* BANDWIDTH_LEDGER_H */
@@ -0,0 +1,414 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * batch-allocator.cc
+ *
+ *      Author: hassam
+ */
+
+#include "batch-allocator.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+
+namespace ns3 {
+
+MinCostFlow::MinCostFlow (uint32_t vertices)
+  : m_adjacent (vertices)
+{
+}
+
+uint32_t
+MinCostFlow::AddEdge (uint32_t from, uint32_t to, int64_t capacity, int64_t cost)
+{
+  Edge forward = {to, capacity, cost};
+  Edge backward = {from, 0, -cost};
+  m_adjacent[from].push_back (m_edges.size ());
+  m_edges.push_back (forward);
+  m_adjacent[to].push_back (m_edges.size ());
+  m_edges.push_back (backward);
+  return m_edges.size () / 2 - 1;
+}
+
+int64_t
+MinCostFlow::GetFlow (uint32_t edge) const
+{
+  return m_edges[2 * edge + 1].capacity;
+}
+
+int64_t
+MinCostFlow::Solve (uint32_t source, uint32_t sink, int64_t &cost)
+{
+  const int64_t INF = std::numeric_limits<int64_t>::max ();
+  uint32_t n = m_adjacent.size ();
+  std::vector<int64_t> potential (n, 0);
+  std::vector<int64_t> distance (n);
+  std::vector<uint32_t> via (n);
+  typedef std::pair<int64_t, uint32_t> QueueEntry;
+  int64_t flow = 0;
+  cost = 0;
+  while (true)
+    {
+      std::fill (distance.begin (), distance.end (), INF);
+      distance[source] = 0;
+      std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+      queue.push (QueueEntry (0, source));
+      while (!queue.empty ())
+        {
+          QueueEntry top = queue.top ();
+          queue.pop ();
+          uint32_t u = top.second;
+          if (top.first > distance[u])
+            {
+              continue;
+            }
+          for (std::size_t k = 0; k < m_adjacent[u].size (); k++)
+            {
+              uint32_t e = m_adjacent[u][k];
+              const Edge &edge = m_edges[e];
+              if (edge.capacity == 0)
+                {
+                  continue;
+                }
+              // reduced costs are never negative, so Dijkstra holds on the residual graph
+              int64_t d = distance[u] + edge.cost + potential[u] - potential[edge.to];
+              if (d < distance[edge.to])
+                {
+                  distance[edge.to] = d;
+                  via[edge.to] = e;
+                  queue.push (QueueEntry (d, edge.to));
+                }
+            }
+        }
+      if (distance[sink] == INF)
+        {
+          break;
+        }
+      for (uint32_t v = 0; v < n; v++)
+        {
+          if (distance[v] != INF)
+            {
+              potential[v] += distance[v];
+            }
+        }
+      int64_t push = INF;
+      for (uint32_t v = sink; v != source; v = m_edges[via[v] ^ 1].to)
+        {
+          push = std::min (push, m_edges[via[v]].capacity);
+        }
+      for (uint32_t v = sink; v != source; v = m_edges[via[v] ^ 1].to)
+        {
+          m_edges[via[v]].capacity -= push;
+          m_edges[via[v] ^ 1].capacity += push;
+          cost += push * m_edges[via[v]].cost;
+        }
+      flow += push;
+    }
+  return flow;
+}
+
+uint32_t
+BatchResult::GetAccepted (void) const
+{
+  return std::count (accepted.begin (), accepted.end (), true);
+}
+
+// capacities and flows are counted in kbit
+static const double UNITS_PER_MBIT = 1000;
+
+static double
+UsableTime (const BatchTask &task, const BatchLink &link)
+{
+  return std::max (0.0, std::min (task.deadline, link.lifetime));
+}
+
+/// Key of the interface a link sends over
+static uint32_t
+IfaceKey (const BatchLink &link)
+{
+  return link.node * 2 + link.iface;
+}
+
+/**
+ * Send the pieces of every interface one after the other at its rate,
+ * earliest due first, and set their start and duration.
+ */
+static void
+Sequence (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links, std::vector<BatchPiece> &pieces)
+{
+  std::vector<uint32_t> order (pieces.size ());
+  for (std::size_t p = 0; p < pieces.size (); p++)
+    {
+      order[p] = p;
+    }
+  std::stable_sort (order.begin (), order.end (), [&] (uint32_t a, uint32_t b)
+    {
+      return UsableTime (tasks[pieces[a].task], links[pieces[a].link]) < UsableTime (tasks[pieces[b].task], links[pieces[b].link]);
+    });
+  std::map<uint32_t, double> busy;
+  for (std::size_t o = 0; o < order.size (); o++)
+    {
+      BatchPiece &piece = pieces[order[o]];
+      const BatchLink &link = links[piece.link];
+      piece.start = busy[IfaceKey (link)];
+      piece.duration = piece.data / link.rate;
+      busy[IfaceKey (link)] = piece.start + piece.duration;
+    }
+}
+
+/**
+ * Mbit an interface sending at \p rate can still take with due time \p due,
+ * when the pieces it has taken, as (due time, Mbit), go out earliest due
+ * first: the data due by any later time must still fit before it.
+ */
+static double
+IfaceRoom (const std::vector<std::pair<double, double> > &taken, double rate, double due)
+{
+  double room = rate * due;
+  for (std::size_t i = 0; i <= taken.size (); i++)
+    {
+      double until = i < taken.size () ? taken[i].first : due;
+      if (until < due)
+        {
+          continue;
+        }
+      double load = 0;
+      for (std::size_t j = 0; j < taken.size (); j++)
+        {
+          if (taken[j].first <= until)
+            {
+              load += taken[j].second;
+            }
+        }
+      room = std::min (room, rate * until - load);
+    }
+  return std::max (0.0, room);
+}
+
+/**
+ * Solve the flow of the tasks marked in \p accepted.
+ * \returns the accepted task missing the largest share of its size, or -1
+ * when all of them are served whole; then the pieces are added to \p pieces
+ */
+static int32_t
+SolveAccepted (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links,
+               const std::vector<bool> &accepted, std::vector<BatchPiece> *pieces)
+{
+  // due times of the pieces each interface may carry, and its rate
+  std::map<uint32_t, std::vector<double> > dues;
+  std::map<uint32_t, double> ifaceRate;
+  for (std::size_t l = 0; l < links.size (); l++)
+    {
+      for (std::size_t t = 0; t < tasks.size (); t++)
+        {
+          if (accepted[t] && tasks[t].node == links[l].node && links[l].rate > 0 && UsableTime (tasks[t], links[l]) > 0)
+            {
+              dues[IfaceKey (links[l])].push_back (UsableTime (tasks[t], links[l]));
+              ifaceRate[IfaceKey (links[l])] = std::max (ifaceRate[IfaceKey (links[l])], links[l].rate);
+            }
+        }
+    }
+  // vertices: source, sink, tasks, then one per due time of every interface
+  std::map<uint32_t, uint32_t> firstDue;
+  uint32_t vertices = 2 + tasks.size ();
+  for (std::map<uint32_t, std::vector<double> >::iterator i = dues.begin (); i != dues.end (); ++i)
+    {
+      std::sort (i->second.begin (), i->second.end ());
+      i->second.erase (std::unique (i->second.begin (), i->second.end ()), i->second.end ());
+      firstDue[i->first] = vertices;
+      vertices += i->second.size ();
+    }
+  MinCostFlow graph (vertices);
+
+  std::vector<uint32_t> taskEdge (tasks.size ());
+  std::vector<int64_t> taskUnits (tasks.size (), 0);
+  for (std::size_t t = 0; t < tasks.size (); t++)
+    {
+      if (accepted[t])
+        {
+          taskUnits[t] = static_cast<int64_t> (std::ceil (tasks[t].size * UNITS_PER_MBIT));
+          taskEdge[t] = graph.AddEdge (0, 2 + t, taskUnits[t], 0);
+        }
+    }
+  std::vector<std::pair<uint32_t, uint32_t> > pieceTaskLink;
+  std::vector<uint32_t> pieceEdge;
+  for (std::size_t l = 0; l < links.size (); l++)
+    {
+      const BatchLink &link = links[l];
+      for (std::size_t t = 0; t < tasks.size (); t++)
+        {
+          double usable = UsableTime (tasks[t], link);
+          if (!accepted[t] || tasks[t].node != link.node || link.rate <= 0 || usable <= 0)
+            {
+              continue;
+            }
+          // seconds to spare if the whole task went over this link alone
+          double slack = std::max (0.0, usable - tasks[t].size / link.rate);
+          int64_t cost = static_cast<int64_t> (std::floor (1000 / (1 + slack)));
+          const std::vector<double> &due = dues[IfaceKey (link)];
+          uint32_t vertex = firstDue[IfaceKey (link)] + (std::lower_bound (due.begin (), due.end (), usable) - due.begin ());
+          pieceEdge.push_back (graph.AddEdge (2 + t, vertex, static_cast<int64_t> (link.rate * usable * UNITS_PER_MBIT), cost));
+          pieceTaskLink.push_back (std::make_pair (t, l));
+        }
+    }
+  // the flow leaving the k-th due time of an interface is the data due by then
+  for (std::map<uint32_t, std::vector<double> >::const_iterator i = dues.begin (); i != dues.end (); ++i)
+    {
+      for (std::size_t k = 0; k < i->second.size (); k++)
+        {
+          uint32_t next = k + 1 < i->second.size () ? firstDue[i->first] + k + 1 : 1;
+          graph.AddEdge (firstDue[i->first] + k, next, static_cast<int64_t> (ifaceRate[i->first] * i->second[k] * UNITS_PER_MBIT), 0);
+        }
+    }
+
+  int64_t cost;
+  graph.Solve (0, 1, cost);
+
+  int32_t worst = -1;
+  double worstMissing = 0;
+  for (std::size_t t = 0; t < tasks.size (); t++)
+    {
+      if (!accepted[t])
+        {
+          continue;
+        }
+      double missing = 1 - static_cast<double> (graph.GetFlow (taskEdge[t])) / taskUnits[t];
+      if (missing > worstMissing)
+        {
+          worst = t;
+          worstMissing = missing;
+        }
+    }
+  if (worst >= 0 || pieces == 0)
+    {
+      return worst;
+    }
+  for (std::size_t p = 0; p < pieceEdge.size (); p++)
+    {
+      int64_t flow = graph.GetFlow (pieceEdge[p]);
+      if (flow > 0)
+        {
+          BatchPiece piece;
+          piece.task = pieceTaskLink[p].first;
+          piece.link = pieceTaskLink[p].second;
+          piece.data = flow / UNITS_PER_MBIT;
+          piece.start = 0;
+          piece.duration = 0;
+          pieces->push_back (piece);
+        }
+    }
+  Sequence (tasks, links, *pieces);
+  return -1;
+}
+
+BatchResult
+BatchAllocator::Assign (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links)
+{
+  BatchResult result;
+  result.accepted.assign (tasks.size (), true);
+  int32_t worst;
+  while ((worst = SolveAccepted (tasks, links, result.accepted, 0)) >= 0)
+    {
+      result.accepted[worst] = false;
+    }
+  // dropping the worst task can free more than needed: give the dropped ones, smallest first, another try
+  std::vector<uint32_t> dropped;
+  for (std::size_t t = 0; t < tasks.size (); t++)
+    {
+      if (!result.accepted[t])
+        {
+          dropped.push_back (t);
+        }
+    }
+  std::stable_sort (dropped.begin (), dropped.end (),
+                    [&tasks] (uint32_t a, uint32_t b) { return tasks[a].size < tasks[b].size; });
+  for (std::size_t d = 0; d < dropped.size (); d++)
+    {
+      result.accepted[dropped[d]] = true;
+      if (SolveAccepted (tasks, links, result.accepted, 0) >= 0)
+        {
+          result.accepted[dropped[d]] = false;
+        }
+    }
+  SolveAccepted (tasks, links, result.accepted, &result.pieces);
+  return result;
+}
+
+BatchResult
+BatchAllocator::AssignGreedy (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links)
+{
+  BatchResult result;
+  result.accepted.assign (tasks.size (), false);
+  std::map<uint32_t, std::vector<std::pair<double, double> > > taken;
+
+  std::vector<uint32_t> order (tasks.size ());
+  for (std::size_t t = 0; t < tasks.size (); t++)
+    {
+      order[t] = t;
+    }
+  std::stable_sort (order.begin (), order.end (),
+                    [&tasks] (uint32_t a, uint32_t b) { return tasks[a].deadline < tasks[b].deadline; });
+
+  for (std::size_t o = 0; o < order.size (); o++)
+    {
+      uint32_t t = order[o];
+      const BatchTask &task = tasks[t];
+      // what each link could still take of this task
+      std::vector<double> room (links.size (), 0);
+      for (std::size_t l = 0; l < links.size (); l++)
+        {
+          const BatchLink &link = links[l];
+          if (link.node != task.node || link.rate <= 0)
+            {
+              continue;
+            }
+          room[l] = IfaceRoom (taken[IfaceKey (link)], link.rate, UsableTime (task, link));
+        }
+      int32_t first = -1, second = -1;
+      for (std::size_t l = 0; l < links.size () && first < 0; l++)
+        {
+          if (room[l] >= task.size)
+            {
+              first = l;
+            }
+        }
+      for (std::size_t l = 0; l < links.size () && first < 0; l++)
+        {
+          for (std::size_t m = 0; m < links.size (); m++)
+            {
+              if (links[m].node == links[l].node && links[m].neighbour == links[l].neighbour
+                  && links[m].iface != links[l].iface && room[l] >= room[m] && room[l] + room[m] >= task.size)
+                {
+                  first = l;
+                  second = m;
+                  break;
+                }
+            }
+        }
+      if (first < 0)
+        {
+          continue;
+        }
+      result.accepted[t] = true;
+      double left = task.size;
+      int32_t used[2] = {first, second};
+      for (uint32_t k = 0; k < 2 && used[k] >= 0; k++)
+        {
+          BatchPiece piece;
+          piece.task = t;
+          piece.link = used[k];
+          piece.data = std::min (left, room[used[k]]);
+          piece.start = 0;
+          piece.duration = 0;
+          left -= piece.data;
+          taken[IfaceKey (links[piece.link])].push_back (std::make_pair (UsableTime (task, links[piece.link]), piece.data));
+          result.pieces.push_back (piece);
+        }
+    }
+  Sequence (tasks, links, result.pieces);
+  return result;
+}
+
+} // namespace ns3
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * batch-allocator.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef BATCH_ALLOCATOR_H
+#define BATCH_ALLOCATOR_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Min-cost max-flow on integer capacities and costs.
+ *
+ * Successive shortest paths with Dijkstra on reduced costs; edge costs must
+ * not be negative. Each augmentation saturates at least one edge, so the
+ * small graphs of a batch of tasks are solved in a handful of passes.
+ */
+class MinCostFlow
+{
+public:
+  explicit MinCostFlow (uint32_t vertices);
+
+  /// \returns the id of the new edge, for GetFlow
+  uint32_t AddEdge (uint32_t from, uint32_t to, int64_t capacity, int64_t cost);
+  /**
+   * Push as much flow as possible from \p source to \p sink at the lowest cost.
+   * \param cost set to the total cost of the flow
+   * \returns the flow pushed
+   */
+  int64_t Solve (uint32_t source, uint32_t sink, int64_t &cost);
+  /// \returns the flow through edge \p edge after Solve
+  int64_t GetFlow (uint32_t edge) const;
+
+private:
+  struct Edge
+  {
+    uint32_t to;
+    int64_t capacity;  //!< residual capacity
+    int64_t cost;
+  };
+
+  std::vector<Edge> m_edges;  //!< edge 2k is the k-th added edge, 2k+1 its reverse
+  std::vector<std::vector<uint32_t> > m_adjacent;
+};
+
+/// A task waiting in a batch
+struct BatchTask
+{
+  uint32_t taskId;
+  uint32_t node;      //!< node the task is offloaded from
+  double size;        //!< Mbit
+  double deadline;    //!< seconds from now
+};
+
+/// A link a node can send over
+struct BatchLink
+{
+  uint32_t node;      //!< sending node
+  uint32_t neighbour; //!< the neighbour node, the same for its Wi-Fi and Wi-Fi Direct links
+  uint8_t iface;      //!< 0 Wi-Fi, 1 Wi-Fi Direct
+  double rate;        //!< Mbps available on the interface of the node
+  double lifetime;    //!< predicted seconds before the link breaks
+};
+
+/// Part of a task sent over one link
+struct BatchPiece
+{
+  uint32_t task;      //!< index in the tasks
+  uint32_t link;      //!< index in the links
+  double data;        //!< Mbit
+  double start;       //!< seconds from now the piece starts, once the earlier pieces of its interface are sent
+  double duration;    //!< seconds the piece takes at the rate of its link
+};
+
+struct BatchResult
+{
+  std::vector<bool> accepted;      //!< indexed like the tasks
+  std::vector<BatchPiece> pieces;  //!< pieces of the accepted tasks
+  uint32_t GetAccepted (void) const;
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief Assigns a batch of tasks to the links of their nodes at once.
+ *
+ * Both assignments use the same model: a piece is due by the time its link
+ * can be used for its task (the task deadline or the link lifetime,
+ * whichever is shorter), and the pieces of one interface are sent one after
+ * the other at its rate, earliest due first. This is feasible as long as,
+ * for every due time, the pieces due by then fit in the rate times that
+ * time; the start of every piece follows from that order.
+ *
+ * Assign solves a min-cost max-flow from the tasks to a chain of vertices per
+ * interface, one per due time, whose edges bound the data due up to each
+ * time. The cost of a Mbit on a link falls with the slack the link
+ * leaves before the task deadline, so bytes go to fast, long lived links
+ * first. Only whole tasks are accepted: while some task is partly served,
+ * the one missing the largest share of its size is dropped and the flow
+ * solved again.
+ *
+ * AssignGreedy mirrors the allocator of manet-routing-compare: tasks in
+ * deadline order, each placed whole on one link or split between the Wi-Fi
+ * and Wi-Fi Direct links of one neighbour, first fit. It is the baseline of
+ * the batch-allocation-benchmark example.
+ */
+class BatchAllocator
+{
+public:
+  static BatchResult Assign (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links);
+  static BatchResult AssignGreedy (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links);
+};
+
+} // namespace ns3
+
+#endif /* BATCH_ALLOCATOR_H */
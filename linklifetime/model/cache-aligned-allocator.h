@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * cache-aligned-allocator.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef CACHE_ALIGNED_ALLOCATOR_H
+#define CACHE_ALIGNED_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace ns3 {
+
+/// Size of a cache line on the targets we run on
+static const std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * \ingroup linklifetime
+ * \brief Allocator returning storage aligned to a cache line.
+ *
+ * Before C++17 std::allocator ignores the alignment of over-aligned types,
+ * so a std::vector of alignas(64) structs may start in the middle of a
+ * cache line and neighbouring elements would then share one. Use this
+ * allocator for per node state that is meant to sit on its own line.
+ */
+template <typename T>
+class CacheAlignedAllocator
+{
+public:
+  typedef T value_type;
+
+  CacheAlignedAllocator ()
+  {
+  }
+  template <typename U>
+  CacheAlignedAllocator (const CacheAlignedAllocator<U> &)
+  {
+  }
+
+  T * allocate (std::size_t n)
+  {
+    void *p = 0;
+    std::size_t alignment = alignof (T) > CACHE_LINE_SIZE ? alignof (T) : CACHE_LINE_SIZE;
+    if (posix_memalign (&p, alignment, n * sizeof (T)) != 0)
+      {
+        throw std::bad_alloc ();
+      }
+    return static_cast<T *> (p);
+  }
+  void deallocate (T *p, std::size_t)
+  {
+    std::free (p);
+  }
+
+  template <typename U>
+  struct rebind
+  {
+    typedef CacheAlignedAllocator<U> other;
+  };
+};
+
+template <typename T, typename U>
+bool operator== (const CacheAlignedAllocator<T> &, const CacheAlignedAllocator<U> &)
+{
+  return true;
+}
+template <typename T, typename U>
+bool operator!= (const CacheAlignedAllocator<T> &, const CacheAlignedAllocator<U> &)
+{
+  return false;
+}
+
+} // namespace ns3
+
+#endif /* CACHE_ALIGNED_ALLOCATOR_H */
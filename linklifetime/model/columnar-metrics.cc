@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * columnar-metrics.cc
+ *
+ *      Author: hassam
+ */
+
+#include "columnar-metrics.h"
+#include <cstring>
+#include <iterator>
+
+namespace ns3 {
+
+static const char COLUMNAR_MAGIC[4] = {'L', 'L', 'M', 'C'};
+static const uint16_t COLUMNAR_VERSION = 1;
+static const std::size_t COLUMNAR_TRAILER_SIZE = 16;
+
+/// How the values of a column chunk are stored
+enum ColumnarEncoding
+{
+  COLUMNAR_PLAIN = 0,    //!< one fixed-width value per row
+  COLUMNAR_CONSTANT = 1  //!< a single 8 byte value shared by every row
+};
+
+static void
+PutLe (std::string &out, uint64_t value, uint32_t width)
+{
+  for (uint32_t i = 0; i < width; i++)
+    {
+      out += static_cast<char> ((value >> (8 * i)) & 0xff);
+    }
+}
+
+static uint64_t
+GetLe (const std::string &in, std::size_t pos, uint32_t width)
+{
+  uint64_t value = 0;
+  for (uint32_t i = 0; i < width; i++)
+    {
+      value |= static_cast<uint64_t> (static_cast<uint8_t> (in[pos + i])) << (8 * i);
+    }
+  return value;
+}
+
+static void
+PadTo8 (std::string &out, uint64_t written)
+{
+  while (written % 8 != 0)
+    {
+      out += '\0';
+      written++;
+    }
+}
+
+static uint64_t
+DoubleBits (double d)
+{
+  uint64_t bits;
+  std::memcpy (&bits, &d, sizeof (bits));
+  return bits;
+}
+
+static double
+BitsDouble (uint64_t bits)
+{
+  double d;
+  std::memcpy (&d, &bits, sizeof (d));
+  return d;
+}
+
+static uint32_t
+FloatBits (float f)
+{
+  uint32_t bits;
+  std::memcpy (&bits, &f, sizeof (bits));
+  return bits;
+}
+
+static float
+BitsFloat (uint32_t bits)
+{
+  float f;
+  std::memcpy (&f, &bits, sizeof (f));
+  return f;
+}
+
+ColumnarMetricsOutput::ColumnarMetricsOutput (const std::string &path, const MetricsSchema &schema,
+                                              uint32_t rowGroupSize, bool singlePrecision)
+  : MetricsOutput (path, schema),
+    m_rowGroupSize (rowGroupSize == 0 ? 1 : rowGroupSize),
+    m_singlePrecision (singlePrecision),
+    m_rows (0),
+    m_columns (schema.size ()),
+    m_written (0)
+{
+  m_buffer.append (COLUMNAR_MAGIC, sizeof (COLUMNAR_MAGIC));
+  PutLe (m_buffer, COLUMNAR_VERSION, 2);
+  PutLe (m_buffer, m_schema.size (), 2);
+  for (std::size_t c = 0; c < m_schema.size (); c++)
+    {
+      std::string name = m_schema[c].name.substr (0, 255);
+      PutLe (m_buffer, m_schema[c].type, 1);
+      PutLe (m_buffer, name.size (), 1);
+      m_buffer += name;
+    }
+  PadTo8 (m_buffer, m_buffer.size ());
+  m_written = m_buffer.size ();
+  for (std::size_t c = 0; c < m_columns.size (); c++)
+    {
+      m_columns[c].reserve (m_rowGroupSize);
+    }
+}
+
+void
+ColumnarMetricsOutput::Format (const MetricsRecord &record)
+{
+  for (uint16_t c = 0; c < m_columns.size (); c++)
+    {
+      uint64_t bits = 0;
+      if (c < record.GetSize () && c < MetricsRecord::MAX_COLUMNS)
+        {
+          bits = m_schema[c].type == METRICS_U64 ? record.GetU64 (c) : DoubleBits (record.GetF64 (c));
+        }
+      m_columns[c].push_back (bits);
+    }
+  if (++m_rows == m_rowGroupSize)
+    {
+      EncodeRowGroup ();
+    }
+}
+
+void
+ColumnarMetricsOutput::EncodeRowGroup (void)
+{
+  if (m_rows == 0)
+    {
+      return;
+    }
+  m_groupOffsets.push_back (m_written);
+  m_groupRows.push_back (m_rows);
+  std::size_t start = m_buffer.size ();
+  PutLe (m_buffer, m_rows, 4);
+  PutLe (m_buffer, m_columns.size (), 4);
+  for (std::size_t c = 0; c < m_columns.size (); c++)
+    {
+      const std::vector<uint64_t> &values = m_columns[c];
+      bool constant = true;
+      uint64_t maxValue = 0;
+      bool fitsFloat = true;
+      for (uint32_t r = 0; r < m_rows; r++)
+        {
+          constant = constant && values[r] == values[0];
+          maxValue = std::max (maxValue, values[r]);
+          if (m_schema[c].type == METRICS_F64 && !m_singlePrecision)
+            {
+              double d = BitsDouble (values[r]);
+              fitsFloat = fitsFloat && static_cast<double> (static_cast<float> (d)) == d;
+            }
+        }
+      if (constant)
+        {
+          PutLe (m_buffer, COLUMNAR_CONSTANT, 1);
+          PutLe (m_buffer, 8, 1);
+          PutLe (m_buffer, 0, 6);
+          PutLe (m_buffer, values[0], 8);
+          continue;
+        }
+      uint32_t width = 8;
+      if (m_schema[c].type == METRICS_F64)
+        {
+          width = m_singlePrecision || fitsFloat ? 4 : 8;
+        }
+      else if (maxValue <= 0xff)
+        {
+          width = 1;
+        }
+      else if (maxValue <= 0xffff)
+        {
+          width = 2;
+        }
+      else if (maxValue <= 0xffffffff)
+        {
+          width = 4;
+        }
+      PutLe (m_buffer, COLUMNAR_PLAIN, 1);
+      PutLe (m_buffer, width, 1);
+      PutLe (m_buffer, 0, 6);
+      for (uint32_t r = 0; r < m_rows; r++)
+        {
+          uint64_t v = values[r];
+          if (m_schema[c].type == METRICS_F64 && width == 4)
+            {
+              v = FloatBits (static_cast<float> (BitsDouble (v)));
+            }
+          PutLe (m_buffer, v, width);
+        }
+      PadTo8 (m_buffer, m_written + m_buffer.size () - start);
+    }
+  m_written += m_buffer.size () - start;
+
+  for (std::size_t c = 0; c < m_columns.size (); c++)
+    {
+      m_columns[c].clear ();
+    }
+  m_rows = 0;
+}
+
+void
+ColumnarMetricsOutput::Finish (void)
+{
+  EncodeRowGroup ();
+  uint64_t footerOffset = m_written;
+  for (std::size_t g = 0; g < m_groupOffsets.size (); g++)
+    {
+      PutLe (m_buffer, m_groupOffsets[g], 8);
+      PutLe (m_buffer, m_groupRows[g], 4);
+      PutLe (m_buffer, 0, 4);
+    }
+  PutLe (m_buffer, footerOffset, 8);
+  PutLe (m_buffer, m_groupOffsets.size (), 4);
+  m_buffer.append (COLUMNAR_MAGIC, sizeof (COLUMNAR_MAGIC));
+  MetricsOutput::Finish ();
+}
+
+ColumnarMetricsReader::ColumnarMetricsReader ()
+{
+}
+
+bool
+ColumnarMetricsReader::Open (const std::string &path)
+{
+  m_schema.clear ();
+  m_groupOffsets.clear ();
+  m_groupRows.clear ();
+
+  std::ifstream in (path.c_str (), std::ios::in | std::ios::binary);
+  if (!in)
+    {
+      return false;
+    }
+  m_data.assign (std::istreambuf_iterator<char> (in), std::istreambuf_iterator<char> ());
+  if (m_data.size () < 8 + COLUMNAR_TRAILER_SIZE
+      || m_data.compare (0, 4, COLUMNAR_MAGIC, 4) != 0
+      || m_data.compare (m_data.size () - 4, 4, COLUMNAR_MAGIC, 4) != 0
+      || GetLe (m_data, 4, 2) != COLUMNAR_VERSION)
+    {
+      return false;
+    }
+
+  uint32_t nColumns = GetLe (m_data, 6, 2);
+  std::size_t pos = 8;
+  for (uint32_t c = 0; c < nColumns; c++)
+    {
+      if (pos + 2 > m_data.size ())
+        {
+          return false;
+        }
+      MetricsColumn column;
+      column.type = static_cast<MetricsType> (GetLe (m_data, pos, 1));
+      uint32_t length = GetLe (m_data, pos + 1, 1);
+      pos += 2;
+      if (pos + length > m_data.size ())
+        {
+          return false;
+        }
+      column.name = m_data.substr (pos, length);
+      pos += length;
+      m_schema.push_back (column);
+    }
+
+  std::size_t trailer = m_data.size () - COLUMNAR_TRAILER_SIZE;
+  uint64_t footerOffset = GetLe (m_data, trailer, 8);
+  uint32_t nGroups = GetLe (m_data, trailer + 8, 4);
+  if (footerOffset + 16 * static_cast<uint64_t> (nGroups) != trailer)
+    {
+      return false;
+    }
+  for (uint32_t g = 0; g < nGroups; g++)
+    {
+      m_groupOffsets.push_back (GetLe (m_data, footerOffset + 16 * g, 8));
+      m_groupRows.push_back (GetLe (m_data, footerOffset + 16 * g + 8, 4));
+    }
+  return true;
+}
+
+uint64_t
+ColumnarMetricsReader::GetRowCount (void) const
+{
+  uint64_t rows = 0;
+  for (std::size_t g = 0; g < m_groupRows.size (); g++)
+    {
+      rows += m_groupRows[g];
+    }
+  return rows;
+}
+
+bool
+ColumnarMetricsReader::ReadRowGroup (uint32_t group, std::vector<MetricsRecord> &rows) const
+{
+  if (group >= m_groupOffsets.size ())
+    {
+      return false;
+    }
+  std::size_t pos = m_groupOffsets[group];
+  if (pos + 8 > m_data.size ())
+    {
+      return false;
+    }
+  uint32_t nRows = GetLe (m_data, pos, 4);
+  if (nRows != m_groupRows[group] || GetLe (m_data, pos + 4, 4) != m_schema.size ())
+    {
+      return false;
+    }
+  pos += 8;
+  rows.assign (nRows, MetricsRecord ());
+
+  for (std::size_t c = 0; c < m_schema.size (); c++)
+    {
+      if (pos + 8 > m_data.size ())
+        {
+          return false;
+        }
+      uint32_t encoding = GetLe (m_data, pos, 1);
+      uint32_t width = GetLe (m_data, pos + 1, 1);
+      pos += 8;
+      uint64_t count = encoding == COLUMNAR_CONSTANT ? 1 : nRows;
+      if ((width != 1 && width != 2 && width != 4 && width != 8)
+          || pos + count * width > m_data.size ())
+        {
+          return false;
+        }
+      for (uint32_t r = 0; r < nRows; r++)
+        {
+          uint64_t v = GetLe (m_data, encoding == COLUMNAR_CONSTANT ? pos : pos + r * width, width);
+          if (m_schema[c].type == METRICS_U64)
+            {
+              rows[r] << v;
+            }
+          else if (width == 4)
+            {
+              rows[r] << static_cast<double> (BitsFloat (v));
+            }
+          else
+            {
+              rows[r] << BitsDouble (v);
+            }
+        }
+      pos += count * width;
+      pos += (8 - pos % 8) % 8;
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * columnar-metrics.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef COLUMNAR_METRICS_H
+#define COLUMNAR_METRICS_H
+
+#include "metrics-sink.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Columnar binary output of a MetricsSink.
+ *
+ * Rows are collected into row groups; every column of a group is written as
+ * one contiguous, 8 byte aligned chunk of fixed-width little-endian values.
+ * A chunk whose values are all equal is stored as a single constant, and
+ * integer chunks use the narrowest width (1, 2, 4 or 8 bytes) that holds
+ * their largest value. A footer indexes the row groups, so a reader can
+ * memory-map the file and jump straight to any column of any group. The
+ * layout is described in the module documentation.
+ *
+ * With \p singlePrecision, floating point columns are always stored as
+ * 32 bit floats. They keep about seven significant digits, more than the six
+ * the CSV output prints, and halve the size of those columns.
+ *
+ * Only complete row groups reach the file before Finish (), so
+ * MetricsSink::Flush persists everything but the group being filled.
+ */
+class ColumnarMetricsOutput : public MetricsOutput
+{
+public:
+  /**
+   * \param path file to create
+   * \param schema columns of every row
+   * \param rowGroupSize number of rows per row group
+   * \param singlePrecision store floating point columns as 32 bit floats
+   */
+  ColumnarMetricsOutput (const std::string &path, const MetricsSchema &schema,
+                         uint32_t rowGroupSize = 1024, bool singlePrecision = false);
+
+  virtual void Format (const MetricsRecord &record);
+  virtual void Finish (void);
+
+private:
+  /// Encode the buffered rows as one row group
+  void EncodeRowGroup (void);
+
+  uint32_t m_rowGroupSize;
+  bool m_singlePrecision;
+  uint32_t m_rows;                              //!< rows in the current group
+  std::vector<std::vector<uint64_t> > m_columns; //!< raw bits of the current group, per column
+  std::vector<uint64_t> m_groupOffsets;         //!< file offset of every row group
+  std::vector<uint32_t> m_groupRows;            //!< number of rows of every row group
+  uint64_t m_written;                           //!< bytes produced so far
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief Reader for files written by ColumnarMetricsOutput.
+ */
+class ColumnarMetricsReader
+{
+public:
+  ColumnarMetricsReader ();
+
+  /**
+   * Load \p path and check its header and footer.
+   * \returns false if the file cannot be read or is not a metrics file
+   */
+  bool Open (const std::string &path);
+
+  const MetricsSchema & GetSchema (void) const
+  {
+    return m_schema;
+  }
+  uint32_t GetRowGroupCount (void) const
+  {
+    return m_groupOffsets.size ();
+  }
+  /// \returns the total number of rows in the file
+  uint64_t GetRowCount (void) const;
+
+  /**
+   * Decode row group \p group into \p rows, replacing their contents.
+   * \returns false if the group is out of range or malformed
+   */
+  bool ReadRowGroup (uint32_t group, std::vector<MetricsRecord> &rows) const;
+
+private:
+  std::string m_data;
+  MetricsSchema m_schema;
+  std::vector<uint64_t> m_groupOffsets;
+  std::vector<uint32_t> m_groupRows;
+};
+
+} // namespace ns3
+
+#endif /* COLUMNAR_METRICS_H */
@@ -14,6 +14,7 @@
 #include "ns3/ipv4.h"
 #include "ns3/markovchain-mobility-model.h"
 #include "ns3/reply-packet-header.h"
+#include "ns3/traffic-class-tag.h"
 #include "ns3/log.h"
 
 namespace ns3{
@@ -92,6 +93,7 @@ DiscoveryApplication::SendReplyPacketW(Ptr<Node> currNode, Ipv4Address source, I
     replySocket->Connect(InetSocketAddress(dest, 9));
     Ptr<Packet> packet = Create<Packet> (packetSize);
     packet->AddHeader(header);
+    packet->AddPacketTag(TrafficClassTag(TrafficClassTag::REPLY, 0, TrafficClassTag::IFACE_W));
     replySocket->Send(packet);
     replySocket->Close();
     NS_LOG_DEBUG("Sending Reply Packet W");
@@ -114,6 +116,7 @@ DiscoveryApplication::SendReplyPacketWD(Ptr<Node> currNode, Ipv4Address source,
     replySocket->Connect(InetSocketAddress(dest, 80));
     Ptr<Packet> packet = Create<Packet> (packetSize);
     packet->AddHeader(header);
+    packet->AddPacketTag(TrafficClassTag(TrafficClassTag::REPLY, 0, TrafficClassTag::IFACE_WD));
     replySocket->Send(packet);
     replySocket->Close();
     NS_LOG_DEBUG("Sending Reply Packet WD");
@@ -215,6 +218,8 @@ DiscoveryApplication::SendDiscoveryPacket (void)
 
     packet1->AddHeader(header1);
     packet2->AddHeader(header2);
+    packet1->AddPacketTag(TrafficClassTag(TrafficClassTag::DISCOVERY, 0, TrafficClassTag::IFACE_W));
+    packet2->AddPacketTag(TrafficClassTag(TrafficClassTag::DISCOVERY, 0, TrafficClassTag::IFACE_WD));
     int a = packet1->GetSize();
     NS_LOG_DEBUG("Packet Size: " << a);
     //GetDataRate(packet);
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * event-trace.cc
+ *
+ *      Author: hassam
+ */
+
+#include "event-trace.h"
+#include <algorithm>
+
+namespace ns3 {
+
+static_assert (sizeof (EventRecord) == 32, "EventRecord is written to disk as is");
+
+static const char EVENT_TRACE_MAGIC[4] = {'L', 'L', 'E', 'T'};
+static const uint16_t EVENT_TRACE_VERSION = 1;
+
+EventTrace::EventTrace (uint32_t capacity)
+  : m_ring (capacity == 0 ? 1 : capacity),
+    m_next (0),
+    m_used (0),
+    m_keepLast (false),
+    m_enabled (false)
+{
+}
+
+EventTrace::~EventTrace ()
+{
+  Close ();
+}
+
+bool
+EventTrace::Open (const std::string &path, bool keepLast)
+{
+  Close ();
+  m_stream.open (path.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!m_stream)
+    {
+      return false;
+    }
+  uint16_t version = EVENT_TRACE_VERSION;
+  uint16_t recordSize = sizeof (EventRecord);
+  uint64_t reserved = 0;
+  m_stream.write (EVENT_TRACE_MAGIC, sizeof (EVENT_TRACE_MAGIC));
+  m_stream.write (reinterpret_cast<const char *> (&version), sizeof (version));
+  m_stream.write (reinterpret_cast<const char *> (&recordSize), sizeof (recordSize));
+  m_stream.write (reinterpret_cast<const char *> (&reserved), sizeof (reserved));
+  m_keepLast = keepLast;
+  m_next = 0;
+  m_used = 0;
+  m_enabled = true;
+  return true;
+}
+
+void
+EventTrace::WriteOut (void)
+{
+  // the oldest event sits m_used slots behind m_next
+  uint32_t first = (m_next + m_ring.size () - m_used) % m_ring.size ();
+  uint32_t tail = std::min<uint32_t> (m_used, m_ring.size () - first);
+  m_stream.write (reinterpret_cast<const char *> (&m_ring[first]), tail * sizeof (EventRecord));
+  m_stream.write (reinterpret_cast<const char *> (&m_ring[0]), (m_used - tail) * sizeof (EventRecord));
+  m_used = 0;
+}
+
+void
+EventTrace::Close (void)
+{
+  if (!m_enabled)
+    {
+      return;
+    }
+  WriteOut ();
+  m_stream.close ();
+  m_enabled = false;
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * event-trace.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include "ns3/simulator.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Kinds of events written to an EventTrace.
+ */
+enum EventTraceType
+{
+  EVENT_APP_RX = 1,         //!< application packet received; arg task id, value latency in s
+  EVENT_DISCOVERY_RX = 2,   //!< discovery received; arg source IPv4 address
+  EVENT_ROUTE_ADDED = 3,    //!< route added; arg neighbour IPv4 address
+  EVENT_ROUTE_UPDATED = 4,  //!< route refreshed; arg neighbour IPv4 address, value time connected in s
+  EVENT_TASK_ALLOCATED = 5, //!< task placed; arg task id, value predicted transfer time in s
+  EVENT_TASK_REJECTED = 6,  //!< task could not be placed; arg task id, value deadline in s
+  EVENT_TRANSFER_COMPLETE = 7, //!< last byte of a task piece sent; arg task id, value throughput in Mbps
+  EVENT_QUEUE_DEPTH = 8,    //!< task queue of the node changed; arg task id, value tasks queued
+  EVENT_TASK_STOLEN = 9,    //!< node took over a queued task of a neighbour; arg task id, value node id of the neighbour
+  EVENT_TRANSFER_MIGRATED = 10, //!< rest of a transfer moved off a broken link; arg task id, value deadline slack used in s
+  EVENT_TASK_EXECUTED = 11  //!< part of a task queued on the CPU of the node; arg task id, value seconds until it has run
+};
+
+/**
+ * \brief One fixed-size event, written to the file as is.
+ */
+struct EventRecord
+{
+  int64_t time;      //!< simulation time in ns
+  uint32_t node;
+  uint16_t type;     //!< one of EventTraceType
+  uint8_t iface;     //!< 0 Wi-Fi, 1 Wi-Fi Direct
+  uint8_t reserved;
+  uint64_t arg;
+  double value;
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief Binary trace of the few events that are analysed after a run.
+ *
+ * Record () copies one 32 byte EventRecord into a preallocated ring and
+ * does nothing else, so it is cheap enough for per-packet paths and costs a
+ * single branch while the trace is not open. By default the ring is written
+ * out whenever it fills up; with \p keepLast only the most recent
+ * \p capacity events are kept and written on Close (), like a flight
+ * recorder. The file layout is described in the module documentation.
+ */
+class EventTrace
+{
+public:
+  /**
+   * \param capacity number of events the ring holds
+   */
+  EventTrace (uint32_t capacity = 65536);
+  ~EventTrace ();
+
+  /**
+   * Create \p path and start recording.
+   * \param keepLast keep only the last events instead of writing them all
+   * \returns false if the file cannot be created
+   */
+  bool Open (const std::string &path, bool keepLast = false);
+
+  bool IsEnabled (void) const
+  {
+    return m_enabled;
+  }
+
+  void Record (EventTraceType type, uint32_t node, uint8_t iface, uint64_t arg, double value)
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    if (m_used == m_ring.size () && !m_keepLast)
+      {
+        WriteOut ();
+      }
+    EventRecord &r = m_ring[m_next];
+    r.time = Simulator::Now ().GetNanoSeconds ();
+    r.node = node;
+    r.type = type;
+    r.iface = iface;
+    r.reserved = 0;
+    r.arg = arg;
+    r.value = value;
+    m_next = m_next + 1 == m_ring.size () ? 0 : m_next + 1;
+    if (m_used < m_ring.size ())
+      {
+        m_used++;
+      }
+  }
+
+  /// Write what the ring holds and close the file. Safe to call more than once.
+  void Close (void);
+
+private:
+  void WriteOut (void);
+
+  std::vector<EventRecord> m_ring;
+  uint32_t m_next;   //!< slot the next event goes to
+  uint32_t m_used;   //!< events in the ring
+  bool m_keepLast;
+  bool m_enabled;
+  std::ofstream m_stream;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_TRACE_H */
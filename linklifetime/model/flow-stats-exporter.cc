@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * flow-stats-exporter.cc
+ *
+ *      Author: hassam
+ */
+
+#include "flow-stats-exporter.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+
+namespace ns3 {
+
+FlowStatsExporter::FlowStatsExporter (Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier,
+                                      Time interval, Time retireAfter)
+  : m_monitor (monitor),
+    m_classifier (classifier),
+    m_interval (interval),
+    m_retireAfter (retireAfter),
+    m_sink (0),
+    m_handle (0)
+{
+}
+
+MetricsSchema
+FlowStatsExporter::GetSchema (void)
+{
+  static const MetricsColumn columns[] = {
+    {"SimulationSecond", METRICS_F64},
+    {"FlowId", METRICS_U64},
+    {"SourceAddress", METRICS_U64},
+    {"DestinationAddress", METRICS_U64},
+    {"SourcePort", METRICS_U64},
+    {"DestinationPort", METRICS_U64},
+    {"Protocol", METRICS_U64},
+    {"TxBytes", METRICS_U64},
+    {"RxBytes", METRICS_U64},
+    {"TxPackets", METRICS_U64},
+    {"RxPackets", METRICS_U64},
+    {"LostPackets", METRICS_U64},
+    {"DelaySum", METRICS_F64}
+  };
+  return MetricsSchema (columns, columns + sizeof (columns) / sizeof (columns[0]));
+}
+
+void
+FlowStatsExporter::SetCompactMonitor (Ptr<FlowMonitor> monitor)
+{
+  // one bin wider than any value the histograms could see
+  monitor->SetAttribute ("DelayBinWidth", DoubleValue (1e9));
+  monitor->SetAttribute ("JitterBinWidth", DoubleValue (1e9));
+  monitor->SetAttribute ("PacketSizeBinWidth", DoubleValue (1e9));
+  monitor->SetAttribute ("FlowInterruptionsBinWidth", DoubleValue (1e9));
+}
+
+void
+FlowStatsExporter::Start (MetricsSink *sink, MetricsSink::Handle handle)
+{
+  m_sink = sink;
+  m_handle = handle;
+  Simulator::Schedule (m_interval, &FlowStatsExporter::Export, this);
+}
+
+void
+FlowStatsExporter::Export (void)
+{
+  DoExport ();
+  Simulator::Schedule (m_interval, &FlowStatsExporter::Export, this);
+}
+
+void
+FlowStatsExporter::Finish (void)
+{
+  DoExport ();
+}
+
+void
+FlowStatsExporter::DoExport (void)
+{
+  m_monitor->CheckForLostPackets ();
+  Time now = Simulator::Now ();
+  const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats ();
+  for (FlowMonitor::FlowStatsContainerCI i = stats.begin (); i != stats.end (); ++i)
+    {
+      FlowId id = i->first;
+      const FlowMonitor::FlowStats &flow = i->second;
+      std::map<FlowId, FlowState>::iterator it = m_flows.find (id);
+      if (it == m_flows.end ())
+        {
+          // new flows start from zero, retired ones from their last counters
+          FlowCounters last = id < m_retired.size () ? m_retired[id] : FlowCounters ();
+          if (flow.txBytes == last.txBytes && flow.rxBytes == last.rxBytes && flow.lostPackets == last.lostPackets)
+            {
+              continue;
+            }
+          FlowState state;
+          state.tuple = m_classifier->FindFlow (id);
+          state.counters = last;
+          state.lastChange = now;
+          it = m_flows.insert (std::make_pair (id, state)).first;
+        }
+      FlowState &state = it->second;
+      FlowCounters &counters = state.counters;
+      if (flow.txBytes == counters.txBytes && flow.rxBytes == counters.rxBytes && flow.lostPackets == counters.lostPackets)
+        {
+          if (now - state.lastChange >= m_retireAfter)
+            {
+              if (id >= m_retired.size ())
+                {
+                  m_retired.resize (id + 1, FlowCounters ());
+                }
+              m_retired[id] = counters;
+              m_flows.erase (it);
+            }
+          continue;
+        }
+
+      if (m_sink != 0)
+        {
+          m_row.Clear ();
+          m_row << now.GetSeconds ()
+                << id
+                << state.tuple.sourceAddress.Get ()
+                << state.tuple.destinationAddress.Get ()
+                << state.tuple.sourcePort
+                << state.tuple.destinationPort
+                << state.tuple.protocol
+                << flow.txBytes - counters.txBytes
+                << flow.rxBytes - counters.rxBytes
+                << flow.txPackets - counters.txPackets
+                << flow.rxPackets - counters.rxPackets
+                << flow.lostPackets - counters.lostPackets
+                << (flow.delaySum.GetNanoSeconds () - counters.delaySum) / 1e9;
+          m_sink->Append (m_handle, m_row);
+        }
+      counters.txBytes = flow.txBytes;
+      counters.rxBytes = flow.rxBytes;
+      counters.txPackets = flow.txPackets;
+      counters.rxPackets = flow.rxPackets;
+      counters.lostPackets = flow.lostPackets;
+      counters.delaySum = flow.delaySum.GetNanoSeconds ();
+      state.lastChange = now;
+    }
+}
+
+} // namespace ns3
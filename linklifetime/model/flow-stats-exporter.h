@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * flow-stats-exporter.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef FLOW_STATS_EXPORTER_H
+#define FLOW_STATS_EXPORTER_H
+
+#include "metrics-sink.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/nstime.h"
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Streams periodic per-flow deltas of a FlowMonitor to a MetricsSink.
+ *
+ * Every interval, the exporter writes one row for each flow whose counters
+ * changed since the previous pass. The row holds the growth of its tx/rx
+ * bytes and packets, lost packets and delay sum, so the totals of a flow
+ * are the sum of its rows. Paired with a ColumnarMetricsOutput the rows
+ * take a few bytes per column.
+ *
+ * A flow that has not changed for \p retireAfter is retired: only its last
+ * counters are kept, in a vector indexed by FlowId, and the flow is tracked
+ * again with the delta since then once they move. FlowMonitor itself
+ * has no way to forget a flow, so its own records keep growing with the
+ * number of flows; see SetCompactMonitor for keeping them small.
+ */
+class FlowStatsExporter
+{
+public:
+  /**
+   * \param monitor flow monitor to read
+   * \param classifier classifier of \p monitor, for the five-tuple of every flow
+   * \param interval time between two passes
+   * \param retireAfter idle time after which a flow is retired
+   */
+  FlowStatsExporter (Ptr<FlowMonitor> monitor, Ptr<Ipv4FlowClassifier> classifier,
+                     Time interval, Time retireAfter);
+
+  /// \returns the columns of the rows written by the exporter
+  static MetricsSchema GetSchema (void);
+
+  /**
+   * Shrink the delay, jitter, packet size and interruption histograms the
+   * monitor keeps for every flow to a single bin. Only use it when the
+   * histograms are not needed, i.e. without the final XML file.
+   */
+  static void SetCompactMonitor (Ptr<FlowMonitor> monitor);
+
+  /// Write the rows to \p handle of \p sink and schedule the first pass
+  void Start (MetricsSink *sink, MetricsSink::Handle handle);
+
+  /// Write the deltas since the last pass, e.g. at the end of the run
+  void Finish (void);
+
+  /// \returns the number of flows currently tracked
+  uint32_t GetTrackedFlows (void) const
+  {
+    return m_flows.size ();
+  }
+
+private:
+  /// Periodic pass, reschedules itself
+  void Export (void);
+  void DoExport (void);
+
+  /// Counters of a flow at the previous pass
+  struct FlowCounters
+  {
+    uint64_t txBytes;
+    uint64_t rxBytes;
+    uint32_t txPackets;
+    uint32_t rxPackets;
+    uint32_t lostPackets;
+    int64_t delaySum;   //!< in ns
+  };
+
+  /// A flow being tracked
+  struct FlowState
+  {
+    Ipv4FlowClassifier::FiveTuple tuple; //!< looked up once, FindFlow is a linear search
+    FlowCounters counters;
+    Time lastChange;
+  };
+
+  Ptr<FlowMonitor> m_monitor;
+  Ptr<Ipv4FlowClassifier> m_classifier;
+  Time m_interval;
+  Time m_retireAfter;
+  MetricsSink *m_sink;
+  MetricsSink::Handle m_handle;
+  std::map<FlowId, FlowState> m_flows; //!< flows being tracked
+  std::vector<FlowCounters> m_retired; //!< last counters of retired flows, indexed by FlowId
+  MetricsRecord m_row;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_EXPORTER_H */
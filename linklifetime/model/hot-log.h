@@ -0,0 +1,35 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * hot-log.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef HOT_LOG_H
+#define HOT_LOG_H
+
+#include "ns3/log.h"
+#include <iostream>
+
+/**
+ * \ingroup linklifetime
+ * Logging for code that runs for every frame, packet or discovery.
+ *
+ * HOT_LOG_DEBUG behaves like NS_LOG_DEBUG, but configuring with
+ * --disable-linklifetime-hot-logs defines LINKLIFETIME_HOT_LOGS_DISABLED and
+ * compiles these sites out even in debug builds. As with NS_LOG in optimized
+ * builds, the message stays behind an if (false) so that variables used only
+ * for logging do not trigger warnings; it is never evaluated.
+ * HOT_LOG_ENABLED guards work that only exists to produce log output, such
+ * as walking a whole routing table; it is constant false whenever the
+ * sites are compiled out.
+ */
+#if defined (LINKLIFETIME_HOT_LOGS_DISABLED) || !defined (NS3_LOG_ENABLE)
+#define HOT_LOG_DEBUG(msg) do { if (false) { std::clog << msg; } } while (false)
+#define HOT_LOG_ENABLED(level) (false)
+#else
+#define HOT_LOG_DEBUG(msg) NS_LOG_DEBUG (msg)
+#define HOT_LOG_ENABLED(level) (g_log.IsEnabled (level))
+#endif
+
+#endif /* HOT_LOG_H */
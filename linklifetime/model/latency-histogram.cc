@@ -0,0 +1,139 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * latency-histogram.cc
+ *
+ *      Author: hassam
+ */
+
+#include "latency-histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+const uint32_t LatencyHistogram::SUB_BUCKET_BITS;
+const uint64_t LatencyHistogram::MAX_MICROSECONDS;
+const uint32_t LatencyHistogram::BUCKET_COUNT;
+
+static const uint32_t SUB_BUCKETS = 1 << LatencyHistogram::SUB_BUCKET_BITS;
+static const uint32_t HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+
+LatencyHistogram::LatencyHistogram ()
+  : m_count (0),
+    m_max (0),
+    m_first (BUCKET_COUNT),
+    m_last (0)
+{
+}
+
+uint32_t
+LatencyHistogram::IndexOf (uint64_t microSeconds)
+{
+  if (microSeconds < SUB_BUCKETS)
+    {
+      return microSeconds;
+    }
+  uint32_t msb = 63 - __builtin_clzll (microSeconds);
+  uint32_t shift = msb - (SUB_BUCKET_BITS - 1);
+  uint32_t top = microSeconds >> shift;
+  return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + (top - HALF_SUB_BUCKETS);
+}
+
+uint64_t
+LatencyHistogram::HighestEquivalent (uint32_t index)
+{
+  if (index < SUB_BUCKETS)
+    {
+      return index;
+    }
+  uint32_t shift = (index - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+  uint64_t top = (index - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+  return (top << shift) + (uint64_t (1) << shift) - 1;
+}
+
+double
+LatencyHistogram::GetBucketUpperBound (uint32_t index)
+{
+  return HighestEquivalent (index) / 1e6;
+}
+
+void
+LatencyHistogram::Record (Time latency)
+{
+  int64_t us = latency.GetMicroSeconds ();
+  uint64_t v = us < 0 ? 0 : std::min<uint64_t> (us, MAX_MICROSECONDS);
+  uint32_t index = IndexOf (v);
+  if (m_counts.empty ())
+    {
+      m_counts.assign (BUCKET_COUNT, 0);
+    }
+  m_counts[index]++;
+  m_count++;
+  m_max = std::max (m_max, v);
+  m_first = std::min (m_first, index);
+  m_last = std::max (m_last, index);
+}
+
+void
+LatencyHistogram::Merge (const LatencyHistogram &other)
+{
+  if (other.m_count == 0)
+    {
+      return;
+    }
+  if (m_counts.empty ())
+    {
+      m_counts.assign (BUCKET_COUNT, 0);
+    }
+  for (uint32_t i = other.m_first; i <= other.m_last; i++)
+    {
+      m_counts[i] += other.m_counts[i];
+    }
+  m_count += other.m_count;
+  m_max = std::max (m_max, other.m_max);
+  m_first = std::min (m_first, other.m_first);
+  m_last = std::max (m_last, other.m_last);
+}
+
+void
+LatencyHistogram::Reset (void)
+{
+  // only the touched range can be non-zero, so a mostly idle histogram is cheap to clear
+  if (m_count != 0)
+    {
+      std::fill (m_counts.begin () + m_first, m_counts.begin () + m_last + 1, 0);
+    }
+  m_count = 0;
+  m_max = 0;
+  m_first = BUCKET_COUNT;
+  m_last = 0;
+}
+
+double
+LatencyHistogram::GetPercentile (double percentile) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  double p = std::min (std::max (percentile, 0.0), 100.0);
+  uint64_t rank = std::max<uint64_t> (1, std::ceil (p / 100 * m_count));
+  uint64_t seen = 0;
+  for (uint32_t i = m_first; i <= m_last; i++)
+    {
+      seen += m_counts[i];
+      if (seen >= rank)
+        {
+          return std::min (HighestEquivalent (i), m_max) / 1e6;
+        }
+    }
+  return m_max / 1e6;
+}
+
+double
+LatencyHistogram::GetMax (void) const
+{
+  return m_max / 1e6;
+}
+
+} // namespace ns3
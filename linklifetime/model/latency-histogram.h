@@ -0,0 +1,90 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * latency-histogram.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Log-linear latency histogram with a fixed number of buckets.
+ *
+ * Latencies are counted in microseconds. Values below 2^SUB_BUCKET_BITS are
+ * exact; above that, every power of two is split into 2^(SUB_BUCKET_BITS-1)
+ * linear sub-buckets, so any reported value is within 1/64 (about 1.6 %) of
+ * the recorded one. Latencies beyond MAX_MICROSECONDS are clamped. Memory is
+ * allocated once on the first sample and never grows, however many samples
+ * are recorded, so a histogram that records nothing costs next to nothing.
+ */
+class LatencyHistogram
+{
+public:
+  static const uint32_t SUB_BUCKET_BITS = 7;
+  static const uint64_t MAX_MICROSECONDS = 0xffffffff;
+  static const uint32_t BUCKET_COUNT = (1 << SUB_BUCKET_BITS) + (32 - SUB_BUCKET_BITS) * (1 << (SUB_BUCKET_BITS - 1));
+
+  LatencyHistogram ();
+
+  /// Count one sample; negative latencies count as zero
+  void Record (Time latency);
+  /// Add every sample of \p other to this histogram
+  void Merge (const LatencyHistogram &other);
+  /// Forget every sample
+  void Reset (void);
+
+  uint64_t GetCount (void) const
+  {
+    return m_count;
+  }
+  /**
+   * \param percentile between 0 and 100
+   * \returns the smallest latency, in seconds, that at least \p percentile
+   * percent of the samples do not exceed, or 0 if the histogram is empty
+   */
+  double GetPercentile (double percentile) const;
+  /// \returns the largest latency recorded, in seconds
+  double GetMax (void) const;
+
+  /**
+   * Buckets are ordered by latency; use GetBucketUpperBound and
+   * GetBucketCount to walk the non-empty ones.
+   */
+  uint32_t GetFirstBucket (void) const
+  {
+    return m_first;
+  }
+  /// \returns one past the last non-empty bucket
+  uint32_t GetEndBucket (void) const
+  {
+    return m_count == 0 ? m_first : m_last + 1;
+  }
+  uint64_t GetBucketCount (uint32_t index) const
+  {
+    return m_counts.empty () ? 0 : m_counts[index];
+  }
+  /// \returns the largest latency, in seconds, counted in bucket \p index
+  static double GetBucketUpperBound (uint32_t index);
+
+private:
+  static uint32_t IndexOf (uint64_t microSeconds);
+  static uint64_t HighestEquivalent (uint32_t index);
+
+  std::vector<uint64_t> m_counts;
+  uint64_t m_count;   //!< samples recorded
+  uint64_t m_max;     //!< largest sample, in microseconds
+  uint32_t m_first;   //!< lowest non-empty bucket
+  uint32_t m_last;    //!< highest non-empty bucket
+};
+
+} // namespace ns3
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * link-lifetime-predictor.cc
+ *
+ *      Author: hassam
+ */
+
+#include "link-lifetime-predictor.h"
+#include "markovchain-mobility-model.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+LinkLifetimePredictor::LinkLifetimePredictor (double step, double horizon)
+  : m_step (step),
+    m_steps (static_cast<uint32_t> (std::ceil (horizon / step))),
+    m_survival (m_steps + 1, 1.0)
+{
+}
+
+std::vector<double>
+LinkLifetimePredictor::StaySurvival (double firstDwell, uint16_t interval, double stay,
+                                     const double next[3][3], const double dwell[3]) const
+{
+  std::vector<double> survival (m_steps + 1, 1.0);
+  uint32_t first = static_cast<uint32_t> (std::ceil (std::max (firstDwell, 0.0) / m_step));
+  if (first > m_steps || interval > 2)
+    {
+      return survival;
+    }
+  // ends[3 * t + k]: probability that a pause of class k ends at step t, the node still at its location
+  std::vector<double> ends (3 * (m_steps + 1), 0.0);
+  std::vector<double> leave (m_steps + 1, 0.0);
+  ends[3 * first + interval] = 1.0;
+  for (uint32_t t = first; t <= m_steps; t++)
+    {
+      for (uint16_t k = 0; k < 3; k++)
+        {
+          double mass = ends[3 * t + k];
+          if (mass == 0)
+            {
+              continue;
+            }
+          double rowSum = next[k][0] + next[k][1] + next[k][2];
+          double again = rowSum > 0 ? stay : 0;
+          leave[t] += mass * (1 - again);
+          for (uint16_t l = 0; l < 3 && again > 0; l++)
+            {
+              uint32_t end = t + std::max<uint32_t> (1, static_cast<uint32_t> (std::lround (dwell[l] / m_step)));
+              if (end <= m_steps)
+                {
+                  ends[3 * end + l] += mass * again * next[k][l] / rowSum;
+                }
+            }
+        }
+    }
+  double left = 1.0;
+  for (uint32_t t = 0; t <= m_steps; t++)
+    {
+      left -= leave[t];
+      survival[t] = std::max (left, 0.0);
+    }
+  return survival;
+}
+
+void
+LinkLifetimePredictor::Combine (const std::vector<double> &a, const std::vector<double> &b)
+{
+  for (uint32_t t = 0; t <= m_steps; t++)
+    {
+      m_survival[t] = a[t] * b[t];
+    }
+}
+
+std::vector<double>
+LinkLifetimePredictor::StayOf (Ptr<MarkovChainMobilityModel> model) const
+{
+  uint16_t location, interval;
+  Time left;
+  model->GetCurrentStay (location, interval, left);
+  double next[3][3], dwell[3];
+  for (uint16_t k = 0; k < 3; k++)
+    {
+      dwell[k] = model->TimeIntervaltoTime (k);
+      for (uint16_t l = 0; l < 3; l++)
+        {
+          next[k][l] = location < 5 ? model->GetTimeIntervalProbability (location, location, k, l) : 0;
+        }
+    }
+  // a node outside every location leaves at the end of its current pause
+  double stay = location < 5 ? model->GetLocationProbability (location, location) : 0;
+  return StaySurvival (left.GetSeconds (), interval, stay, next, dwell);
+}
+
+void
+LinkLifetimePredictor::Predict (Ptr<MarkovChainMobilityModel> a, Ptr<MarkovChainMobilityModel> b)
+{
+  Combine (StayOf (a), StayOf (b));
+}
+
+double
+LinkLifetimePredictor::GetExpectation (void) const
+{
+  // the lifetime is a multiple of the step, so E = step * sum of P(lifetime > k * step)
+  double expectation = 0;
+  for (uint32_t t = 0; t < m_steps; t++)
+    {
+      expectation += m_survival[t] * m_step;
+    }
+  return expectation;
+}
+
+double
+LinkLifetimePredictor::GetQuantile (double p) const
+{
+  uint32_t t = 0;
+  while (t < m_steps && m_survival[t] >= 1 - p)
+    {
+      t++;
+    }
+  return t * m_step;
+}
+
+double
+LinkLifetimePredictor::GetSurvival (double t) const
+{
+  if (t < 0)
+    {
+      return 1.0;
+    }
+  return m_survival[std::min<uint32_t> (static_cast<uint32_t> (t / m_step), m_steps)];
+}
+
+} // namespace ns3
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * link-lifetime-predictor.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef LINK_LIFETIME_PREDICTOR_H
+#define LINK_LIFETIME_PREDICTOR_H
+
+#include "ns3/ptr.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+class MarkovChainMobilityModel;
+
+/**
+ * \ingroup linklifetime
+ * \brief Distribution of how long two neighbours stay where they are.
+ *
+ * A link between two nodes holds while neither of them leaves its current
+ * location. A MarkovChainMobilityModel pauses at a location for the time of
+ * its interval class (short, medium or long), then either picks the same
+ * location again, with the learned location transition probability, and
+ * pauses for a further interval drawn from the learned time interval
+ * transitions, or leaves. Predict follows these transitions for each node on
+ * a grid of \p step seconds up to \p horizon, from the pause the node is in
+ * (or, while it walks, from its arrival at its destination), and takes the
+ * product of the two survival functions: the link lasts as long as the
+ * shorter of the two stays. Time beyond the horizon counts as the horizon.
+ *
+ * GetExpectation gives the mean lifetime, GetQuantile(p) the lifetime the
+ * link reaches with probability 1 - p, so an allocator can trade the time it
+ * plans with against the risk of the link breaking first.
+ */
+class LinkLifetimePredictor
+{
+public:
+  /**
+   * \param step resolution of the distribution in seconds
+   * \param horizon longest lifetime considered, in seconds
+   */
+  LinkLifetimePredictor (double step = 1.0, double horizon = 300.0);
+
+  /// Compute the lifetime distribution of the link between the nodes moved by \p a and \p b
+  void Predict (Ptr<MarkovChainMobilityModel> a, Ptr<MarkovChainMobilityModel> b);
+
+  /// \returns the expected lifetime in seconds
+  double GetExpectation (void) const;
+  /// \returns the lifetime in seconds the link falls short of with probability at most \p p
+  double GetQuantile (double p) const;
+  /// \returns the probability that the link still holds after \p t seconds
+  double GetSurvival (double t) const;
+
+  /**
+   * Survival of the stay of one node at its location.
+   * \param firstDwell seconds left of the current pause
+   * \param interval interval class of the current pause
+   * \param stay probability of picking the same location again once a pause ends
+   * \param next time interval transitions at the location, next[previous][following]
+   * \param dwell seconds of a pause of each interval class
+   * \returns P(stay > k * step) for k = 0 .. steps
+   */
+  std::vector<double> StaySurvival (double firstDwell, uint16_t interval, double stay,
+                                    const double next[3][3], const double dwell[3]) const;
+  /// Set the distribution to the product of two stay survivals
+  void Combine (const std::vector<double> &a, const std::vector<double> &b);
+
+private:
+  /// \returns the stay survival of the node moved by \p model
+  std::vector<double> StayOf (Ptr<MarkovChainMobilityModel> model) const;
+
+  double m_step;
+  uint32_t m_steps;
+  std::vector<double> m_survival;  //!< P(lifetime > k * step), k = 0 .. m_steps
+};
+
+} // namespace ns3
+
+#endif /* LINK_LIFETIME_PREDICTOR_H */
@@ -11,6 +11,7 @@
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/hot-log.h"
 #include "ns3/node.h"
 #include <cmath>
 #include <ns3/vector.h>
@@ -80,6 +81,7 @@ MarkovChainMobilityModel::DoInitialize (void)
 	//m_default = true;
 	m_firstTime = true;
 	m_countArrival = 0;
+	m_interval = 0;
     DoInitializePrivate ();
     MobilityModel::DoInitialize ();
 
@@ -236,15 +238,49 @@ MarkovChainMobilityModel::GetNextLocation() const
     return m_destination;
 }
 
+double
+MarkovChainMobilityModel::GetLocationProbability (uint16_t from, uint16_t to) const
+{
+    return m_elem.m_locMatrix[from][to].m_locationProbability;
+}
+
+double
+MarkovChainMobilityModel::GetTimeIntervalProbability (uint16_t from, uint16_t to, uint16_t previous, uint16_t next) const
+{
+    return m_elem.m_locMatrix[from][to].m_timeIntervalMatrix[previous][next].m_timeIntervalProbability;
+}
+
+void
+MarkovChainMobilityModel::GetCurrentStay (uint16_t &location, uint16_t &interval, Time &left)
+{
+    m_helper.Update ();
+    Vector velocity = m_helper.GetVelocity ();
+    interval = m_interval;
+    left = Simulator::GetDelayLeft (m_event);
+    if (velocity.x == 0 && velocity.y == 0 && velocity.z == 0)
+    {
+        // pausing: m_event ends the pause
+        location = PositionToLocation (m_helper.GetCurrentPosition ());
+        if (location == 5)
+            location = LocationIdentifier (m_helper.GetCurrentPosition ());
+    }
+    else
+    {
+        // walking: m_event is the arrival
+        location = m_destination;
+        left += Seconds (TimeIntervaltoTime (m_interval));
+    }
+}
+
 void MatrixElement::UpdateLocationProbability(uint16_t currLoc, uint16_t prevLoc, Ptr<MarkovChainMobilityModel> caller){
-    NS_LOG_DEBUG("Location Probability Update Method is called");
+    HOT_LOG_DEBUG("Location Probability Update Method is called");
     double rowSum = 0;
     double finalRowSum = 0;
     double sub = 0;
     double div = 0;
     double numOfVisits = 0;
 
-    NS_LOG_DEBUG("Total Number of Visits before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_totalNumOfVisits);
+    HOT_LOG_DEBUG("Total Number of Visits before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_totalNumOfVisits);
     //If this is the first time update method is called, then add the initial total number of visit at each location i.e. 100+100+100+100+100 = 500
     //if(m_firstUpd[currLoc] == true){
         for(uint16_t i = 0; i < 5; ++i){
@@ -257,7 +293,7 @@ void MatrixElement::UpdateLocationProbability(uint16_t currLoc, uint16_t prevLoc
     //once added. No need to add again so turn the bool to false
 //		m_firstUpd[currLoc] = false;
 //	}
-    NS_LOG_DEBUG("Total Number of Visits after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_totalNumOfVisits);
+    HOT_LOG_DEBUG("Total Number of Visits after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_totalNumOfVisits);
 
     //Insert the updated probability
     SetLocationProbability(currLoc, prevLoc);
@@ -266,7 +302,7 @@ void MatrixElement::UpdateLocationProbability(uint16_t currLoc, uint16_t prevLoc
     for(uint16_t i = 0; i < 5; i++){
         rowSum += m_locMatrix[prevLoc][i].m_locationProbability;
     }
-    NS_LOG_DEBUG("Row Sum: " << rowSum);
+    HOT_LOG_DEBUG("Row Sum: " << rowSum);
 
     //if the sum is less than or greater than 1 then, first subtract the row sum from 1, and later divide this value with the n-1 here n is 5, so dividing by 4
     if(rowSum > 1 || rowSum < 1){
@@ -283,11 +319,11 @@ void MatrixElement::UpdateLocationProbability(uint16_t currLoc, uint16_t prevLoc
     for(uint16_t i = 0; i < 5; i++){
         finalRowSum += m_locMatrix[prevLoc][i].m_locationProbability;
     }
-    NS_LOG_DEBUG("Final row sum: " << finalRowSum);
+    HOT_LOG_DEBUG("Final row sum: " << finalRowSum);
 
 //	caller->CheckTimeInterval();
     m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[caller->m_prevTime[prevLoc][currLoc]][caller->m_currTime[prevLoc][currLoc]].m_timeIntervalCounter++;
-    NS_LOG_DEBUG("Time Interval Counter: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[caller->m_prevTime[prevLoc][currLoc]][caller->m_currTime[prevLoc][currLoc]]
+    HOT_LOG_DEBUG("Time Interval Counter: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[caller->m_prevTime[prevLoc][currLoc]][caller->m_currTime[prevLoc][currLoc]]
                                                                         .m_timeIntervalCounter);
     UpdateTimeIntervalProbability(currLoc, prevLoc, caller->m_currTime[prevLoc][currLoc], caller->m_prevTime[prevLoc][currLoc]);
      caller->m_prevTime[prevLoc][currLoc] = caller->m_currTime[prevLoc][currLoc];
@@ -301,16 +337,16 @@ void MatrixElement::UpdateLocationProbability(uint16_t currLoc, uint16_t prevLoc
 }
 
 void MatrixElement::UpdateTimeIntervalProbability(uint16_t currLoc, uint16_t prevLoc, uint16_t currTimeInt, uint16_t prevTimeInt){
-    NS_LOG_DEBUG("Time Interval Probability Update Method is called");
-    NS_LOG_DEBUG("PrevTimeInt: " << prevTimeInt << ", currentTimeInt: " << currTimeInt);
+    HOT_LOG_DEBUG("Time Interval Probability Update Method is called");
+    HOT_LOG_DEBUG("PrevTimeInt: " << prevTimeInt << ", currentTimeInt: " << currTimeInt);
     double rowSum = 0;
     double finalRowSum = 0;
     double sub = 0;
     double div = 0;
     double numOfTimeIntervals = 0;
-    NS_LOG_DEBUG("Number of Time Intervals before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
+    HOT_LOG_DEBUG("Number of Time Intervals before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
                                                                                         .m_timeIntervalCounter);
-    NS_LOG_DEBUG("Total Number of Time Intervals before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
+    HOT_LOG_DEBUG("Total Number of Time Intervals before updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
                                                                                             .m_totalTimeIntervals);
     //If this is the first time update method is called, then add the initial total number of time intervals at each time interval i.e. 100+100+100 = 300
     //if(m_firstTimeUpd[currLoc] == true){
@@ -322,34 +358,34 @@ void MatrixElement::UpdateTimeIntervalProbability(uint16_t currLoc, uint16_t pre
         }
 //		m_firstTimeUpd[currLoc] = false;
 //	}
-    NS_LOG_DEBUG("Total Number of Time Intervals after updating: " << numOfTimeIntervals);
-    NS_LOG_DEBUG("Number of Time Intervals after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
+    HOT_LOG_DEBUG("Total Number of Time Intervals after updating: " << numOfTimeIntervals);
+    HOT_LOG_DEBUG("Number of Time Intervals after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
                                                                                             .m_timeIntervalCounter);
-    NS_LOG_DEBUG("Total Number of Time Intervals after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
+    HOT_LOG_DEBUG("Total Number of Time Intervals after updating at current location: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt]
                                                                                                 .m_totalTimeIntervals);
 
     //Insert the updated probability
     SetTimeIntervalProbability(currLoc, prevLoc, currTimeInt, prevTimeInt);
-    NS_LOG_DEBUG("Time interval probability updating: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt].m_timeIntervalProbability);
+    HOT_LOG_DEBUG("Time interval probability updating: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][currTimeInt].m_timeIntervalProbability);
     //The sum of a row should always be equal to 1, so initially calculate the row sum
 
     for(uint16_t j = 0; j < 3; j++){
         rowSum += m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability;
     }
-    NS_LOG_DEBUG("Time Row Sum: " << rowSum);
+    HOT_LOG_DEBUG("Time Row Sum: " << rowSum);
 
     //if the sum is less than or greater than 1 then, first subtract the row sum from 1, and later divide this value with the n-1 here n is 3, so dividing by 2
     if(rowSum > 1 || rowSum < 1){
         sub = 1 - rowSum;
-        NS_LOG_DEBUG("Sub: " << sub);
+        HOT_LOG_DEBUG("Sub: " << sub);
         div = sub/2;
-        NS_LOG_DEBUG("Div: " << div);
+        HOT_LOG_DEBUG("Div: " << div);
         //No need to add the value from the current updated element, so checking if the element is current or not, if not then adding the divided value
         for(uint16_t j = 0; j < 3; j++){
             if(j != currTimeInt){
                 m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability = m_locMatrix[prevLoc][currLoc]
                 .m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability + div;
-                NS_LOG_DEBUG("Time interval probability updating: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability);
+                HOT_LOG_DEBUG("Time interval probability updating: " << m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability);
             }
         }
     }
@@ -357,7 +393,7 @@ void MatrixElement::UpdateTimeIntervalProbability(uint16_t currLoc, uint16_t pre
     for(uint16_t j = 0; j < 3; j++){
         finalRowSum += m_locMatrix[prevLoc][currLoc].m_timeIntervalMatrix[prevTimeInt][j].m_timeIntervalProbability;
     }
-    NS_LOG_DEBUG("Final Time Row Sum: " << finalRowSum);
+    HOT_LOG_DEBUG("Final Time Row Sum: " << finalRowSum);
 
 }
 
@@ -369,8 +405,8 @@ MarkovChainMobilityModel::BeginWalk (void)
     m_helper.Update ();
     Vector m_current = m_helper.GetCurrentPosition ();
     NS_ASSERT_MSG (m_position, "No position allocator added before using this model");
-    NS_LOG_DEBUG("Current Location Coordinates: " << m_current);
-    NS_LOG_DEBUG("Previous Location Coordinates: " << m_prevLocation);
+    HOT_LOG_DEBUG("Current Location Coordinates: " << m_current);
+    HOT_LOG_DEBUG("Previous Location Coordinates: " << m_prevLocation);
     //convert our current position to location number
     uint16_t currentLoc = PositionToLocation(m_current);
     if(currentLoc == 5){
@@ -379,16 +415,16 @@ MarkovChainMobilityModel::BeginWalk (void)
         m_currLocation = currentLoc;
     }
 
-    NS_LOG_DEBUG("Current Location: " << m_currLocation << ", Previous Location: " << m_prevLocation);
+    HOT_LOG_DEBUG("Current Location: " << m_currLocation << ", Previous Location: " << m_prevLocation);
 
     if(m_prevLocation == m_currLocation){
-        NS_LOG_DEBUG("No Need to update the matrix");
+        HOT_LOG_DEBUG("No Need to update the matrix");
     } else {
 
         //Incrementing the location counter or the current number of visit
         m_elem.m_locMatrix[m_prevLocation][m_currLocation].m_locationCounter++;
 
-        NS_LOG_DEBUG("Location Counter value after incrementing at m_prevlocation: " << m_prevLocation << ", and m_currLocation: " << m_currLocation << ", is: " <<
+        HOT_LOG_DEBUG("Location Counter value after incrementing at m_prevlocation: " << m_prevLocation << ", and m_currLocation: " << m_currLocation << ", is: " <<
                 m_elem.m_locMatrix[m_prevLocation][m_currLocation].m_locationCounter);
         //update the probability matrix for journey from m_prevLocation to m_currLocation
         Ptr<MarkovChainMobilityModel> temp(this);
@@ -401,11 +437,11 @@ MarkovChainMobilityModel::BeginWalk (void)
         m_locMatricesResults << "\n\n" << Simulator::Now ().GetSeconds () <<", Node " << id << ": Location Transition Probability Matrix\n ";
         for(uint16_t i = 0; i < 5; i++){
             for(uint16_t j = 0; j < 5; j++){
-                NS_LOG_DEBUG("Printing updated location matrix: ");
-                NS_LOG_DEBUG(" [" << i << "][" << j <<"] " << m_elem.m_locMatrix[i][j].m_locationProbability << " ");
+                HOT_LOG_DEBUG("Printing updated location matrix: ");
+                HOT_LOG_DEBUG(" [" << i << "][" << j <<"] " << m_elem.m_locMatrix[i][j].m_locationProbability << " ");
                 m_locMatricesResults << " " << m_elem.m_locMatrix[i][j].m_locationProbability << " ";
             }
-            NS_LOG_DEBUG("");
+            HOT_LOG_DEBUG("");
             m_locMatricesResults << " \n";
         }
         m_locMatricesResults.close();
@@ -416,12 +452,12 @@ MarkovChainMobilityModel::BeginWalk (void)
             for(uint16_t j = 0; j < 5; j++){
                 for(uint16_t k = 0; k < 3; k++){
                     for(uint16_t l = 0; l < 3; l++){
-                        NS_LOG_DEBUG("Printing updated time interval matrix: ");
-                        NS_LOG_DEBUG(" [" << i << "][" << j <<"], " << " [" << k << "][" << l <<"] " << m_elem.m_locMatrix[i][j].m_timeIntervalMatrix[k][l]
+                        HOT_LOG_DEBUG("Printing updated time interval matrix: ");
+                        HOT_LOG_DEBUG(" [" << i << "][" << j <<"], " << " [" << k << "][" << l <<"] " << m_elem.m_locMatrix[i][j].m_timeIntervalMatrix[k][l]
                             .m_timeIntervalProbability << " ");
                         m_timeMatricesResults<< " " << m_elem.m_locMatrix[i][j].m_timeIntervalMatrix[k][l].m_timeIntervalProbability << " ";
                     }
-                    NS_LOG_DEBUG(" ");
+                    HOT_LOG_DEBUG(" ");
                     m_timeMatricesResults <<" \n";
                 }
                 m_timeMatricesResults <<" \n\n";
@@ -438,88 +474,39 @@ MarkovChainMobilityModel::BeginWalk (void)
 
     }
     else {
-//        double temp[5];
-//        for(uint16_t j = 0; j < 5; j++)
-//            temp[j] =  m_elem.m_locMatrix[m_currLocation][j].m_locationProbability;
-
-    	Ptr<Node> node = GetObject<Node>();
-    	        uint16_t id = node->GetId();
-    	switch (id){
-    		case 0:
-    		{
-
-    			uint16_t m_locations[] = {1,0,3,4,2,1};
-    			m_destination = m_locations[i[0]];
-    			i[0]++;
-
-    			uint16_t m_times[] = {0,0,1,2,0,2};
-    			m_interval = m_times[k[0]];
-    			k[0]++;
-    		}
-    			break;
-    		case 1:
-    		{
-
-    			uint16_t m_locations1[] = {1,0,3,4,2,1};
-    			m_destination = m_locations1[i[1]];
-    			i[1]++;
-
-    			uint16_t m_times1[] = {0,0,1,2,0,2};
-    			m_interval = m_times1[k[1]];
-    			k[1]++;
-    		}
-    			break;
-    		case 2:
-    		{
-
-    			uint16_t m_locations2[] = {4,3,2,1,0,0};
-    			m_destination = m_locations2[i[2]];
-    			i[2]++;
-
-    			uint16_t m_times2[] = {2,1,0,0,1,2};
-    			m_interval = m_times2[k[2]];
-    			k[2]++;
-    		}
-    			break;
-    		case 3:
-    		{
-
-    			uint16_t m_locations3[] = {4,3,2,1,0,0};
-    			m_destination = m_locations3[i[3]];
-    			i[3]++;
-
-    			uint16_t m_times3[] = {2,1,0,0,1,2};
-    			m_interval = m_times3[k[3]];
-    			k[3]++;
-    		}
-    			break;
-    		case 4:
-    		{
-
-    			uint16_t m_locations4[] = {1,0,3,4,2,1};
-    			m_destination = m_locations4[i[4]];
-    			i[4]++;
-
-    			uint16_t m_times4[] = {0,1,2,1,0,0};
-    			m_interval = m_times4[k[4]];
-    			k[4]++;
-    		}
-    			break;
-    		default:
-    			NS_LOG_DEBUG("No node!");
-    		}
-
-       // m_destination = SelectLocation(temp);
-//        for(uint16_t j = 0; j < 3; j++)
-//            temp[j] =  m_elem.m_locMatrix[m_currLocation][m_destination].m_timeIntervalMatrix[m_prevTime[m_currLocation][m_destination]][j].m_timeIntervalProbability;
-       // m_interval = SelectTimeInterval(temp);
-
-        NS_LOG_DEBUG("The next most probable time interval is: " << m_interval);
+        // The first nodes follow fixed walks so that runs stay comparable;
+        // any other node, or one whose walk is used up, samples the learned
+        // transition matrices instead.
+        static const uint16_t scriptedLocations[][6] = {{1,0,3,4,2,1}, {1,0,3,4,2,1}, {4,3,2,1,0,0}, {4,3,2,1,0,0}, {1,0,3,4,2,1}};
+        static const uint16_t scriptedTimes[][6] = {{0,0,1,2,0,2}, {0,0,1,2,0,2}, {2,1,0,0,1,2}, {2,1,0,0,1,2}, {0,1,2,1,0,0}};
+        static const uint32_t nScripted = sizeof (scriptedLocations) / sizeof (scriptedLocations[0]);
+
+        Ptr<Node> node = GetObject<Node>();
+        uint32_t id = node->GetId();
+        if (id < nScripted && m_walkStep < 6)
+        {
+            m_destination = scriptedLocations[id][m_walkStep];
+            m_interval = scriptedTimes[id][m_walkStep];
+            m_walkStep++;
+        }
+        else
+        {
+            double temp[5];
+            for(uint16_t j = 0; j < 5; j++)
+                temp[j] =  m_elem.m_locMatrix[m_currLocation][j].m_locationProbability;
+            m_destination = SelectLocation(temp);
+            double tempTime[3];
+            for(uint16_t j = 0; j < 3; j++)
+                tempTime[j] =  m_elem.m_locMatrix[m_currLocation][m_destination].m_timeIntervalMatrix[m_prevTime[m_currLocation][m_destination]][j].m_timeIntervalProbability;
+            m_interval = SelectTimeInterval(tempTime);
+        }
+
+        HOT_LOG_DEBUG("The next most probable time interval is: " << m_interval);
     }
 
 
 
-    NS_LOG_DEBUG("Destination Value: " << m_destination);
+    HOT_LOG_DEBUG("Destination Value: " << m_destination);
     Vector destination = m_destLoc[m_destination];
     double speed = m_speed->GetValue ();
     double dx = (destination.x - m_current.x);
@@ -530,7 +517,7 @@ MarkovChainMobilityModel::BeginWalk (void)
     m_helper.Unpause ();
 
     Time travelDelay = Seconds (CalculateDistance (destination, m_current) / speed);
-    NS_LOG_DEBUG("Travel Delay: " << travelDelay.GetSeconds() << "s");
+    HOT_LOG_DEBUG("Travel Delay: " << travelDelay.GetSeconds() << "s");
     m_event.Cancel ();
     m_event = Simulator::Schedule (travelDelay, &MarkovChainMobilityModel::DoInitializePrivate, this);
     //Store the current location as previous location
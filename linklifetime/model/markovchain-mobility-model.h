@@ -85,6 +85,16 @@ public:
     void CheckTimeInterval();
     uint16_t GetNextLocation() const;
     uint16_t GetNextTime() const;
+    /// Learned probability of moving from location \p from to location \p to
+    double GetLocationProbability (uint16_t from, uint16_t to) const;
+    /// Learned probability of a \p next interval after a \p previous one, on the way from \p from to \p to
+    double GetTimeIntervalProbability (uint16_t from, uint16_t to, uint16_t previous, uint16_t next) const;
+    /**
+     * Where the node stays next and for how long: the location it pauses at
+     * and the time left of the pause or, while it walks, its destination and
+     * the travel time left plus the pause there.
+     */
+    void GetCurrentStay (uint16_t &location, uint16_t &interval, Time &left);
 
     uint16_t m_prevTime[5][5]; //track previous time interval
     uint16_t m_currTime[5][5]; //track current time interval
@@ -139,8 +149,7 @@ private:
     //Time-intervals
     double m_prevArrivalTime[5];
     double m_timeSpent[5][5];
-	uint16_t i[5] = {0};
-    uint16_t k[5] = {0};
+    uint16_t m_walkStep = 0; //!< steps taken on the scripted walk
     Time m_arrivalTime[5];
     //Time m_prevTime[5][5];
     Time m_mobilityTime;
@@ -0,0 +1,281 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * metrics-sink.cc
+ *
+ *      Author: hassam
+ */
+
+#include "metrics-sink.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace ns3 {
+
+/// Pending bytes after which an output is written out in the middle of a batch
+static const std::size_t METRICS_WRITE_BLOCK = 1 << 20;
+
+const uint16_t MetricsRecord::MAX_COLUMNS;
+
+MetricsOutput::MetricsOutput (const std::string &path, const MetricsSchema &schema)
+  : m_path (path),
+    m_schema (schema)
+{
+  m_stream.open (path.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+}
+
+MetricsOutput::~MetricsOutput ()
+{
+  if (m_stream.is_open ())
+    {
+      m_stream.close ();
+    }
+}
+
+void
+MetricsOutput::WriteOut (void)
+{
+  if (!m_buffer.empty ())
+    {
+      m_stream.write (m_buffer.data (), m_buffer.size ());
+      m_buffer.clear ();
+    }
+}
+
+void
+MetricsOutput::Finish (void)
+{
+  WriteOut ();
+  m_stream.close ();
+}
+
+void
+MetricsOutput::Sync (void)
+{
+  m_stream.flush ();
+}
+
+CsvMetricsOutput::CsvMetricsOutput (const std::string &path, const MetricsSchema &schema)
+  : MetricsOutput (path, schema)
+{
+  for (std::size_t i = 0; i < m_schema.size (); i++)
+    {
+      if (i != 0)
+        {
+          m_buffer += ',';
+        }
+      m_buffer += m_schema[i].name;
+    }
+  m_buffer += '\n';
+}
+
+void
+CsvMetricsOutput::Format (const MetricsRecord &record)
+{
+  char cell[32];
+  uint16_t n = std::min<uint16_t> (record.GetSize (), MetricsRecord::MAX_COLUMNS);
+  for (uint16_t i = 0; i < n; i++)
+    {
+      int len;
+      if (record.GetKind (i) == METRICS_U64)
+        {
+          len = std::snprintf (cell, sizeof (cell), "%llu", (unsigned long long) record.GetU64 (i));
+        }
+      else
+        {
+          // %g matches the default std::ostream formatting the CSV files always had
+          len = std::snprintf (cell, sizeof (cell), "%g", record.GetF64 (i));
+        }
+      if (i != 0)
+        {
+          m_buffer += ',';
+        }
+      m_buffer.append (cell, len);
+    }
+  m_buffer += '\n';
+}
+
+MetricsSink::MetricsSink (uint32_t capacity, uint32_t flushBlock)
+  : m_ring (capacity),
+    m_flushBlock (std::min (flushBlock, capacity)),
+    m_head (0),
+    m_tail (0),
+    m_flushRequests (0),
+    m_flushesDone (0),
+    m_closing (false),
+    m_closed (false),
+    m_stalls (0)
+{
+}
+
+MetricsSink::~MetricsSink ()
+{
+  Close ();
+}
+
+MetricsSink::Handle
+MetricsSink::OpenCsv (const std::string &path, const MetricsSchema &schema)
+{
+  return Open (new CsvMetricsOutput (path, schema));
+}
+
+MetricsSink::Handle
+MetricsSink::Open (MetricsOutput *output)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  m_outputs.push_back (output);
+  if (!m_writer.joinable () && !m_closed)
+    {
+      m_writer = std::thread (&MetricsSink::WriterLoop, this);
+    }
+  return m_outputs.size () - 1;
+}
+
+void
+MetricsSink::Append (Handle handle, const MetricsRecord &record)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  if (m_closed || handle >= m_outputs.size ())
+    {
+      return;
+    }
+  if (m_head - m_tail == m_ring.size ())
+    {
+      m_stalls++;
+      m_notEmpty.notify_one ();
+      m_notFull.wait (lock, [this] { return m_head - m_tail < m_ring.size (); });
+    }
+  Slot &slot = m_ring[m_head % m_ring.size ()];
+  slot.handle = handle;
+  slot.record = record;
+  m_head++;
+  if (m_head - m_tail >= m_flushBlock)
+    {
+      m_notEmpty.notify_one ();
+    }
+}
+
+void
+MetricsSink::AppendBatch (const std::vector<Handle> &handles, const std::vector<MetricsRecord> &records)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  if (m_closed)
+    {
+      return;
+    }
+  std::size_t n = std::min (handles.size (), records.size ());
+  for (std::size_t i = 0; i < n; i++)
+    {
+      if (handles[i] >= m_outputs.size ())
+        {
+          continue;
+        }
+      if (m_head - m_tail == m_ring.size ())
+        {
+          m_stalls++;
+          m_notEmpty.notify_one ();
+          m_notFull.wait (lock, [this] { return m_head - m_tail < m_ring.size (); });
+        }
+      Slot &slot = m_ring[m_head % m_ring.size ()];
+      slot.handle = handles[i];
+      slot.record = records[i];
+      m_head++;
+    }
+  if (m_head - m_tail >= m_flushBlock)
+    {
+      m_notEmpty.notify_one ();
+    }
+}
+
+void
+MetricsSink::Flush (void)
+{
+  std::unique_lock<std::mutex> lock (m_mutex);
+  if (!m_writer.joinable ())
+    {
+      return;
+    }
+  uint64_t ticket = ++m_flushRequests;
+  m_notEmpty.notify_one ();
+  m_drained.wait (lock, [this, ticket] { return m_flushesDone >= ticket; });
+}
+
+void
+MetricsSink::Close (void)
+{
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    if (m_closed)
+      {
+        return;
+      }
+    m_closing = true;
+    m_notEmpty.notify_one ();
+  }
+  if (m_writer.joinable ())
+    {
+      m_writer.join ();
+    }
+  std::lock_guard<std::mutex> lock (m_mutex);
+  for (std::size_t i = 0; i < m_outputs.size (); i++)
+    {
+      m_outputs[i]->Finish ();
+      delete m_outputs[i];
+    }
+  m_outputs.clear ();
+  m_closed = true;
+}
+
+void
+MetricsSink::WriterLoop (void)
+{
+  std::vector<MetricsOutput *> outputs;
+  std::unique_lock<std::mutex> lock (m_mutex);
+  while (true)
+    {
+      m_notEmpty.wait (lock, [this] {
+        return m_head - m_tail >= m_flushBlock || m_flushRequests > m_flushesDone || m_closing;
+      });
+      uint64_t begin = m_tail;
+      uint64_t end = m_head;
+      uint64_t flushTicket = m_flushRequests;
+      bool closing = m_closing;
+      outputs = m_outputs;
+      lock.unlock ();
+
+      // Slots in [begin, end) belong to the writer until m_tail moves past them
+      for (uint64_t k = begin; k < end; k++)
+        {
+          const Slot &slot = m_ring[k % m_ring.size ()];
+          MetricsOutput *output = outputs[slot.handle];
+          output->Format (slot.record);
+          if (output->GetPending () >= METRICS_WRITE_BLOCK)
+            {
+              output->WriteOut ();
+            }
+        }
+      bool sync = flushTicket > m_flushesDone || closing;
+      for (std::size_t i = 0; i < outputs.size (); i++)
+        {
+          outputs[i]->WriteOut ();
+          if (sync)
+            {
+              outputs[i]->Sync ();
+            }
+        }
+
+      lock.lock ();
+      m_tail = end;
+      m_notFull.notify_all ();
+      if (flushTicket > m_flushesDone)
+        {
+          m_flushesDone = flushTicket;
+          m_drained.notify_all ();
+        }
+      if (closing && m_tail == m_head)
+        {
+          break;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * metrics-sink.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef METRICS_SINK_H
+#define METRICS_SINK_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Type of a metrics column.
+ */
+enum MetricsType
+{
+  METRICS_U64 = 0,
+  METRICS_F64 = 1
+};
+
+/**
+ * \brief Name and type of one metrics column.
+ */
+struct MetricsColumn
+{
+  std::string name;
+  MetricsType type;
+};
+
+typedef std::vector<MetricsColumn> MetricsSchema;
+
+/**
+ * \brief One row of metrics, built on the simulation thread and copied into
+ * the sink's ring.
+ *
+ * Integral values are stored as unsigned 64 bit integers, everything else as
+ * doubles; the kind of each cell travels with it so the writer never has to
+ * guess.
+ */
+class MetricsRecord
+{
+public:
+  static const uint16_t MAX_COLUMNS = 64;
+
+  MetricsRecord ()
+    : m_size (0)
+  {
+  }
+
+  template <typename T>
+  MetricsRecord & operator<< (T value)
+  {
+    if (m_size < MAX_COLUMNS)
+      {
+        if (std::is_integral<T>::value)
+          {
+            m_kinds[m_size] = METRICS_U64;
+            m_cells[m_size].u = static_cast<uint64_t> (value);
+          }
+        else
+          {
+            m_kinds[m_size] = METRICS_F64;
+            m_cells[m_size].d = static_cast<double> (value);
+          }
+      }
+    m_size++;
+    return *this;
+  }
+
+  void Clear (void)
+  {
+    m_size = 0;
+  }
+  uint16_t GetSize (void) const
+  {
+    return m_size;
+  }
+  MetricsType GetKind (uint16_t i) const
+  {
+    return static_cast<MetricsType> (m_kinds[i]);
+  }
+  uint64_t GetU64 (uint16_t i) const
+  {
+    return m_kinds[i] == METRICS_U64 ? m_cells[i].u : static_cast<uint64_t> (m_cells[i].d);
+  }
+  double GetF64 (uint16_t i) const
+  {
+    return m_kinds[i] == METRICS_F64 ? m_cells[i].d : static_cast<double> (m_cells[i].u);
+  }
+
+private:
+  union Cell
+  {
+    uint64_t u;
+    double d;
+  };
+  uint16_t m_size;
+  uint8_t m_kinds[MAX_COLUMNS];
+  Cell m_cells[MAX_COLUMNS];
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief One output of a MetricsSink.
+ *
+ * Outputs are only touched by the sink's writer thread once registered.
+ */
+class MetricsOutput
+{
+public:
+  MetricsOutput (const std::string &path, const MetricsSchema &schema);
+  virtual ~MetricsOutput ();
+
+  /// Format \p record into the pending buffer
+  virtual void Format (const MetricsRecord &record) = 0;
+  /// Write the pending buffer to disk
+  virtual void WriteOut (void);
+  /// Write any trailer and close the file
+  virtual void Finish (void);
+  /// Flush the file to the operating system
+  void Sync (void);
+  /// \returns the number of bytes waiting to be written
+  std::size_t GetPending (void) const
+  {
+    return m_buffer.size ();
+  }
+
+protected:
+  std::string m_path;
+  MetricsSchema m_schema;
+  std::ofstream m_stream;
+  std::string m_buffer;
+};
+
+/**
+ * \brief Comma separated text output, one row per line.
+ */
+class CsvMetricsOutput : public MetricsOutput
+{
+public:
+  CsvMetricsOutput (const std::string &path, const MetricsSchema &schema);
+  virtual void Format (const MetricsRecord &record);
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief Buffered, asynchronous writer for periodic metrics.
+ *
+ * Every output file is opened once and identified by a handle. Rows are
+ * appended into a bounded in-memory ring; a background thread drains the
+ * ring in blocks, formats the rows and writes each file in large chunks.
+ * When the ring is full, Append blocks until the writer has made room, so
+ * memory use stays bounded however far the simulation runs ahead of the disk.
+ *
+ * Close () drains everything and joins the writer thread. Simulations should
+ * register it with Simulator::ScheduleDestroy so that nothing is lost at
+ * Simulator::Destroy.
+ */
+class MetricsSink
+{
+public:
+  typedef uint32_t Handle;
+
+  /**
+   * \param capacity number of rows the ring can hold
+   * \param flushBlock number of buffered rows that wakes the writer thread
+   */
+  MetricsSink (uint32_t capacity = 8192, uint32_t flushBlock = 1024);
+  ~MetricsSink ();
+
+  /**
+   * Truncate \p path, write the CSV header line for \p schema and return a
+   * handle for appending rows to it.
+   */
+  Handle OpenCsv (const std::string &path, const MetricsSchema &schema);
+
+  /**
+   * Register an already opened output and return its handle. The sink takes
+   * ownership of \p output.
+   */
+  Handle Open (MetricsOutput *output);
+
+  /**
+   * Queue a row for the output identified by \p handle. Blocks while the
+   * ring is full.
+   */
+  void Append (Handle handle, const MetricsRecord &record);
+
+  /**
+   * Queue \p records[i] for the output \p handles[i], taking the lock and
+   * waking the writer once for the whole batch. Blocks while the ring is
+   * full.
+   */
+  void AppendBatch (const std::vector<Handle> &handles, const std::vector<MetricsRecord> &records);
+
+  /**
+   * Block until every queued row has been written and the files flushed.
+   */
+  void Flush (void);
+
+  /**
+   * Drain the ring, flush and close every output and stop the writer thread.
+   * Safe to call more than once.
+   */
+  void Close (void);
+
+  /**
+   * \returns how many times Append had to wait for the writer
+   */
+  uint64_t GetStalls (void) const
+  {
+    return m_stalls;
+  }
+
+private:
+  /// A ring slot
+  struct Slot
+  {
+    Handle handle;
+    MetricsRecord record;
+  };
+
+  void WriterLoop (void);
+
+  std::vector<MetricsOutput *> m_outputs; //!< outputs indexed by handle
+  std::vector<Slot> m_ring;          //!< preallocated ring of rows
+  uint32_t m_flushBlock;             //!< rows that wake the writer
+  uint64_t m_head;                   //!< next slot the producer writes
+  uint64_t m_tail;                   //!< next slot the writer reads
+  uint64_t m_flushRequests;          //!< Flush calls so far
+  uint64_t m_flushesDone;            //!< Flush calls served by the writer
+  bool m_closing;
+  bool m_closed;
+  uint64_t m_stalls;
+  std::mutex m_mutex;
+  std::condition_variable m_notEmpty; //!< wakes the writer
+  std::condition_variable m_notFull;  //!< wakes a blocked producer
+  std::condition_variable m_drained;  //!< wakes Flush
+  std::thread m_writer;
+};
+
+} // namespace ns3
+
+#endif /* METRICS_SINK_H */
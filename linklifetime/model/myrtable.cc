@@ -18,6 +18,7 @@
 #include <ns3/vector.h>
 #include "myrtable.h"
 #include "ns3/log.h"
+#include "hot-log.h"
 
 
 namespace ns3 {
@@ -111,32 +112,37 @@ RTable::GetListOfAllRoutes ()
         }
     }
  */
-	NS_LOG_DEBUG("============================Printing Table======================================");
+	// the walk only produces log output
+	if (!HOT_LOG_ENABLED (LOG_DEBUG))
+		return;
+	HOT_LOG_DEBUG("============================Printing Table======================================");
 	for (auto const map_entry : m_ipv4AddressEntry)
 	{
-		NS_LOG_DEBUG ("Source Address: " << map_entry.second.getMyAddress() << ", Destination Address: " << map_entry.second.getDestAddress() << ", TimeConnected: "
+		HOT_LOG_DEBUG ("Source Address: " << map_entry.second.getMyAddress() << ", Destination Address: " << map_entry.second.getDestAddress() << ", TimeConnected: "
 			<< map_entry.second.getTimeConnected() << "s, Time Last Packet Received At: " << map_entry.second.getTimePktRcvd().GetSeconds() <<
 			"s, Time First Packet Received At: " << map_entry.second.getTimeFirstPktRcvd().GetSeconds() << "s, My Current Location: "<< map_entry.second.getMyLocation()
 			<< ", Neighbor Node's Current Location: " << map_entry.second.getNeighborNodeLocation() <<", Neighbor Next Location: " << map_entry.second.getNextLoc()
 			<< ", Neighbor Next Time Interval: " << map_entry.second.getNextTime() << ", Link LifeTime: " << map_entry.second.getLinkLifeTime()
 			<< "s, Current Processing Speed: " << map_entry.second.getCurrProSpeed() << "GHz\n");
 	}
-	NS_LOG_DEBUG("============================Table Printing Ended======================================\n");
+	HOT_LOG_DEBUG("============================Table Printing Ended======================================\n");
 }
 
 void RTable::GetListofAllRoutes(Ipv4Address myAddress){
-	NS_LOG_DEBUG("============================Printing Table for " << myAddress << "======================================");
+	if (!HOT_LOG_ENABLED (LOG_DEBUG))
+		return;
+	HOT_LOG_DEBUG("============================Printing Table for " << myAddress << "======================================");
 	for (auto const map_entry : m_ipv4AddressEntry)
 	{
 		if(map_entry.second.getMyAddress() == myAddress)
-			NS_LOG_DEBUG ("Source Address: " << map_entry.second.getMyAddress() << ", Destination Address: " << map_entry.second.getDestAddress()
+			HOT_LOG_DEBUG ("Source Address: " << map_entry.second.getMyAddress() << ", Destination Address: " << map_entry.second.getDestAddress()
 				<< ", TimeConnected: " << map_entry.second.getTimeConnected() << "s, Time Last Packet Received At: " << map_entry.second.getTimePktRcvd().GetSeconds()
 				<< "s, Time First Packet Received At: " <<	map_entry.second.getTimeFirstPktRcvd().GetSeconds() << "s, My Current Location: " <<
 				map_entry.second.getMyLocation() << ", Neighbor Node's Current Location: " << map_entry.second.getNeighborNodeLocation() << ", Neighbor Next Location: "
 				<< map_entry.second.getNextLoc() << ", Neighbor Next Time Interval: " << map_entry.second.getNextTime() << ", Link LifeTime: "
 				<< map_entry.second.getLinkLifeTime() << "s, Current Processing Speed: " << map_entry.second.getCurrProSpeed() << "GHz\n");
 		}
-        NS_LOG_DEBUG("============================Table Printing Ended======================================\n");
+        HOT_LOG_DEBUG("============================Table Printing Ended======================================\n");
 }
 
 std::map<Ipv4Address, RTableEntry> RTable::GetAllRoutesWithIP(Ipv4Address address)
@@ -154,7 +160,8 @@ std::map<Ipv4Address, RTableEntry> RTable::GetAllRoutesWithIP(Ipv4Address addres
     return entries;
 }
 
-void RTable::GetInActiveRoutes(){
+uint32_t RTable::GetInActiveRoutes(){
+	uint32_t inActive = 0;
 	NS_LOG_DEBUG("============================ Printing Table Every Second To check InActive Routes ======================================");
 	for (auto const map_entry : m_ipv4AddressEntry)
 	{
@@ -162,6 +169,8 @@ void RTable::GetInActiveRoutes(){
 		double lastRcvdTime = map_entry.second.getTimePktRcvd().GetSeconds();
 		double inActiveTime = currTime - lastRcvdTime;
 		if(inActiveTime > 5.0)
+		{
+			inActive++;
 			NS_LOG_DEBUG ("Source/My Address: " << map_entry.second.getMyAddress() << ", Destination Address: " << map_entry.second.getDestAddress() << ", TimeConnected: "
 				<< map_entry.second.getTimeConnected() << "s, Time Last Packet Received At: " << map_entry.second.getTimePktRcvd().GetSeconds() <<
 				"s, Time First Packet Received At: " << map_entry.second.getTimeFirstPktRcvd().GetSeconds() << "s, My Current Location: "
@@ -169,13 +178,21 @@ void RTable::GetInActiveRoutes(){
 				", Neighbor Next Location: " << map_entry.second.getNextLoc() << ", Neighbor Next Time Interval: " << map_entry.second.getNextTime() <<
 				", Link LifeTime: " << map_entry.second.getLinkLifeTime() << "s, Current Processing Speed: " <<
 				map_entry.second.getCurrProSpeed() << "GHz\n");
+		}
 	}
 	NS_LOG_DEBUG("============================Table Printing Ended======================================\n");
+	return inActive;
 }
 
 bool
 RTable::DeleteRoute (Ipv4Address dst)
 {
+  typedef std::multimap<Ipv4Address, RTableEntry>::iterator MMapIt;
+  std::pair<MMapIt, MMapIt> result = m_ipv4AddressEntry.equal_range (dst);
+  for (MMapIt it = result.first; it != result.second; it++)
+    {
+      m_epochs[it->second.getMyAddress ()]++;
+    }
   if (m_ipv4AddressEntry.erase (dst) != 0)
     {
        NS_LOG_DEBUG("Route erased");
@@ -194,9 +211,17 @@ bool
 RTable::AddRoute (RTableEntry & rt)
 {
   m_ipv4AddressEntry.insert (std::make_pair (rt.getDestAddress(), rt));
+  m_epochs[rt.getMyAddress ()]++;
   return true;
 }
 
+uint64_t
+RTable::GetEpoch (Ipv4Address myAddress) const
+{
+  std::map<Ipv4Address, uint64_t>::const_iterator it = m_epochs.find (myAddress);
+  return it == m_epochs.end () ? 0 : it->second;
+}
+
 bool
 RTable::Update (RTableEntry & rt)
 {
@@ -211,6 +236,11 @@ RTable::Update (RTableEntry & rt)
   {
       if(it->second.getMyAddress() == rt.getMyAddress())
   {
+      if (it->second.getLinkLifeTime () != rt.getLinkLifeTime ()
+          || it->second.getCurrProSpeed () != rt.getCurrProSpeed ())
+        {
+          m_epochs[rt.getMyAddress ()]++;
+        }
       it->second = rt;
       return true;
   }
@@ -141,6 +141,8 @@ class RTable{
 private:
 	/// an entry in the routing table.
     std::multimap<Ipv4Address, RTableEntry> m_ipv4AddressEntry;
+	/// number of changes to the routes of each of my addresses
+	std::map<Ipv4Address, uint64_t> m_epochs;
 
 public:
 
@@ -191,13 +193,26 @@ public:
 
 	std::map<Ipv4Address, RTableEntry> GetAllRoutesWithIP(Ipv4Address address);
 
-	void GetInActiveRoutes();
+	/// Log the routes that have been silent for more than 5 s. \returns their number
+	uint32_t GetInActiveRoutes();
 	/// Delete all entries from routing table
 	void
 	Clear ()
 	{
 		m_ipv4AddressEntry.clear ();
+		for (std::map<Ipv4Address, uint64_t>::iterator it = m_epochs.begin (); it != m_epochs.end (); ++it)
+			it->second++;
 	}
+	/**
+	 * The epoch of the routes of a node changes whenever a route is added or
+	 * deleted, or an update changes its link lifetime or processing speed.
+	 * Updates that only refresh a route leave it as it is, so anything
+	 * derived from the routes can be kept until the epoch changes.
+	 * \param myAddress the address of the node
+	 * \returns the epoch of the routes of myAddress
+	 */
+	uint64_t
+	GetEpoch (Ipv4Address myAddress) const;
 	/**
 	 * Delete all outdated entries if Lifetime is expired
 	 * \param removedAddresses is the list of addresses to purge
@@ -109,11 +109,10 @@ OnOffApplication::OnOffApplication ()
     m_connected (false),
     m_residualBits (0),
     m_lastStartTime (Seconds (0)),
-    m_totBytes (0)
-
+    m_totBytes (0),
+    m_sent (0)
 {
   NS_LOG_FUNCTION (this);
-  m_sent[5] = {0};
 }
 
 OnOffApplication::~OnOffApplication()
@@ -292,11 +291,9 @@ void OnOffApplication::SendPacket ()
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (m_sendEvent.IsExpired ());
-  Ptr<Node> node = m_socket->GetNode();
-  uint16_t nodeID = node->GetId();
-  NS_LOG_INFO ("m_sent: " << m_sent[nodeID]);
+  NS_LOG_INFO ("m_sent: " << m_sent);
   SeqTsHeader seqTs;
-  seqTs.SetSeq (m_sent[nodeID]);
+  seqTs.SetSeq (m_sent);
   NS_LOG_DEBUG("Packet Size: " << m_pktSize);
   Ptr<Packet> packet = Create<Packet> (m_pktSize-(8+4));
   m_txTrace (packet);
@@ -308,13 +305,13 @@ void OnOffApplication::SendPacket ()
   m_socket->GetSockName (localAddress);
   if (InetSocketAddress::IsMatchingType (m_peer))
     {
-	  m_sent[nodeID]++;
+      m_sent++;
       NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
                    << "s on-off application sent "
                    <<  packet->GetSize () << " bytes to "
                    << InetSocketAddress::ConvertFrom(m_peer).GetIpv4 ()
                    << " port " << InetSocketAddress::ConvertFrom (m_peer).GetPort ()
-                   << " total Tx " << m_totBytes << " bytes and Sequence Number: " << m_sent[nodeID]);
+                   << " total Tx " << m_totBytes << " bytes and Sequence Number: " << m_sent);
       m_txTraceWithAddresses (packet, localAddress, InetSocketAddress::ConvertFrom (m_peer));
     }
   else if (Inet6SocketAddress::IsMatchingType (m_peer))
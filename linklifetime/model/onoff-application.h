@@ -163,7 +163,7 @@ private:
   EventId         m_startStopEvent;     //!< Event id for next start or stop event
   EventId         m_sendEvent;    //!< Event id of pending "send packet" event
   TypeId          m_tid;          //!< Type of the socket used
-  uint32_t 		  m_sent[5]; //!< Counter for sent packets
+  uint32_t        m_sent;         //!< Counter for sent packets
   /// Traced Callback: transmitted packets.
   TracedCallback<Ptr<const Packet> > m_txTrace;
 
@@ -0,0 +1,172 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * pcap-ring-capture.cc
+ *
+ *      Author: hassam
+ */
+
+#include "pcap-ring-capture.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/trace-helper.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-mac-header.h"
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PcapRingCapture");
+
+PcapRingCapture::PcapRingCapture (Time window, uint32_t maxFrames)
+  : m_window (window),
+    m_maxFrames (maxFrames == 0 ? 1 : maxFrames),
+    m_classMask (0),
+    m_dumps (0),
+    m_lastDump (Seconds (-1) - window)
+{
+}
+
+void
+PcapRingCapture::AddClassFilter (TrafficClassTag::TrafficClass trafficClass)
+{
+  m_classMask |= 1u << trafficClass;
+}
+
+void
+PcapRingCapture::AddAddressFilter (Mac48Address address)
+{
+  m_addresses.push_back (address);
+}
+
+void
+PcapRingCapture::Install (NetDeviceContainer devices)
+{
+  for (NetDeviceContainer::Iterator i = devices.Begin (); i != devices.End (); ++i)
+    {
+      Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (*i);
+      if (device == 0)
+        {
+          continue;
+        }
+      DeviceRing ring;
+      ring.node = device->GetNode ()->GetId ();
+      ring.device = device->GetIfIndex ();
+      m_rings.push_back (ring);
+      uint32_t index = m_rings.size () - 1;
+      device->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferTx",
+                                                     MakeBoundCallback (&PcapRingCapture::SniffTx, this, index));
+      device->GetPhy ()->TraceConnectWithoutContext ("MonitorSnifferRx",
+                                                     MakeBoundCallback (&PcapRingCapture::SniffRx, this, index));
+    }
+}
+
+void
+PcapRingCapture::SniffTx (PcapRingCapture *capture, uint32_t ring, Ptr<const Packet> packet,
+                          uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu)
+{
+  capture->Capture (ring, packet);
+}
+
+void
+PcapRingCapture::SniffRx (PcapRingCapture *capture, uint32_t ring, Ptr<const Packet> packet,
+                          uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu,
+                          SignalNoiseDbm signalNoise)
+{
+  capture->Capture (ring, packet);
+}
+
+bool
+PcapRingCapture::Accept (Ptr<const Packet> packet) const
+{
+  if (m_classMask != 0)
+    {
+      TrafficClassTag tag;
+      uint32_t trafficClass = packet->PeekPacketTag (tag) ? tag.GetTrafficClass () : TrafficClassTag::UNKNOWN;
+      if ((m_classMask & (1u << trafficClass)) == 0)
+        {
+          return false;
+        }
+    }
+  if (!m_addresses.empty ())
+    {
+      WifiMacHeader hdr;
+      if (!packet->PeekHeader (hdr))
+        {
+          return false;
+        }
+      for (std::size_t i = 0; i < m_addresses.size (); i++)
+        {
+          if (hdr.GetAddr1 () == m_addresses[i] || hdr.GetAddr2 () == m_addresses[i])
+            {
+              return true;
+            }
+        }
+      return false;
+    }
+  return true;
+}
+
+void
+PcapRingCapture::Capture (uint32_t ring, Ptr<const Packet> packet)
+{
+  if (!Accept (packet))
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  std::deque<Frame> &frames = m_rings[ring].frames;
+  while (!frames.empty () && (frames.size () >= m_maxFrames || frames.front ().time < now - m_window))
+    {
+      frames.pop_front ();
+    }
+  Frame frame;
+  frame.time = now;
+  frame.packet = packet;
+  frames.push_back (frame);
+}
+
+uint32_t
+PcapRingCapture::Trigger (const std::string &prefix, const std::string &reason)
+{
+  if (Simulator::Now () - m_lastDump < m_window)
+    {
+      return 0;
+    }
+  return Dump (prefix, reason);
+}
+
+uint32_t
+PcapRingCapture::Dump (const std::string &prefix, const std::string &reason)
+{
+  Time now = Simulator::Now ();
+  PcapHelper pcapHelper;
+  uint32_t written = 0;
+  for (std::size_t r = 0; r < m_rings.size (); r++)
+    {
+      std::deque<Frame> &frames = m_rings[r].frames;
+      while (!frames.empty () && frames.front ().time < now - m_window)
+        {
+          frames.pop_front ();
+        }
+      if (frames.empty ())
+        {
+          continue;
+        }
+      std::ostringstream name;
+      name << prefix << "-" << m_dumps << "-" << reason << "-" << m_rings[r].node << "-" << m_rings[r].device << ".pcap";
+      Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (name.str (), std::ios::out, PcapHelper::DLT_IEEE802_11);
+      for (std::deque<Frame>::const_iterator f = frames.begin (); f != frames.end (); ++f)
+        {
+          file->Write (f->time, f->packet);
+        }
+      written += frames.size ();
+      frames.clear ();
+    }
+  NS_LOG_INFO ("Capture dump " << m_dumps << " (" << reason << ") wrote " << written << " frames");
+  m_dumps++;
+  m_lastDump = now;
+  return written;
+}
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * pcap-ring-capture.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef PCAP_RING_CAPTURE_H
+#define PCAP_RING_CAPTURE_H
+
+#include "traffic-class-tag.h"
+#include "ns3/net-device-container.h"
+#include "ns3/mac48-address.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/wifi-tx-vector.h"
+#include "ns3/wifi-phy.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief Keeps the last frames of Wi-Fi devices in memory and writes them
+ * to pcap files only when asked to.
+ *
+ * Every device sniffed by Install gets a ring holding the frames it sent or
+ * received during the last \p window, but never more than \p maxFrames.
+ * Frames are kept as packet references, so capturing one costs a tag or
+ * header lookup when filters are set and a deque push; nothing is
+ * serialized until Dump (). Frames can be restricted to some traffic
+ * classes (from their TrafficClassTag, untagged frames count as UNKNOWN) and
+ * to frames sent to or from some MAC addresses.
+ *
+ * Dump writes one DLT_IEEE802_11 pcap file per device that holds frames,
+ * named <prefix>-<dump>-<reason>-<node>-<device>.pcap, and empties the rings.
+ */
+class PcapRingCapture
+{
+public:
+  /**
+   * \param window how long frames are kept
+   * \param maxFrames most frames kept per device
+   */
+  PcapRingCapture (Time window, uint32_t maxFrames = 16384);
+
+  /**
+   * Only keep frames of \p trafficClass; call once per class to keep.
+   * Without any call every class is kept.
+   */
+  void AddClassFilter (TrafficClassTag::TrafficClass trafficClass);
+  /**
+   * Only keep frames whose receiver or transmitter is \p address; call once
+   * per address to keep. Without any call every address is kept.
+   */
+  void AddAddressFilter (Mac48Address address);
+
+  /// Start capturing on every WifiNetDevice of \p devices
+  void Install (NetDeviceContainer devices);
+
+  /**
+   * Dump unless the previous dump is less than one window old, so that a
+   * burst of triggers yields a single set of files.
+   * \returns the number of frames written
+   */
+  uint32_t Trigger (const std::string &prefix, const std::string &reason);
+  /// Write every ring to pcap files and empty them. \returns the number of frames written
+  uint32_t Dump (const std::string &prefix, const std::string &reason);
+
+private:
+  /// A captured frame
+  struct Frame
+  {
+    Time time;
+    Ptr<const Packet> packet;
+  };
+  /// The frames of one device
+  struct DeviceRing
+  {
+    uint32_t node;
+    uint32_t device;
+    std::deque<Frame> frames;
+  };
+
+  static void SniffTx (PcapRingCapture *capture, uint32_t ring, Ptr<const Packet> packet,
+                       uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu);
+  static void SniffRx (PcapRingCapture *capture, uint32_t ring, Ptr<const Packet> packet,
+                       uint16_t channelFreqMhz, WifiTxVector txVector, MpduInfo aMpdu,
+                       SignalNoiseDbm signalNoise);
+  void Capture (uint32_t ring, Ptr<const Packet> packet);
+  bool Accept (Ptr<const Packet> packet) const;
+
+  Time m_window;
+  uint32_t m_maxFrames;
+  uint32_t m_classMask;                 //!< bit per accepted TrafficClass, 0 for all
+  std::vector<Mac48Address> m_addresses; //!< accepted addresses, empty for all
+  std::vector<DeviceRing> m_rings;
+  uint32_t m_dumps;                     //!< dumps written so far
+  Time m_lastDump;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_RING_CAPTURE_H */
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * resource-allocator.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef RESOURCE_ALLOCATOR_H
+#define RESOURCE_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdint.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+
+/**
+ * One task offered to one neighbour. Sizes and rates only need to share a
+ * unit: manet-routing-compare uses Mbit and Mbps, main.cpp and dce-iperf MB
+ * and MB/s.
+ */
+struct SplitRequest
+{
+  double size;
+  double deadline;      //!< seconds
+  double rateW;         //!< rate of the Wi-Fi link
+  double rateWD;        //!< rate of the Wi-Fi Direct link
+  double usableW;       //!< seconds the Wi-Fi link can be used: the deadline or its lifetime, if shorter
+  double usableWD;      //!< seconds the Wi-Fi Direct link can be used
+  double delayW;        //!< seconds of delay per unit of data on Wi-Fi, 0 to ignore delays
+  double delayWD;       //!< seconds of delay per unit of data on Wi-Fi Direct
+};
+
+/// How a task is split between the Wi-Fi and Wi-Fi Direct links of a neighbour
+struct SplitResult
+{
+  bool feasible;
+  bool wdFirst;         //!< the larger share goes over Wi-Fi Direct
+  double finalData;     //!< larger share, sent first
+  double remainingData; //!< share left for the other interface
+  double transferTimeW; //!< seconds to send the whole task over Wi-Fi
+  double transferTimeWD; //!< seconds to send the whole task over Wi-Fi Direct
+  double firstTime;     //!< seconds the larger share is sent for
+  double remainingTime; //!< seconds to send the remaining share
+  double completion;    //!< seconds until the whole task is sent
+};
+
+/// Many SplitRequest laid out as one array per field
+struct SplitBatchInput
+{
+  const double *size;
+  const double *deadline;
+  const double *rateW;
+  const double *rateWD;
+  const double *usableW;
+  const double *usableWD;
+  const double *delayW;
+  const double *delayWD;
+};
+
+/// Many SplitResult laid out as one array per field, without the timings of the single interfaces
+struct SplitBatchOutput
+{
+  uint8_t *feasible;
+  uint8_t *wdFirst;
+  double *finalData;
+  double *remainingData;
+  double *completion;
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief The Wi-Fi / Wi-Fi Direct split of a task over one neighbour.
+ *
+ * Each link carries at most its rate times the time it can be used, less
+ * its delay. The link that carries more takes that much of the task and the
+ * other link the rest, and the split is feasible when the rest can be sent
+ * before the deadline. Header only, without any ns-3 dependency, so that
+ * main.cpp, dce-iperf, manet-routing-compare and the
+ * resource-allocator-benchmark example share it.
+ *
+ * SplitBatch computes the splits of many (task, neighbour) pairs at once,
+ * without branches: with AVX2 enabled at compile time (-mavx2) four pairs at
+ * a time with min, max and blend instructions, otherwise with a select-only
+ * loop the compiler can vectorize. Split is its scalar reference; the two
+ * only differ by the rounding of fused multiply-adds where the compiler
+ * contracts them.
+ */
+class ResourceAllocator
+{
+public:
+  static SplitResult Split (const SplitRequest &r)
+  {
+    SplitResult s;
+    s.transferTimeW = r.size / r.rateW + r.size * r.delayW;
+    s.transferTimeWD = r.size / r.rateWD + r.size * r.delayWD;
+    double maxDataW = std::min (r.rateW * (r.usableW - r.usableW * r.delayW), r.size);
+    double maxDataWD = std::min (r.rateWD * (r.usableWD - r.usableWD * r.delayWD), r.size);
+    s.wdFirst = maxDataWD > maxDataW;
+    s.finalData = s.wdFirst ? maxDataWD : maxDataW;
+    s.remainingData = r.size - s.finalData;
+    s.remainingTime = s.remainingData / (s.wdFirst ? r.rateW : r.rateWD);
+    s.feasible = s.remainingData + s.finalData >= r.size && s.remainingTime <= r.deadline;
+
+    double transferTime = s.wdFirst ? s.transferTimeWD : s.transferTimeW;
+    double usable = s.wdFirst ? r.usableWD : r.usableW;
+    s.firstTime = transferTime < r.deadline ? transferTime : usable;
+    s.completion = transferTime < r.deadline ? transferTime : std::max (usable, s.remainingTime);
+    return s;
+  }
+
+  /// Compute the splits of the \p n pairs of \p in into \p out
+  static void SplitBatch (std::size_t n, const SplitBatchInput &in, const SplitBatchOutput &out)
+  {
+    std::size_t i = 0;
+#ifdef __AVX2__
+    for (; i + 4 <= n; i += 4)
+      {
+        __m256d size = _mm256_loadu_pd (in.size + i);
+        __m256d deadline = _mm256_loadu_pd (in.deadline + i);
+        __m256d rateW = _mm256_loadu_pd (in.rateW + i);
+        __m256d rateWD = _mm256_loadu_pd (in.rateWD + i);
+        __m256d usableW = _mm256_loadu_pd (in.usableW + i);
+        __m256d usableWD = _mm256_loadu_pd (in.usableWD + i);
+        __m256d delayW = _mm256_loadu_pd (in.delayW + i);
+        __m256d delayWD = _mm256_loadu_pd (in.delayWD + i);
+
+        __m256d timeW = _mm256_add_pd (_mm256_div_pd (size, rateW), _mm256_mul_pd (size, delayW));
+        __m256d timeWD = _mm256_add_pd (_mm256_div_pd (size, rateWD), _mm256_mul_pd (size, delayWD));
+        __m256d maxW = _mm256_min_pd (_mm256_mul_pd (rateW, _mm256_sub_pd (usableW, _mm256_mul_pd (usableW, delayW))), size);
+        __m256d maxWD = _mm256_min_pd (_mm256_mul_pd (rateWD, _mm256_sub_pd (usableWD, _mm256_mul_pd (usableWD, delayWD))), size);
+        __m256d wd = _mm256_cmp_pd (maxWD, maxW, _CMP_GT_OQ);
+        __m256d finalData = _mm256_blendv_pd (maxW, maxWD, wd);
+        __m256d remaining = _mm256_sub_pd (size, finalData);
+        __m256d remainingTime = _mm256_div_pd (remaining, _mm256_blendv_pd (rateWD, rateW, wd));
+        __m256d feasible = _mm256_and_pd (_mm256_cmp_pd (_mm256_add_pd (remaining, finalData), size, _CMP_GE_OQ),
+                                          _mm256_cmp_pd (remainingTime, deadline, _CMP_LE_OQ));
+        __m256d time = _mm256_blendv_pd (timeW, timeWD, wd);
+        __m256d usable = _mm256_blendv_pd (usableW, usableWD, wd);
+        __m256d completion = _mm256_blendv_pd (_mm256_max_pd (usable, remainingTime), time,
+                                               _mm256_cmp_pd (time, deadline, _CMP_LT_OQ));
+
+        _mm256_storeu_pd (out.finalData + i, finalData);
+        _mm256_storeu_pd (out.remainingData + i, remaining);
+        _mm256_storeu_pd (out.completion + i, completion);
+        int feasibleBits = _mm256_movemask_pd (feasible);
+        int wdBits = _mm256_movemask_pd (wd);
+        for (int k = 0; k < 4; k++)
+          {
+            out.feasible[i + k] = (feasibleBits >> k) & 1;
+            out.wdFirst[i + k] = (wdBits >> k) & 1;
+          }
+      }
+#endif
+    for (; i < n; i++)
+      {
+        double size = in.size[i];
+        double timeW = size / in.rateW[i] + size * in.delayW[i];
+        double timeWD = size / in.rateWD[i] + size * in.delayWD[i];
+        double maxW = std::min (in.rateW[i] * (in.usableW[i] - in.usableW[i] * in.delayW[i]), size);
+        double maxWD = std::min (in.rateWD[i] * (in.usableWD[i] - in.usableWD[i] * in.delayWD[i]), size);
+        bool wd = maxWD > maxW;
+        double finalData = wd ? maxWD : maxW;
+        double remaining = size - finalData;
+        double remainingTime = remaining / (wd ? in.rateW[i] : in.rateWD[i]);
+        double time = wd ? timeWD : timeW;
+        double usable = wd ? in.usableWD[i] : in.usableW[i];
+        out.feasible[i] = (remaining + finalData >= size) & (remainingTime <= in.deadline[i]);
+        out.wdFirst[i] = wd;
+        out.finalData[i] = finalData;
+        out.remainingData[i] = remaining;
+        out.completion[i] = time < in.deadline[i] ? time : std::max (usable, remainingTime);
+      }
+  }
+};
+
+} // namespace ns3
+
+#endif /* RESOURCE_ALLOCATOR_H */
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * task-tracker.cc
+ *
+ *      Author: hassam
+ */
+
+#include "task-tracker.h"
+#include <algorithm>
+
+namespace ns3 {
+
+TaskTracker::TaskTracker (uint64_t slackBytes)
+  : m_slackBytes (slackBytes),
+    m_execution (false),
+    m_sink (0),
+    m_handle (0)
+{
+}
+
+MetricsSchema
+TaskTracker::GetSchema (void)
+{
+  static const MetricsColumn columns[] = {
+    {"TaskId", METRICS_U64},
+    {"SourceNode", METRICS_U64},
+    {"Allocated", METRICS_U64},
+    {"Completed", METRICS_U64},
+    {"DeadlineMet", METRICS_U64},
+    {"CreateTime", METRICS_F64},
+    {"AllocationLatency", METRICS_F64},
+    {"TransferStart", METRICS_F64},
+    {"PredictedCompletion", METRICS_F64},
+    {"ActualCompletion", METRICS_F64},
+    {"TransferTime", METRICS_F64},
+    {"Deadline", METRICS_F64},
+    {"PlannedBytes", METRICS_U64},
+    {"DeliveredBytesW", METRICS_U64},
+    {"DeliveredBytesWD", METRICS_U64},
+    {"Goodput", METRICS_F64},
+    {"ExecutionStart", METRICS_F64},
+    {"ExecutionEnd", METRICS_F64},
+    {"ResultReturned", METRICS_F64},
+    {"OffloadLatency", METRICS_F64}
+  };
+  return MetricsSchema (columns, columns + sizeof (columns) / sizeof (columns[0]));
+}
+
+void
+TaskTracker::SetOutput (MetricsSink *sink, MetricsSink::Handle handle)
+{
+  m_sink = sink;
+  m_handle = handle;
+}
+
+void
+TaskTracker::SetExecution (bool execution)
+{
+  m_execution = execution;
+}
+
+void
+TaskTracker::Create (uint32_t taskId, Time now)
+{
+  TaskRecord task;
+  task.created = now;
+  m_tasks[taskId] = task;
+}
+
+void
+TaskTracker::Allocate (uint32_t taskId, uint32_t sourceNode, Time now, Time deadline,
+                       uint64_t plannedBytes, Time predictedCompletion)
+{
+  TaskRecord &task = m_tasks[taskId];
+  task.sourceNode = sourceNode;
+  task.allocated = true;
+  task.assigned = now;
+  task.transferStart = now;
+  task.deadline = now + deadline;
+  task.plannedBytes = plannedBytes;
+  task.predictedCompletion = predictedCompletion;
+}
+
+void
+TaskTracker::Reject (uint32_t taskId, uint32_t sourceNode, Time now, Time deadline)
+{
+  std::map<uint32_t, TaskRecord>::iterator it = m_tasks.find (taskId);
+  TaskRecord task = it == m_tasks.end () ? TaskRecord () : it->second;
+  task.sourceNode = sourceNode;
+  task.assigned = now;
+  task.deadline = now + deadline;
+  Emit (taskId, task, false);
+  if (it != m_tasks.end ())
+    {
+      m_tasks.erase (it);
+    }
+}
+
+bool
+TaskTracker::Deliver (uint32_t taskId, TrafficClassTag::InterfaceKind iface, uint32_t bytes, Time now,
+                      uint32_t receiver)
+{
+  std::map<uint32_t, TaskRecord>::iterator it = m_tasks.find (taskId);
+  if (it == m_tasks.end () || !it->second.allocated || it->second.transferred)
+    {
+      // stragglers of a task already delivered
+      return false;
+    }
+  TaskRecord &task = it->second;
+  task.deliveredBytes[iface == TrafficClassTag::IFACE_WD ? 1 : 0] += bytes;
+  task.lastByte = now;
+  if (m_execution)
+    {
+      task.received[receiver] += bytes;
+    }
+  if (task.deliveredBytes[0] + task.deliveredBytes[1] + m_slackBytes < task.plannedBytes)
+    {
+      return false;
+    }
+  task.transferred = true;
+  if (!m_execution)
+    {
+      Emit (taskId, task, true);
+      m_tasks.erase (it);
+    }
+  return true;
+}
+
+void
+TaskTracker::Execute (uint32_t taskId, Time start, Time end)
+{
+  std::map<uint32_t, TaskRecord>::iterator it = m_tasks.find (taskId);
+  if (it == m_tasks.end ())
+    {
+      return;
+    }
+  TaskRecord &task = it->second;
+  if (task.executionEnd.IsZero () || start < task.executionStart)
+    {
+      task.executionStart = start;
+    }
+  task.executionEnd = std::max (task.executionEnd, end);
+}
+
+void
+TaskTracker::ExpectResult (uint32_t taskId, uint64_t bytes)
+{
+  std::map<uint32_t, TaskRecord>::iterator it = m_tasks.find (taskId);
+  if (it != m_tasks.end ())
+    {
+      it->second.resultBytes += bytes;
+    }
+}
+
+void
+TaskTracker::DeliverResult (uint32_t taskId, uint32_t bytes, Time now)
+{
+  std::map<uint32_t, TaskRecord>::iterator it = m_tasks.find (taskId);
+  if (it == m_tasks.end () || !it->second.transferred)
+    {
+      return;
+    }
+  TaskRecord &task = it->second;
+  task.returnedBytes += bytes;
+  task.resultReturned = now;
+  if (task.returnedBytes + m_slackBytes >= task.resultBytes)
+    {
+      Emit (taskId, task, true);
+      m_tasks.erase (it);
+    }
+}
+
+bool
+TaskTracker::IsInFlight (uint32_t taskId) const
+{
+  std::map<uint32_t, TaskRecord>::const_iterator it = m_tasks.find (taskId);
+  return it != m_tasks.end () && it->second.allocated;
+}
+
+Time
+TaskTracker::GetDeadline (uint32_t taskId) const
+{
+  std::map<uint32_t, TaskRecord>::const_iterator it = m_tasks.find (taskId);
+  return it != m_tasks.end () && it->second.allocated ? it->second.deadline : Time ();
+}
+
+uint32_t
+TaskTracker::GetSourceNode (uint32_t taskId) const
+{
+  std::map<uint32_t, TaskRecord>::const_iterator it = m_tasks.find (taskId);
+  return it != m_tasks.end () ? it->second.sourceNode : 0;
+}
+
+std::map<uint32_t, uint64_t>
+TaskTracker::GetReceived (uint32_t taskId) const
+{
+  std::map<uint32_t, TaskRecord>::const_iterator it = m_tasks.find (taskId);
+  return it != m_tasks.end () ? it->second.received : std::map<uint32_t, uint64_t> ();
+}
+
+void
+TaskTracker::Finish (void)
+{
+  for (std::map<uint32_t, TaskRecord>::const_iterator it = m_tasks.begin (); it != m_tasks.end (); ++it)
+    {
+      if (it->second.allocated)
+        {
+          Emit (it->first, it->second, false);
+        }
+    }
+  m_tasks.clear ();
+}
+
+void
+TaskTracker::Emit (uint32_t taskId, const TaskRecord &task, bool completed)
+{
+  if (m_sink == 0)
+    {
+      return;
+    }
+  uint64_t delivered = task.deliveredBytes[0] + task.deliveredBytes[1];
+  double transferTime = delivered == 0 ? 0 : (task.lastByte - task.transferStart).GetSeconds ();
+  // with execution a task is done when its results are back
+  Time done = m_execution ? task.resultReturned : task.lastByte;
+  bool executed = !task.executionEnd.IsZero ();
+  MetricsRecord row;
+  row << taskId
+      << task.sourceNode
+      << (task.allocated ? 1u : 0u)
+      << (completed ? 1u : 0u)
+      << (completed && done <= task.deadline ? 1u : 0u)
+      << task.created.GetSeconds ()
+      << (task.assigned - task.created).GetSeconds ()
+      << (task.allocated ? task.transferStart.GetSeconds () : 0.0)
+      << (task.allocated ? task.predictedCompletion.GetSeconds () : 0.0)
+      << (completed ? task.lastByte.GetSeconds () : 0.0)
+      << transferTime
+      << task.deadline.GetSeconds ()
+      << task.plannedBytes
+      << task.deliveredBytes[0]
+      << task.deliveredBytes[1]
+      << (transferTime > 0 ? delivered * 8.0 / 1e6 / transferTime : 0.0)
+      << (executed ? task.executionStart.GetSeconds () : 0.0)
+      << (executed ? task.executionEnd.GetSeconds () : 0.0)
+      << (completed && m_execution ? task.resultReturned.GetSeconds () : 0.0)
+      << (completed ? (done - task.created).GetSeconds () : 0.0);
+  m_sink->Append (m_handle, row);
+}
+
+} // namespace ns3
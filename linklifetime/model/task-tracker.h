@@ -0,0 +1,123 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * task-tracker.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef TASK_TRACKER_H
+#define TASK_TRACKER_H
+
+#include "metrics-sink.h"
+#include "traffic-class-tag.h"
+#include "ns3/nstime.h"
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \ingroup linklifetime
+ * \brief End-to-end progress of one offloaded task.
+ */
+struct TaskRecord
+{
+  uint32_t sourceNode = 0;
+  bool allocated = false;
+  Time created;               //!< task entered the queue
+  Time assigned;              //!< allocator ran for the task
+  Time transferStart;         //!< first application was started
+  Time predictedCompletion;   //!< completion the allocator expected
+  Time deadline;              //!< absolute deadline
+  Time lastByte;              //!< latest delivery of one of its bytes
+  uint64_t plannedBytes = 0;
+  uint64_t deliveredBytes[2] = {0, 0}; //!< indexed by TrafficClassTag::InterfaceKind
+  bool transferred = false;   //!< all planned bytes arrived
+  std::map<uint32_t, uint64_t> received; //!< bytes delivered to each receiving node, with execution
+  Time executionStart;        //!< first of its parts started to run on a neighbour
+  Time executionEnd;          //!< last of its parts finished running
+  Time resultReturned;        //!< last byte of its results arrived back at the source
+  uint64_t resultBytes = 0;   //!< bytes of results expected back
+  uint64_t returnedBytes = 0;
+};
+
+/**
+ * \ingroup linklifetime
+ * \brief Follows every task from its creation to the delivery of its last byte.
+ *
+ * Application packets carry their task id in a TrafficClassTag, so the
+ * receivers report delivered bytes with Deliver () whichever interface they
+ * came over. A task is complete once it is short of its planned bytes by no
+ * more than the slack, which covers the partial last packet an application
+ * does not send. One row per task is written to the output set with
+ * SetOutput: when the task completes, when the allocator fails to place it,
+ * or at Finish () for tasks still in flight.
+ *
+ * With SetExecution (true) the task is not complete on delivery: it runs on
+ * the neighbours that received it, reported with Execute (), and completes
+ * once the results announced with ExpectResult () are back at the source.
+ */
+class TaskTracker
+{
+public:
+  /**
+   * \param slackBytes bytes a task may fall short of its plan and still be complete
+   */
+  TaskTracker (uint64_t slackBytes = 0);
+
+  /// \returns the columns of the rows written by the tracker
+  static MetricsSchema GetSchema (void);
+
+  /// Write the rows to \p handle of \p sink
+  void SetOutput (MetricsSink *sink, MetricsSink::Handle handle);
+  /// Wait for the results of the tasks before completing them
+  void SetExecution (bool execution);
+
+  /// Task \p taskId entered the queue
+  void Create (uint32_t taskId, Time now);
+  /**
+   * The allocator placed task \p taskId of \p sourceNode, due \p deadline
+   * after \p now, and expects its \p plannedBytes to arrive by
+   * \p predictedCompletion.
+   */
+  void Allocate (uint32_t taskId, uint32_t sourceNode, Time now, Time deadline,
+                 uint64_t plannedBytes, Time predictedCompletion);
+  /// The allocator could not place task \p taskId of \p sourceNode
+  void Reject (uint32_t taskId, uint32_t sourceNode, Time now, Time deadline);
+  /**
+   * \p bytes of task \p taskId arrived over \p iface at node \p receiver
+   * \returns true if they were the last planned bytes of the task
+   */
+  bool Deliver (uint32_t taskId, TrafficClassTag::InterfaceKind iface, uint32_t bytes, Time now,
+                uint32_t receiver);
+  /// A part of task \p taskId runs on a neighbour from \p start to \p end
+  void Execute (uint32_t taskId, Time start, Time end);
+  /// \p bytes of results of task \p taskId will be sent back to its source
+  void ExpectResult (uint32_t taskId, uint64_t bytes);
+  /// \p bytes of results of task \p taskId arrived back at its source
+  void DeliverResult (uint32_t taskId, uint32_t bytes, Time now);
+
+  /// \returns true if task \p taskId is allocated and not yet complete
+  bool IsInFlight (uint32_t taskId) const;
+  /// \returns the absolute deadline of task \p taskId while it is in flight, zero otherwise
+  Time GetDeadline (uint32_t taskId) const;
+  /// \returns the node task \p taskId was offloaded from
+  uint32_t GetSourceNode (uint32_t taskId) const;
+  /// \returns the bytes of task \p taskId each node received, with execution
+  std::map<uint32_t, uint64_t> GetReceived (uint32_t taskId) const;
+
+  /// Write the rows of the tasks still in flight
+  void Finish (void);
+
+private:
+  void Emit (uint32_t taskId, const TaskRecord &task, bool completed);
+
+  uint64_t m_slackBytes;
+  bool m_execution;
+  std::map<uint32_t, TaskRecord> m_tasks; //!< tasks not written yet
+  MetricsSink *m_sink;
+  MetricsSink::Handle m_handle;
+};
+
+} // namespace ns3
+
+#endif /* TASK_TRACKER_H */
@@ -0,0 +1,69 @@
+/*
+ * traffic-class-tag.cc
+ *
+ *      Author: hassam
+ */
+
+#include "traffic-class-tag.h"
+
+namespace ns3{
+NS_OBJECT_ENSURE_REGISTERED(TrafficClassTag);
+
+TrafficClassTag::TrafficClassTag()
+: m_trafficClass (UNKNOWN),
+  m_taskId (0),
+  m_iface (IFACE_W)
+{
+}
+
+TrafficClassTag::TrafficClassTag(TrafficClass trafficClass, uint32_t taskId, InterfaceKind iface)
+: m_trafficClass (trafficClass),
+  m_taskId (taskId),
+  m_iface (iface)
+{
+}
+
+TypeId
+TrafficClassTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TrafficClassTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Linklifetime")
+    .AddConstructor<TrafficClassTag> ();
+  return tid;
+}
+
+TypeId
+TrafficClassTag::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+TrafficClassTag::GetSerializedSize () const
+{
+  return 6;
+}
+
+void
+TrafficClassTag::Serialize (TagBuffer i) const
+{
+  i.WriteU8 (m_trafficClass);
+  i.WriteU32 (m_taskId);
+  i.WriteU8 (m_iface);
+}
+
+void
+TrafficClassTag::Deserialize (TagBuffer i)
+{
+  m_trafficClass = i.ReadU8 ();
+  m_taskId = i.ReadU32 ();
+  m_iface = i.ReadU8 ();
+}
+
+void
+TrafficClassTag::Print (std::ostream &os) const
+{
+  os << "Traffic Class: " << (uint32_t) m_trafficClass << ", Task ID: " << m_taskId << ", Interface: " << (m_iface == IFACE_W ? "W" : "WD");
+}
+}
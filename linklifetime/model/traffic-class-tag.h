@@ -0,0 +1,94 @@
+/*
+ * traffic-class-tag.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef TRAFFIC_CLASS_TAG_H_
+#define TRAFFIC_CLASS_TAG_H_
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+/**
+ * \ingroup linklifetime
+ *
+ * \brief Packet tag carrying the traffic class of a packet.
+ *
+ * Attached by the discovery service, the reply path and the application
+ * senders so that the sniffer and drop traces can classify a frame with a
+ * single PeekPacketTag lookup instead of guessing from its size.
+ */
+class TrafficClassTag : public Tag
+{
+public:
+	enum TrafficClass
+	{
+		UNKNOWN = 0,
+		DISCOVERY = 1,
+		REPLY = 2,
+		APPLICATION = 3,
+		RESULT = 4 //!< result of an offloaded task, sent back to its source
+	};
+
+	enum InterfaceKind
+	{
+		IFACE_W = 0,
+		IFACE_WD = 1
+	};
+
+	TrafficClassTag ();
+	TrafficClassTag (TrafficClass trafficClass, uint32_t taskId, InterfaceKind iface);
+
+	/**
+	 * \param trafficClass the class of the tagged packet
+	 */
+	void SetTrafficClass (TrafficClass trafficClass){
+		m_trafficClass = trafficClass;
+	}
+	/**
+	 * \param taskId the task the tagged packet belongs to
+	 */
+	void SetTaskId (uint32_t taskId){
+		m_taskId = taskId;
+	}
+	/**
+	 * \param iface the interface (Wi-Fi or Wi-Fi Direct) the packet was sent on
+	 */
+	void SetInterfaceKind (InterfaceKind iface){
+		m_iface = iface;
+	}
+	/**
+	 * \returns the class of the tagged packet
+	 */
+	TrafficClass GetTrafficClass () const{
+		return static_cast<TrafficClass> (m_trafficClass);
+	}
+	/**
+	 * \returns the task the tagged packet belongs to
+	 */
+	uint32_t GetTaskId () const{
+		return m_taskId;
+	}
+	/**
+	 * \returns the interface the packet was sent on
+	 */
+	InterfaceKind GetInterfaceKind () const{
+		return static_cast<InterfaceKind> (m_iface);
+	}
+
+	static TypeId GetTypeId (void);
+	virtual TypeId GetInstanceTypeId (void) const;
+	virtual uint32_t GetSerializedSize (void) const;
+	virtual void Serialize (TagBuffer i) const;
+	virtual void Deserialize (TagBuffer i);
+	virtual void Print (std::ostream &os) const;
+
+private:
+	uint8_t m_trafficClass; //!< one of TrafficClass
+	uint32_t m_taskId; //!< task id, only meaningful for application traffic
+	uint8_t m_iface; //!< one of InterfaceKind
+};
+}
+
+#endif /* TRAFFIC_CLASS_TAG_H_ */
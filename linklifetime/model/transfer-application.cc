@@ -0,0 +1,284 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * transfer-application.cc
+ *
+ *      Author: hassam
+ */
+
+#include "transfer-application.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/socket-factory.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/seq-ts-header.h"
+#include "ns3/traffic-class-tag.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TransferApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (TransferApplication);
+
+TypeId
+TransferApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TransferApplication")
+    .SetParent<Application> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<TransferApplication> ()
+    .AddAttribute ("PacketSize", "The size of the packets of a transfer, "
+                   "the last one may be shorter.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&TransferApplication::m_pktSize),
+                   MakeUintegerChecker<uint32_t> (SeqTsHeader ().GetSerializedSize ()))
+    .AddAttribute ("Protocol", "The type of protocol to use. This should be "
+                   "a subclass of ns3::SocketFactory",
+                   TypeIdValue (UdpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&TransferApplication::m_tid),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("InterfaceKind", "The interface kind (0 = Wi-Fi, 1 = Wi-Fi Direct) "
+                   "attached to every packet in a TrafficClassTag.",
+                   UintegerValue (TrafficClassTag::IFACE_W),
+                   MakeUintegerAccessor (&TransferApplication::m_ifaceKind),
+                   MakeUintegerChecker<uint32_t> (TrafficClassTag::IFACE_W, TrafficClassTag::IFACE_WD))
+    .AddAttribute ("MaxActiveTransfers", "The most transfers sent at once, "
+                   "later ones are queued. The value zero means that there is no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&TransferApplication::m_maxActive),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&TransferApplication::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("TxWithAddresses", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&TransferApplication::m_txTraceWithAddresses),
+                     "ns3::Packet::TwoAddressTracedCallback")
+    .AddTraceSource ("TransferComplete", "A transfer has sent its last byte",
+                     MakeTraceSourceAccessor (&TransferApplication::m_transferCompleteTrace),
+                     "ns3::TransferApplication::TransferCompleteCallback")
+  ;
+  return tid;
+}
+
+TransferApplication::TransferApplication ()
+  : m_socket (0),
+    m_running (false),
+    m_nextId (1)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TransferApplication::~TransferApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TransferApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (TransferIterator i = m_active.begin (); i != m_active.end (); ++i)
+    {
+      Simulator::Cancel (i->sendEvent);
+    }
+  m_active.clear ();
+  m_queue.clear ();
+  m_socket = 0;
+  Application::DoDispose ();
+}
+
+uint32_t
+TransferApplication::StartTransfer (const Address &peer, uint64_t bytes, DataRate rate, uint32_t taskId,
+                                    TrafficClassTag::TrafficClass trafficClass)
+{
+  NS_LOG_FUNCTION (this << peer << bytes << rate << taskId);
+  if (bytes == 0 || rate.GetBitRate () == 0)
+    {
+      NS_LOG_WARN ("Ignoring empty transfer of task " << taskId);
+      return 0;
+    }
+  Transfer transfer;
+  transfer.id = m_nextId++;
+  transfer.peer = peer;
+  transfer.bytes = bytes;
+  transfer.sent = 0;
+  transfer.rate = rate;
+  transfer.taskId = taskId;
+  transfer.trafficClass = trafficClass;
+  transfer.seq = 0;
+  m_queue.push_back (transfer);
+  StartQueued ();
+  return transfer.id;
+}
+
+uint32_t
+TransferApplication::GetActiveTransfers (void) const
+{
+  return m_active.size ();
+}
+
+uint32_t
+TransferApplication::GetQueuedTransfers (void) const
+{
+  return m_queue.size ();
+}
+
+std::vector<TransferApplication::TransferStatus>
+TransferApplication::GetTransfers (void) const
+{
+  std::vector<TransferStatus> transfers;
+  for (std::list<Transfer>::const_iterator i = m_active.begin (); i != m_active.end (); ++i)
+    {
+      TransferStatus status = {i->id, i->peer, i->taskId, i->bytes - i->sent, i->rate, i->trafficClass};
+      transfers.push_back (status);
+    }
+  for (std::deque<Transfer>::const_iterator i = m_queue.begin (); i != m_queue.end (); ++i)
+    {
+      TransferStatus status = {i->id, i->peer, i->taskId, i->bytes, i->rate, i->trafficClass};
+      transfers.push_back (status);
+    }
+  return transfers;
+}
+
+uint64_t
+TransferApplication::StopTransfers (const Address &peer, uint32_t taskId)
+{
+  NS_LOG_FUNCTION (this << peer << taskId);
+  uint64_t left = 0;
+  for (TransferIterator i = m_active.begin (); i != m_active.end (); )
+    {
+      if (i->peer == peer && i->taskId == taskId)
+        {
+          left += i->bytes - i->sent;
+          Simulator::Cancel (i->sendEvent);
+          i = m_active.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  for (std::deque<Transfer>::iterator i = m_queue.begin (); i != m_queue.end (); )
+    {
+      if (i->peer == peer && i->taskId == taskId)
+        {
+          left += i->bytes;
+          i = m_queue.erase (i);
+        }
+      else
+        {
+          ++i;
+        }
+    }
+  StartQueued ();
+  return left;
+}
+
+void
+TransferApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_socket)
+    {
+      m_socket = Socket::CreateSocket (GetNode (), m_tid);
+      if (m_socket->Bind () == -1)
+        {
+          NS_FATAL_ERROR ("Failed to bind socket");
+        }
+      m_socket->SetAllowBroadcast (true);
+      m_socket->ShutdownRecv ();
+    }
+  m_running = true;
+  StartQueued ();
+}
+
+void
+TransferApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_running = false;
+  for (TransferIterator i = m_active.begin (); i != m_active.end (); ++i)
+    {
+      Simulator::Cancel (i->sendEvent);
+    }
+  m_active.clear ();
+  m_queue.clear ();
+  if (m_socket != 0)
+    {
+      m_socket->Close ();
+      m_socket = 0;
+    }
+}
+
+void
+TransferApplication::StartQueued (void)
+{
+  while (m_running && !m_queue.empty () && (m_maxActive == 0 || m_active.size () < m_maxActive))
+    {
+      m_active.push_back (m_queue.front ());
+      m_queue.pop_front ();
+      m_active.back ().start = Simulator::Now ();
+      ScheduleNextTx (--m_active.end ());
+    }
+}
+
+uint32_t
+TransferApplication::NextPacketSize (const Transfer &transfer) const
+{
+  uint64_t left = transfer.bytes - transfer.sent;
+  return static_cast<uint32_t> (std::min<uint64_t> (m_pktSize, left));
+}
+
+void
+TransferApplication::ScheduleNextTx (TransferIterator transfer)
+{
+  uint32_t bits = NextPacketSize (*transfer) * 8;
+  Time nextTime (Seconds (bits / static_cast<double> (transfer->rate.GetBitRate ())));
+  transfer->sendEvent = Simulator::Schedule (nextTime, &TransferApplication::SendPacket, this, transfer);
+}
+
+void
+TransferApplication::SendPacket (TransferIterator transfer)
+{
+  NS_LOG_FUNCTION (this);
+  SeqTsHeader seqTs;
+  seqTs.SetSeq (transfer->seq++);
+  uint32_t size = NextPacketSize (*transfer);
+  // the header needs its 12 bytes even in a shorter last packet
+  Ptr<Packet> packet = Create<Packet> (size - std::min (size, seqTs.GetSerializedSize ()));
+  m_txTrace (packet);
+  packet->AddHeader (seqTs);
+  packet->AddPacketTag (TrafficClassTag (transfer->trafficClass, transfer->taskId,
+                                         static_cast<TrafficClassTag::InterfaceKind> (m_ifaceKind)));
+  m_socket->SendTo (packet, 0, transfer->peer);
+  transfer->sent += size;
+
+  Address localAddress;
+  m_socket->GetSockName (localAddress);
+  m_txTraceWithAddresses (packet, localAddress, transfer->peer);
+  NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds ()
+               << "s transfer of task " << transfer->taskId << " sent "
+               << transfer->sent << " of " << transfer->bytes << " bytes");
+
+  if (transfer->sent < transfer->bytes)
+    {
+      ScheduleNextTx (transfer);
+      return;
+    }
+  Time duration = Simulator::Now () - transfer->start;
+  uint32_t id = transfer->id;
+  uint32_t taskId = transfer->taskId;
+  TrafficClassTag::TrafficClass trafficClass = transfer->trafficClass;
+  uint64_t bytes = transfer->bytes;
+  m_active.erase (transfer);
+  StartQueued ();
+  m_transferCompleteTrace (id, taskId, trafficClass, bytes, duration,
+                           duration.IsStrictlyPositive () ? bytes * 8 / duration.GetSeconds () : 0);
+}
+
+} // namespace ns3
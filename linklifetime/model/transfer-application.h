@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * transfer-application.h
+ *
+ *      Author: hassam
+ */
+
+#ifndef TRANSFER_APPLICATION_H
+#define TRANSFER_APPLICATION_H
+
+#include "ns3/application.h"
+#include "ns3/address.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+#include "traffic-class-tag.h"
+#include <deque>
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+class Packet;
+
+/**
+ * \ingroup linklifetime
+ * \brief Sends task data of one interface of a node, one transfer per task piece.
+ *
+ * A node keeps one TransferApplication per interface for the whole run
+ * instead of installing a new OnOffApplication, with its own socket, for
+ * every piece of every task. StartTransfer queues \p bytes for a peer at a
+ * given rate; the bytes go out in PacketSize packets carrying a SeqTsHeader
+ * and a TrafficClassTag, each sent once the previous one has been paced out,
+ * so a transfer lasts bytes * 8 / rate. Transfers to different peers run side
+ * by side on the same unconnected socket; when MaxActiveTransfers are
+ * running, further ones wait in FIFO order. TransferComplete fires once the
+ * last byte of a transfer is sent, so that the sender can reuse the capacity.
+ */
+class TransferApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  TransferApplication ();
+  virtual ~TransferApplication ();
+
+  /**
+   * Send \p bytes to \p peer at \p rate, tagging every packet with \p taskId
+   * and \p trafficClass. Starts at once unless MaxActiveTransfers are
+   * running or the application has not started yet.
+   * \returns the id of the transfer, unique for this application and passed
+   * to TransferComplete, or 0 if there is nothing to send
+   */
+  uint32_t StartTransfer (const Address &peer, uint64_t bytes, DataRate rate, uint32_t taskId,
+                          TrafficClassTag::TrafficClass trafficClass = TrafficClassTag::APPLICATION);
+
+  /// \returns the number of transfers being sent
+  uint32_t GetActiveTransfers (void) const;
+  /// \returns the number of transfers waiting for a free slot
+  uint32_t GetQueuedTransfers (void) const;
+
+  /// A transfer being sent or queued, as returned by GetTransfers
+  struct TransferStatus
+  {
+    uint32_t transferId;
+    Address peer;
+    uint32_t taskId;
+    uint64_t remaining;  //!< bytes not sent yet
+    DataRate rate;
+    TrafficClassTag::TrafficClass trafficClass;
+  };
+
+  /// \returns the transfers being sent, then the queued ones
+  std::vector<TransferStatus> GetTransfers (void) const;
+  /**
+   * Stop the transfers of task \p taskId to \p peer, whether being sent or
+   * queued, e.g. once the link to \p peer broke. TransferComplete does not
+   * fire for them.
+   * \returns the bytes they had left to send
+   */
+  uint64_t StopTransfers (const Address &peer, uint32_t taskId);
+
+  /**
+   * TracedCallback signature for the end of a transfer.
+   *
+   * \param [in] transferId the id StartTransfer returned
+   * \param [in] taskId the task carried by the transfer
+   * \param [in] trafficClass the traffic class of the transfer
+   * \param [in] bytes the bytes sent
+   * \param [in] duration the time from the start of the transfer to its last packet
+   * \param [in] throughput the achieved rate in bit/s
+   */
+  typedef void (* TransferCompleteCallback)
+    (uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+     uint64_t bytes, Time duration, double throughput);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// One transfer, queued or being sent
+  struct Transfer
+  {
+    uint32_t id;
+    Address peer;
+    uint64_t bytes;    //!< bytes to send
+    uint64_t sent;     //!< bytes sent so far
+    DataRate rate;
+    uint32_t taskId;
+    TrafficClassTag::TrafficClass trafficClass;
+    uint32_t seq;      //!< sequence number of the next packet
+    Time start;        //!< when the transfer left the queue
+    EventId sendEvent;
+  };
+  typedef std::list<Transfer>::iterator TransferIterator;
+
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /// Start queued transfers while there is a free slot
+  void StartQueued (void);
+  /// Schedule the next packet of \p transfer once the time it takes at the transfer rate is over
+  void ScheduleNextTx (TransferIterator transfer);
+  void SendPacket (TransferIterator transfer);
+  /// \returns the size of the next packet of \p transfer
+  uint32_t NextPacketSize (const Transfer &transfer) const;
+
+  Ptr<Socket> m_socket;
+  TypeId m_tid;
+  uint32_t m_pktSize;
+  uint32_t m_ifaceKind;          //!< TrafficClassTag::InterfaceKind of the packets
+  uint32_t m_maxActive;          //!< most transfers sent at once, 0 for no limit
+  bool m_running;
+  uint32_t m_nextId;             //!< id of the next transfer
+  std::list<Transfer> m_active;  //!< list so that pending send events keep valid iterators
+  std::deque<Transfer> m_queue;
+
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+  TracedCallback<Ptr<const Packet>, const Address &, const Address &> m_txTraceWithAddresses;
+  TracedCallback<uint32_t, uint32_t, TrafficClassTag::TrafficClass, uint64_t, Time, double> m_transferCompleteTrace;
+};
+
+} // namespace ns3
+
+#endif /* TRANSFER_APPLICATION_H */
@@ -2,6 +2,12 @@
 
 // Include a header file from your module to test.
 #include "ns3/linklifetime.h"
+#include "ns3/bandwidth-ledger.h"
+#include "ns3/batch-allocator.h"
+#include "ns3/columnar-metrics.h"
+#include "ns3/latency-histogram.h"
+#include "ns3/link-lifetime-predictor.h"
+#include <algorithm>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +52,423 @@ LinklifetimeTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Reserve, release, expire and the highest rate over a window of a BandwidthLedger with 100 ms slots
+class BandwidthLedgerTestCase : public TestCase
+{
+public:
+  BandwidthLedgerTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BandwidthLedgerTestCase::BandwidthLedgerTestCase ()
+  : TestCase ("Bandwidth ledger reserves, releases, expires and takes the max over a window")
+{
+}
+
+void
+BandwidthLedgerTestCase::DoRun (void)
+{
+  BandwidthLedger ledger (MilliSeconds (100), Seconds (10));
+  // slots 0-9 at 5 Mbps and slots 5-14 at 3 Mbps
+  BandwidthLedger::ReservationId a = ledger.Reserve (Seconds (0), Seconds (1), 5);
+  BandwidthLedger::ReservationId b = ledger.Reserve (MilliSeconds (500), Seconds (1), 3);
+  NS_TEST_ASSERT_MSG_EQ (ledger.GetReservations (), 2, "Two reservations are held");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (Seconds (0), MilliSeconds (500)), 5, 1e-9, "Only the first reservation covers [0, 0.5)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (Seconds (0), Seconds (2)), 8, 1e-9, "Both reservations overlap on [0.5, 1)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (Seconds (1), Seconds (1)), 3, 1e-9, "Only the second reservation covers [1, 1.5)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (Seconds (2), Seconds (1)), 0, 1e-9, "Nothing is reserved after 1.5 s");
+
+  // releasing at 0.2 s gives back slots 2-9, the past stays booked
+  NS_TEST_ASSERT_MSG_EQ (ledger.Release (a, MilliSeconds (200)), true, "The first reservation is released");
+  NS_TEST_ASSERT_MSG_EQ (ledger.Release (a, MilliSeconds (300)), false, "A reservation is only released once");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (Seconds (0), MilliSeconds (200)), 5, 1e-9, "Slots before the release stay reserved");
+  NS_TEST_ASSERT_MSG_EQ_TOL (ledger.GetReserved (MilliSeconds (200), Seconds (2)), 3, 1e-9, "Only the second reservation is left after the release");
+  NS_TEST_ASSERT_MSG_EQ (ledger.GetReservations (), 1, "One reservation is left");
+
+  ledger.Expire (Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (ledger.GetReservations (), 1, "The second reservation ends at 1.5 s");
+  ledger.Expire (MilliSeconds (1500));
+  NS_TEST_ASSERT_MSG_EQ (ledger.GetReservations (), 0, "The second reservation has expired");
+  NS_TEST_ASSERT_MSG_EQ (ledger.Release (b, MilliSeconds (1600)), false, "An expired reservation cannot be released");
+
+  // 4 Mbps on [2, 3), 7 Mbps on [4, 5) and 1 Mbps on [2.5, 4.5)
+  BandwidthLedger window (MilliSeconds (100), Seconds (10));
+  window.Reserve (Seconds (2), Seconds (1), 4);
+  window.Reserve (Seconds (4), Seconds (1), 7);
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (2), Seconds (1)), 4, 1e-9, "Max over [2, 3)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (3), Seconds (1)), 0, 1e-9, "Max over the gap [3, 4)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (2), Seconds (3)), 7, 1e-9, "Max over [2, 5)");
+  window.Reserve (MilliSeconds (2500), Seconds (2), 1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (2), Seconds (1)), 5, 1e-9, "Overlapping rates add up on [2.5, 3)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (3), Seconds (1)), 1, 1e-9, "Max over [3, 4)");
+  NS_TEST_ASSERT_MSG_EQ_TOL (window.GetReserved (Seconds (2), Seconds (3)), 8, 1e-9, "Overlapping rates add up on [4, 4.5)");
+
+  // a 1 s window rounds up to 16 slots, which are reused as time moves on
+  BandwidthLedger sliding (MilliSeconds (100), Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (Seconds (0), Seconds (1)), 0, 1e-9, "Nothing is reserved before the first reservation");
+  sliding.Reserve (Seconds (0), Seconds (1), 5);
+  sliding.Expire (MilliSeconds (1200));
+  BandwidthLedger::ReservationId c = sliding.Reserve (Seconds (2), MilliSeconds (500), 3);
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (Seconds (2), MilliSeconds (500)), 3, 1e-9, "Slots reused after the window moved on start empty");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (Seconds (0), Seconds (2)), 0, 1e-9, "Slots behind the window are not counted");
+  sliding.Reserve (MilliSeconds (2700), Seconds (1), 2);
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (MilliSeconds (2700), MilliSeconds (100)), 2, 1e-9, "A reservation in the window counts up to its end");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (MilliSeconds (2800), Seconds (1)), 0, 1e-9, "What is past the window when reserved is ignored");
+  NS_TEST_ASSERT_MSG_EQ (sliding.Release (c, MilliSeconds (2200)), true, "A reservation is released after the window moved on");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (MilliSeconds (2200), MilliSeconds (300)), 0, 1e-9, "The release gives back the rest of the reservation");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (MilliSeconds (2700), MilliSeconds (100)), 2, 1e-9, "Other reservations stay");
+  sliding.Expire (Seconds (10));
+  NS_TEST_ASSERT_MSG_EQ_TOL (sliding.GetReserved (Seconds (10), Seconds (1)), 0, 1e-9, "A window moved past all slots starts empty");
+}
+
+// MinCostFlow on two small graphs with a unique optimum
+class MinCostFlowTestCase : public TestCase
+{
+public:
+  MinCostFlowTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MinCostFlowTestCase::MinCostFlowTestCase ()
+  : TestCase ("Min-cost max-flow pushes the most flow at the lowest cost")
+{
+}
+
+void
+MinCostFlowTestCase::DoRun (void)
+{
+  // source 0, sink 3: both source edges and both sink edges are saturated
+  MinCostFlow graph (4);
+  uint32_t s1 = graph.AddEdge (0, 1, 2, 1);
+  uint32_t s2 = graph.AddEdge (0, 2, 2, 2);
+  uint32_t t1 = graph.AddEdge (1, 3, 1, 1);
+  uint32_t across = graph.AddEdge (1, 2, 1, 0);
+  uint32_t t2 = graph.AddEdge (2, 3, 3, 1);
+  int64_t cost;
+  NS_TEST_ASSERT_MSG_EQ (graph.Solve (0, 3, cost), 4, "Max flow");
+  NS_TEST_ASSERT_MSG_EQ (cost, 10, "2 x 1 + 2 x 2 + 1 x 1 + 1 x 0 + 3 x 1");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetFlow (s1), 2, "Flow on 0-1");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetFlow (s2), 2, "Flow on 0-2");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetFlow (t1), 1, "Flow on 1-3");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetFlow (across), 1, "Flow on 1-2");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetFlow (t2), 3, "Flow on 2-3");
+
+  // the cheap path to the sink 2 fills up first, the rest takes the dear one
+  MinCostFlow detour (4);
+  detour.AddEdge (0, 1, 5, 0);
+  uint32_t cheap = detour.AddEdge (1, 2, 3, 1);
+  uint32_t dear = detour.AddEdge (1, 3, 3, 5);
+  detour.AddEdge (3, 2, 3, 0);
+  NS_TEST_ASSERT_MSG_EQ (detour.Solve (0, 2, cost), 5, "Max flow");
+  NS_TEST_ASSERT_MSG_EQ (cost, 13, "3 x 1 + 2 x 5");
+  NS_TEST_ASSERT_MSG_EQ (detour.GetFlow (cheap), 3, "Cheap edge saturated");
+  NS_TEST_ASSERT_MSG_EQ (detour.GetFlow (dear), 2, "Dear edge takes the rest");
+}
+
+// BatchAllocator keeps the pieces of every interface within its rate up to each due time
+class BatchAllocatorTestCase : public TestCase
+{
+public:
+  BatchAllocatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /// Check that the pieces of every interface do not overlap and end by their due time
+  void CheckSchedule (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links, const BatchResult &result);
+};
+
+BatchAllocatorTestCase::BatchAllocatorTestCase ()
+  : TestCase ("Batch allocator accepts what each interface can send by every deadline")
+{
+}
+
+void
+BatchAllocatorTestCase::CheckSchedule (const std::vector<BatchTask> &tasks, const std::vector<BatchLink> &links, const BatchResult &result)
+{
+  for (std::size_t p = 0; p < result.pieces.size (); p++)
+    {
+      const BatchPiece &piece = result.pieces[p];
+      const BatchLink &link = links[piece.link];
+      double due = std::min (tasks[piece.task].deadline, link.lifetime);
+      NS_TEST_ASSERT_MSG_EQ (result.accepted[piece.task], true, "Only accepted tasks get pieces");
+      NS_TEST_ASSERT_MSG_EQ_TOL (piece.duration, piece.data / link.rate, 1e-9, "A piece is sent at the rate of its link");
+      NS_TEST_ASSERT_MSG_LT (piece.start + piece.duration, due + 1e-9, "A piece ends by its due time");
+      for (std::size_t q = 0; q < p; q++)
+        {
+          const BatchPiece &other = result.pieces[q];
+          if (links[other.link].node == link.node && links[other.link].iface == link.iface)
+            {
+              bool apart = piece.start + piece.duration <= other.start + 1e-9 || other.start + other.duration <= piece.start + 1e-9;
+              NS_TEST_ASSERT_MSG_EQ (apart, true, "Pieces of one interface do not overlap");
+            }
+        }
+    }
+}
+
+void
+BatchAllocatorTestCase::DoRun (void)
+{
+  // 10 Mbps on Wi-Fi to one neighbour: 10 Mbit due in 2 s and 20 Mbit in 4 s both fit, earliest due first
+  std::vector<BatchLink> links;
+  BatchLink w = {0, 1, 0, 10, 100};
+  links.push_back (w);
+  std::vector<BatchTask> tasks;
+  BatchTask late = {1, 0, 20, 4};
+  BatchTask early = {2, 0, 10, 2};
+  tasks.push_back (late);
+  tasks.push_back (early);
+  BatchResult result = BatchAllocator::Assign (tasks, links);
+  NS_TEST_ASSERT_MSG_EQ (result.GetAccepted (), 2, "Both tasks fit in sequence");
+  NS_TEST_ASSERT_MSG_EQ (result.pieces.size (), 2, "One piece per task");
+  for (std::size_t p = 0; p < result.pieces.size (); p++)
+    {
+      const BatchPiece &piece = result.pieces[p];
+      // piece.task indexes the tasks: 0 is the later one
+      NS_TEST_ASSERT_MSG_EQ_TOL (piece.start, piece.task == 0 ? 1.0 : 0.0, 1e-9, "The earlier due piece goes first");
+      NS_TEST_ASSERT_MSG_EQ_TOL (piece.duration, piece.task == 0 ? 2.0 : 1.0, 1e-9, "Duration at the link rate");
+    }
+  CheckSchedule (tasks, links, result);
+
+  // 8 + 8 Mbit due in 1 s cannot both go at 10 Mbps, although the link carries 40 Mbit in the 4 s of the third task
+  tasks.clear ();
+  BatchTask first = {1, 0, 8, 1};
+  BatchTask second = {2, 0, 8, 1};
+  BatchTask third = {3, 0, 4, 4};
+  tasks.push_back (first);
+  tasks.push_back (second);
+  tasks.push_back (third);
+  result = BatchAllocator::Assign (tasks, links);
+  NS_TEST_ASSERT_MSG_EQ (result.GetAccepted (), 2, "Only one of the tasks due in 1 s fits");
+  NS_TEST_ASSERT_MSG_EQ (result.accepted[2], true, "The task due in 4 s fits behind it");
+  CheckSchedule (tasks, links, result);
+  BatchResult greedy = BatchAllocator::AssignGreedy (tasks, links);
+  NS_TEST_ASSERT_MSG_EQ (greedy.GetAccepted (), 2, "The greedy fit uses the same room");
+  NS_TEST_ASSERT_MSG_EQ (greedy.accepted[0] && !greedy.accepted[1] && greedy.accepted[2], true, "Earliest deadline first, first come first");
+  CheckSchedule (tasks, links, greedy);
+
+  // 50 Mbit in 2 s needs both interfaces: 20 over Wi-Fi and 40 over Wi-Fi Direct are available
+  BatchLink wd = {0, 1, 1, 20, 100};
+  links.push_back (wd);
+  tasks.clear ();
+  BatchTask big = {1, 0, 50, 2};
+  tasks.push_back (big);
+  result = BatchAllocator::Assign (tasks, links);
+  NS_TEST_ASSERT_MSG_EQ (result.GetAccepted (), 1, "The task is split over both interfaces");
+  NS_TEST_ASSERT_MSG_EQ (result.pieces.size (), 2, "One piece per interface");
+  double data = 0;
+  for (std::size_t p = 0; p < result.pieces.size (); p++)
+    {
+      data += result.pieces[p].data;
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (data, 50, 1e-6, "The pieces add up to the task");
+  CheckSchedule (tasks, links, result);
+
+  // a deadline already passed or a broken link leaves nothing to send on
+  tasks[0].deadline = 0;
+  result = BatchAllocator::Assign (tasks, links);
+  NS_TEST_ASSERT_MSG_EQ (result.GetAccepted (), 0, "Nothing fits in no time");
+  NS_TEST_ASSERT_MSG_EQ (result.pieces.size (), 0, "No pieces");
+}
+
+// Round trip of rows through a ColumnarMetricsOutput file and a ColumnarMetricsReader
+class ColumnarMetricsTestCase : public TestCase
+{
+public:
+  ColumnarMetricsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ColumnarMetricsTestCase::ColumnarMetricsTestCase ()
+  : TestCase ("Columnar metrics read back what was written, in constant and narrow chunks")
+{
+}
+
+void
+ColumnarMetricsTestCase::DoRun (void)
+{
+  static const MetricsColumn columns[] = {
+    {"Constant", METRICS_U64},  // one value: a constant chunk
+    {"Byte", METRICS_U64},      // below 256: 1 byte
+    {"Short", METRICS_U64},     // below 65536: 2 bytes
+    {"Wide", METRICS_U64},      // past 32 bits: 8 bytes
+    {"Half", METRICS_F64},      // exact as floats: 4 bytes
+    {"Tenth", METRICS_F64}      // not exact as floats: 8 bytes
+  };
+  MetricsSchema schema (columns, columns + sizeof (columns) / sizeof (columns[0]));
+  std::string path = CreateTempDirFilename ("columnar-metrics.llmc");
+
+  // 10 rows in groups of 4: 4, 4 and 2 rows
+  ColumnarMetricsOutput *output = new ColumnarMetricsOutput (path, schema, 4);
+  MetricsRecord row;
+  for (uint64_t r = 0; r < 10; r++)
+    {
+      row.Clear ();
+      row << uint64_t (7) << r << 300 + r << (uint64_t (1) << 40) + r << r + 0.5 << 0.1 * r;
+      output->Format (row);
+    }
+  output->Finish ();
+  delete output;
+
+  ColumnarMetricsReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (path), true, "The file is read back");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetSchema ().size (), schema.size (), "Column count");
+  for (std::size_t c = 0; c < schema.size (); c++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.GetSchema ()[c].name, schema[c].name, "Column name");
+      NS_TEST_ASSERT_MSG_EQ (reader.GetSchema ()[c].type, schema[c].type, "Column type");
+    }
+  NS_TEST_ASSERT_MSG_EQ (reader.GetRowGroupCount (), 3, "Row groups");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetRowCount (), 10, "Rows");
+
+  std::vector<MetricsRecord> rows;
+  uint64_t r = 0;
+  for (uint32_t g = 0; g < reader.GetRowGroupCount (); g++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.ReadRowGroup (g, rows), true, "Row group is decoded");
+      NS_TEST_ASSERT_MSG_EQ (rows.size (), g < 2 ? 4 : 2, "Rows of the group");
+      for (std::size_t i = 0; i < rows.size (); i++, r++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetU64 (0), 7, "Constant column");
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetU64 (1), r, "1 byte column");
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetU64 (2), 300 + r, "2 byte column");
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetU64 (3), (uint64_t (1) << 40) + r, "8 byte column");
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetF64 (4), r + 0.5, "Float column");
+          NS_TEST_ASSERT_MSG_EQ (rows[i].GetF64 (5), 0.1 * r, "Double column");
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadRowGroup (3, rows), false, "No fourth row group");
+}
+
+// Bucket bounds and percentiles of a LatencyHistogram
+class LatencyHistogramTestCase : public TestCase
+{
+public:
+  LatencyHistogramTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LatencyHistogramTestCase::LatencyHistogramTestCase ()
+  : TestCase ("Latency histogram bucket bounds and percentiles")
+{
+}
+
+void
+LatencyHistogramTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (LatencyHistogram::BUCKET_COUNT, 128 + 25 * 64, "Exact buckets, then 64 per power of two up to 2^32");
+  // below 128 us every microsecond has its bucket
+  NS_TEST_ASSERT_MSG_EQ_TOL (LatencyHistogram::GetBucketUpperBound (0), 0, 1e-12, "Bucket 0");
+  NS_TEST_ASSERT_MSG_EQ_TOL (LatencyHistogram::GetBucketUpperBound (127), 127e-6, 1e-12, "Last exact bucket");
+  // [128, 256) us in 64 buckets of 2 us, [256, 512) in 64 of 4 us
+  NS_TEST_ASSERT_MSG_EQ_TOL (LatencyHistogram::GetBucketUpperBound (128), 129e-6, 1e-12, "First bucket of 2 us");
+  NS_TEST_ASSERT_MSG_EQ_TOL (LatencyHistogram::GetBucketUpperBound (191), 255e-6, 1e-12, "Last bucket of 2 us");
+  NS_TEST_ASSERT_MSG_EQ_TOL (LatencyHistogram::GetBucketUpperBound (192), 259e-6, 1e-12, "First bucket of 4 us");
+
+  LatencyHistogram histogram;
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (50), 0, 1e-12, "Empty histogram");
+  for (int64_t us = 1; us <= 100; us++)
+    {
+      histogram.Record (MicroSeconds (us));
+    }
+  // 1000 us falls in [1000, 1007], 2000 us in [2000, 2015]
+  histogram.Record (MicroSeconds (1000));
+  histogram.Record (MicroSeconds (2000));
+  NS_TEST_ASSERT_MSG_EQ (histogram.GetCount (), 102, "Samples");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (0), 1e-6, 1e-12, "The lowest sample");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (50), 51e-6, 1e-12, "Rank 51 of 102");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (99), 1007e-6, 1e-12, "Rank 101 reports the top of its bucket");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (100), 2000e-6, 1e-12, "The top bucket is capped at the max");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetMax (), 2000e-6, 1e-12, "Max");
+  uint64_t counted = 0;
+  for (uint32_t i = histogram.GetFirstBucket (); i < histogram.GetEndBucket (); i++)
+    {
+      counted += histogram.GetBucketCount (i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (counted, 102, "The non-empty buckets hold every sample");
+
+  LatencyHistogram other;
+  other.Record (MicroSeconds (-5));
+  other.Record (Seconds (10000));
+  histogram.Merge (other);
+  NS_TEST_ASSERT_MSG_EQ (histogram.GetCount (), 104, "Merged samples");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetPercentile (0), 0, 1e-12, "A negative latency counts as zero");
+  NS_TEST_ASSERT_MSG_EQ_TOL (histogram.GetMax (), LatencyHistogram::MAX_MICROSECONDS / 1e6, 1e-6, "Latencies past the range are clamped");
+
+  histogram.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (histogram.GetCount (), 0, "Reset forgets every sample");
+  NS_TEST_ASSERT_MSG_EQ (histogram.GetEndBucket (), histogram.GetFirstBucket (), "No bucket is left");
+
+  // a histogram that never recorded anything allocates its buckets on the first merge
+  LatencyHistogram run;
+  run.Merge (histogram);
+  NS_TEST_ASSERT_MSG_EQ (run.GetCount (), 0, "Merging an empty histogram adds nothing");
+  run.Merge (other);
+  NS_TEST_ASSERT_MSG_EQ (run.GetCount (), 2, "Merged into an empty histogram");
+  NS_TEST_ASSERT_MSG_EQ (run.GetBucketCount (run.GetFirstBucket ()), 1, "The zero latency has its bucket");
+}
+
+// Survival, expectation and quantiles of a LinkLifetimePredictor on a chain worked out by hand
+class LinkLifetimePredictorTestCase : public TestCase
+{
+public:
+  LinkLifetimePredictorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LinkLifetimePredictorTestCase::LinkLifetimePredictorTestCase ()
+  : TestCase ("Link lifetime predictor survival, expectation and quantiles")
+{
+}
+
+void
+LinkLifetimePredictorTestCase::DoRun (void)
+{
+  LinkLifetimePredictor predictor (1.0, 10.0);
+  const double next[3][3] = {{1, 0, 0}, {1, 0, 0}, {1, 0, 0}};
+  const double dwell[3] = {3, 6, 9};
+
+  // 2 s left of a short pause, then every 3 s the node stays with probability 1/2:
+  // it leaves at 2, 5 and 8 s with probability 1/2, 1/4 and 1/8, and stays past 10 s with 1/8
+  std::vector<double> a = predictor.StaySurvival (2, 0, 0.5, next, dwell);
+  const double expected[11] = {1, 1, 0.5, 0.5, 0.5, 0.25, 0.25, 0.25, 0.125, 0.125, 0.125};
+  NS_TEST_ASSERT_MSG_EQ (a.size (), 11, "One value per step up to the horizon");
+  for (uint32_t t = 0; t <= 10; t++)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (a[t], expected[t], 1e-12, "Stay survival at step " << t);
+    }
+
+  // a partner that never leaves within the horizon
+  std::vector<double> b = predictor.StaySurvival (20, 0, 0, next, dwell);
+  predictor.Combine (a, b);
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetSurvival (-1), 1, 1e-12, "A link holds at negative times");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetSurvival (2.5), 0.5, 1e-12, "Survival between steps");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetSurvival (50), 0.125, 1e-12, "Survival past the horizon");
+  // 1 + 1 + 3 x 0.5 + 3 x 0.25 + 2 x 0.125
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetExpectation (), 4.5, 1e-12, "Expected lifetime");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetQuantile (0.1), 2, 1e-12, "Lifetime reached with probability 0.9");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetQuantile (0.6), 5, 1e-12, "Lifetime reached with probability 0.4");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetQuantile (0.9), 10, 1e-12, "Quantiles stop at the horizon");
+
+  // a partner leaving for sure at 4 s cuts the link there
+  std::vector<double> c = predictor.StaySurvival (4, 0, 0, next, dwell);
+  predictor.Combine (a, c);
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetSurvival (3), 0.5, 1e-12, "Both nodes still there at 3 s");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetSurvival (4), 0, 1e-12, "The partner has left at 4 s");
+  // 1 + 1 + 0.5 + 0.5
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetExpectation (), 3, 1e-12, "Expected lifetime of the shorter stay");
+  NS_TEST_ASSERT_MSG_EQ_TOL (predictor.GetQuantile (0.5), 4, 1e-12, "Median lifetime");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +484,12 @@ LinklifetimeTestSuite::LinklifetimeTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new LinklifetimeTestCase1, TestCase::QUICK);
+  AddTestCase (new BandwidthLedgerTestCase, TestCase::QUICK);
+  AddTestCase (new MinCostFlowTestCase, TestCase::QUICK);
+  AddTestCase (new BatchAllocatorTestCase, TestCase::QUICK);
+  AddTestCase (new ColumnarMetricsTestCase, TestCase::QUICK);
+  AddTestCase (new LatencyHistogramTestCase, TestCase::QUICK);
+  AddTestCase (new LinkLifetimePredictorTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -5,11 +5,16 @@
 #include <queue>
 #include <utility>
 #include <functional>
-#include <thread>
-#include <chrono>
 #include <random>
 #include <algorithm>
 #include <iterator>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "linklifetime/model/resource-allocator.h"
 
 class Nodes
 {
@@ -28,11 +33,11 @@ public:
       cout << "Creating Nodes: Node ID: " << m_node_id << ", LLTW: " << m_LLTW
       << ", LLTWD: " << m_LLTWD << std::endl;
   }
-  std::uint16_t get_LLTW ()
+  std::uint16_t get_LLTW () const
   {
     return m_LLTW;
   }
-  std::uint16_t get_LLTWD ()
+  std::uint16_t get_LLTWD () const
   {
     return m_LLTWD;
   }
@@ -50,16 +55,8 @@ populate_Nqueue (T & node_queue)
   while (i++ < 10)
     {
       int lltw = (rand () % 120 + 1);
-      std::
-	cout << "randomly generated LLTW: " << lltw << ", nodeID: " << i <<
-	std::endl;
       int lltwd = (rand () % 120 + 1);
-      std::
-	cout << "randomly generated LLTWD: " << lltwd << ", nodeID: " << i <<
-	std::endl;
       node_queue.push (Nodes (lltw, lltwd, i));
-      std::this_thread::sleep_for (std::chrono::
-				   milliseconds (rand () % 10 + 1));
     }
 }
 
@@ -71,7 +68,7 @@ public:
   {
   }
   UserTask (std::uint16_t deadline, std::uint16_t task_size,
-	    std::uint16_t task_id):m_deadline (deadline),
+	    std::uint32_t task_id):m_deadline (deadline),
     m_task_size (task_size), m_task_id (task_id)
   {
   }
@@ -81,18 +78,22 @@ public:
       cout << "Running task: Task ID: " << m_task_id << ", Task Size: " <<
       m_task_size << ", Task Deadline: " << m_deadline << std::endl;
   }
-  std::uint16_t get_deadline ()
+  std::uint16_t get_deadline () const
   {
     return m_deadline;
   }
-  std::uint16_t get_task_size ()
+  std::uint16_t get_task_size () const
   {
     return m_task_size;
   }
+  std::uint32_t get_task_id () const
+  {
+    return m_task_id;
+  }
 private:
   std::uint16_t m_deadline;
   std::uint16_t m_task_size;
-  std::uint16_t m_task_id;
+  std::uint32_t m_task_id;
 };
 
 template < typename T > void
@@ -114,16 +115,8 @@ populate_queue (T & user_task_queue)
   while (i++ < 10)
     {
       int ds = (rand () % 2048 + 1);
-      std::
-	cout << "randomly generated data size: " << ds << ", taskID: " << i <<
-	std::endl;
       int dl = (rand () % 260 + 1);
-      std::
-	cout << "randomly generated data transfer deadline: " << dl <<
-	", taskID: " << i << std::endl;
       user_task_queue.push (UserTask (dl, ds, i));
-      std::this_thread::sleep_for (std::chrono::
-				   milliseconds (rand () % 2000 + 1));
     }
 }
 
@@ -140,6 +133,297 @@ delayGen (double minRange, double maxRange)
   return dist (rng);
 }
 
+// Bounded multi-producer multi-consumer queue without locks (Vyukov): every
+// cell carries a sequence number telling whether it is free for the push of
+// a given round or holds the value for the pop of that round, so producers
+// and consumers only contend on the index they advance.
+template < typename T > class MpmcQueue
+{
+public:
+  explicit MpmcQueue (std::size_t capacity)
+  {
+    std::size_t size = 1;
+    while (size < capacity)
+      {
+	size <<= 1;
+      }
+    m_cells.reset (new Cell[size]);
+    m_mask = size - 1;
+    for (std::size_t i = 0; i < size; i++)
+      {
+	m_cells[i].sequence.store (i, std::memory_order_relaxed);
+      }
+    m_enqueue.store (0, std::memory_order_relaxed);
+    m_dequeue.store (0, std::memory_order_relaxed);
+  }
+  // false when the queue is full
+  bool push (const T & value)
+  {
+    std::size_t pos = m_enqueue.load (std::memory_order_relaxed);
+    for (;;)
+      {
+	Cell & cell = m_cells[pos & m_mask];
+	std::size_t seq = cell.sequence.load (std::memory_order_acquire);
+	std::intptr_t diff = (std::intptr_t) seq - (std::intptr_t) pos;
+	if (diff == 0)
+	  {
+	    if (m_enqueue.compare_exchange_weak
+		(pos, pos + 1, std::memory_order_relaxed))
+	      {
+		cell.value = value;
+		cell.sequence.store (pos + 1, std::memory_order_release);
+		return true;
+	      }
+	  }
+	else if (diff < 0)
+	  {
+	    return false;
+	  }
+	else
+	  {
+	    pos = m_enqueue.load (std::memory_order_relaxed);
+	  }
+      }
+  }
+  // false when the queue is empty
+  bool pop (T & value)
+  {
+    std::size_t pos = m_dequeue.load (std::memory_order_relaxed);
+    for (;;)
+      {
+	Cell & cell = m_cells[pos & m_mask];
+	std::size_t seq = cell.sequence.load (std::memory_order_acquire);
+	std::intptr_t diff = (std::intptr_t) seq - (std::intptr_t) (pos + 1);
+	if (diff == 0)
+	  {
+	    if (m_dequeue.compare_exchange_weak
+		(pos, pos + 1, std::memory_order_relaxed))
+	      {
+		value = cell.value;
+		cell.sequence.store (pos + m_mask + 1,
+				     std::memory_order_release);
+		return true;
+	      }
+	  }
+	else if (diff < 0)
+	  {
+	    return false;
+	  }
+	else
+	  {
+	    pos = m_dequeue.load (std::memory_order_relaxed);
+	  }
+      }
+  }
+private:
+  struct Cell
+  {
+    std::atomic < std::size_t > sequence;
+    T value;
+  };
+  std::unique_ptr < Cell[] > m_cells;
+  std::size_t m_mask;
+  alignas (64) std::atomic < std::size_t > m_enqueue;
+  alignas (64) std::atomic < std::size_t > m_dequeue;
+};
+
+// Where the driver placed one task: node -1 if no node could take it
+struct Decision
+{
+  std::int32_t node;
+  bool wdFirst;
+  double finalData;
+  double completion;
+};
+
+bool
+same_decision (const Decision & a, const Decision & b)
+{
+  return a.node == b.node && a.wdFirst == b.wdFirst
+    && std::memcmp (&a.finalData, &b.finalData, sizeof (double)) == 0
+    && std::memcmp (&a.completion, &b.completion, sizeof (double)) == 0;
+}
+
+// A trace of the driver: the task of every id is derived from the seed and
+// the id alone, so it does not depend on which producer made it
+struct Trace
+{
+  std::uint64_t seed;
+  std::uint32_t tasks;
+  std::vector < Nodes > nodes;
+  std::vector < double > delayW;	// per node seconds per MB
+  std::vector < double > delayWD;
+  bool best;			// earliest completion, otherwise first fit
+};
+
+std::uint64_t
+splitmix64 (std::uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+UserTask
+trace_task (const Trace & trace, std::uint32_t id)
+{
+  std::uint64_t r = splitmix64 (trace.seed ^ ((std::uint64_t) id << 20));
+  int ds = r % 2048 + 1;
+  int dl = (r >> 32) % 260 + 1;
+  return UserTask (dl, ds, id);
+}
+
+Decision
+allocate (const Trace & trace, const UserTask & task)
+{
+  Decision decision = { -1, false, 0, 0 };
+  uint16_t deadline = task.get_deadline ();
+  for (std::size_t n = 0; n < trace.nodes.size (); n++)
+    {
+      ns3::SplitRequest request;
+      request.size = task.get_task_size ();
+      request.deadline = deadline;
+      request.rateW = 11.0 / 2;
+      request.rateWD = 24.0 / 2;
+      request.usableW = std::min (deadline, trace.nodes[n].get_LLTW ());
+      request.usableWD = std::min (deadline, trace.nodes[n].get_LLTWD ());
+      request.delayW = trace.delayW[n];
+      request.delayWD = trace.delayWD[n];
+      ns3::SplitResult split = ns3::ResourceAllocator::Split (request);
+      if (!split.feasible
+	  || (decision.node >= 0 && split.completion >= decision.completion))
+	{
+	  continue;
+	}
+      decision.node = n;
+      decision.wdFirst = split.wdFirst;
+      decision.finalData = split.finalData;
+      decision.completion = split.completion;
+      if (!trace.best)
+	{
+	  break;
+	}
+    }
+  return decision;
+}
+
+// Producers push the tasks of the trace, workers place them and write the
+// decision of task i to decisions[i]; nodes are only read, so every worker
+// places against all of them
+void
+run_trace (const Trace & trace, unsigned producers, unsigned workers,
+	   std::vector < Decision > &decisions)
+{
+  decisions.assign (trace.tasks, Decision ());
+  MpmcQueue < UserTask > queue (4096);
+  std::atomic < std::uint32_t > placed (0);
+  std::vector < std::thread > threads;
+  for (unsigned p = 0; p < producers; p++)
+    {
+      threads.emplace_back ([&trace, &queue, p, producers] ()
+      {
+	for (std::uint32_t id = p; id < trace.tasks; id += producers)
+	  {
+	    UserTask task = trace_task (trace, id);
+	    while (!queue.push (task))
+	      {
+		std::this_thread::yield ();
+	      }
+	  }
+      });
+    }
+  for (unsigned w = 0; w < workers; w++)
+    {
+      threads.emplace_back ([&trace, &queue, &placed, &decisions] ()
+      {
+	UserTask task;
+	while (placed.load (std::memory_order_relaxed) < trace.tasks)
+	  {
+	    if (!queue.pop (task))
+	      {
+		std::this_thread::yield ();
+		continue;
+	      }
+	    decisions[task.get_task_id ()] = allocate (trace, task);
+	    placed.fetch_add (1, std::memory_order_relaxed);
+	  }
+      });
+    }
+  for (std::size_t t = 0; t < threads.size (); t++)
+    {
+      threads[t].join ();
+    }
+}
+
+// Place a trace with 1 to maxThreads workers, report the throughput and
+// check every run against the single worker one
+int
+drive (std::uint32_t tasks, std::uint32_t nodes, unsigned maxThreads,
+       std::uint64_t seed, bool best)
+{
+  Trace trace;
+  trace.seed = seed;
+  trace.tasks = tasks;
+  trace.best = best;
+  std::mt19937 rng (seed);
+  std::uniform_int_distribution < int >lifetime (1, 120);
+  std::uniform_real_distribution < double >delay (0.00001, 0.01);
+  for (std::uint32_t n = 0; n < nodes; n++)
+    {
+      trace.nodes.push_back (Nodes (lifetime (rng), lifetime (rng), n));
+      trace.delayW.push_back (delay (rng));
+      trace.delayWD.push_back (delay (rng));
+    }
+
+  std::vector < Decision > reference, decisions;
+  double single = 0;
+  std::cout << "Threads\tTasksPerSecond\tSpeedup\tPlaced\tMeanCompletion\tIdentical"
+    << std::endl;
+  for (unsigned workers = 1; workers <= maxThreads;
+       workers = workers < maxThreads ? std::min (2 * workers, maxThreads) :
+       maxThreads + 1)
+    {
+      unsigned producers = std::max (1u, workers / 4);
+      std::chrono::steady_clock::time_point start =
+	std::chrono::steady_clock::now ();
+      run_trace (trace, producers, workers, decisions);
+      double seconds = std::chrono::duration < double >
+	(std::chrono::steady_clock::now () - start).count ();
+      // reduce in task order, so that the sums do not depend on the threads
+      std::uint32_t placed = 0;
+      double completion = 0;
+      for (std::size_t i = 0; i < decisions.size (); i++)
+	{
+	  if (decisions[i].node >= 0)
+	    {
+	      placed++;
+	      completion += decisions[i].completion;
+	    }
+	}
+      bool identical = true;
+      if (workers == 1)
+	{
+	  reference = decisions;
+	  single = seconds;
+	}
+      else
+	{
+	  identical = std::equal (decisions.begin (), decisions.end (),
+				  reference.begin (), same_decision);
+	}
+      std::cout << workers << "\t" << tasks / seconds << "\t"
+	<< single / seconds << "\t" << placed << "\t"
+	<< (placed ? completion / placed : 0) << "\t"
+	<< (identical ? "yes" : "no") << std::endl;
+      if (!identical)
+	{
+	  return 1;
+	}
+    }
+  return 0;
+}
+
 // lambda is evaluated at compile time using constexpr
 constexpr auto cmp_deadline =[](UserTask left, UserTask right) {
   return (left.get_deadline ()) > (right.get_deadline ());
@@ -161,8 +445,19 @@ decltype (cmp_deadline) >;
        decltype (cmp_size) >;
 
      int
-     main ()
+     main (int argc, char *argv[])
 {
+  // main driver [tasks] [nodes] [threads] [seed] [first|best]
+  if (argc > 1 && std::string (argv[1]) == "driver")
+    {
+      std::uint32_t tasks = argc > 2 ? std::stoul (argv[2]) : 1000000;
+      std::uint32_t nodes = argc > 3 ? std::stoul (argv[3]) : 64;
+      unsigned threads = argc > 4 ? std::stoul (argv[4]) :
+	std::max (1u, std::thread::hardware_concurrency ());
+      std::uint64_t seed = argc > 5 ? std::stoull (argv[5]) : 1;
+      bool best = argc > 6 && std::string (argv[6]) == "best";
+      return drive (tasks, nodes, std::max (1u, threads), seed, best);
+    }
   std::queue < Nodes > nodes_queue;
   populate_Nqueue (nodes_queue);
   deadline_priority_queue
@@ -174,208 +469,48 @@ decltype (cmp_deadline) >;
   //  populate_queue<size_priority_queue>(ordered_queue_2);
   //print_queue(ordered_queue_2);
   
-  while (!nodes_queue.empty())
+  while (!nodes_queue.empty () && !ordered_queue.empty ())
     {
       Nodes node = nodes_queue.front ();
+      auto task = ordered_queue.top ();
+      ordered_queue.pop ();
 
-      while (!ordered_queue.empty ())
-	{
-	  auto
-	    task = ordered_queue.top ();
-
-	  std::string stack = "ns3";
-	  std::string sBandWidthW = "11Mbps";
-	  std::string sBandWidthWD = "24Mbps";
-	  std::string sRemainingDTTW, sRemainingDTTWD, sDataTransferTimeW,
-	    sDataTransferTimeWD;
-	  // uint16_t mobiles = 2;
-	  uint16_t
-	    deadline = task.get_deadline ();
-	  std::cout << "deadline: " << deadline << std::endl;
-
-	  std::string sDeadline = std::to_string (deadline);
-	  double
-	    dataSize = task.get_task_size ();
-	  std::cout << "dataSize: " << dataSize << std::endl;
-	  double
-	    delayW = delayGen (0.00001, 0.01);
-	  double
-	    delayWD = delayGen (0.00001, 0.01);
-	  uint16_t
-	    LLTW = node.get_LLTW ();
-	  uint16_t
-	    LLTWD = node.get_LLTWD ();
-	  uint16_t
-	    aW = 0;
-	  uint16_t
-	    aWD = 0;
-	  double
-	    bandWidthW = 11.0;
-	  double
-	    MbtoMBW = bandWidthW / 2;
-	  double
-	    bandWidthWD = 24.0;
-	  double
-	    MbtoMBWD = bandWidthWD / 2;
-	  double
-	    dBandWidthW = MbtoMBW;
-	  double
-	    dBandWidthWD = MbtoMBWD;
-	  double
-	    finalData = 0;
-	  double
-	    maxDataW = 0;
-	  double
-	    maxDataWD = 0;
-	  double
-	    totalData = 0;
-	  double
-	    remainingData = 0;
-	  double
-	    dataTransferTimeW = 0;
-	  double
-	    dataTransferTimeWD = 0;
-	  double
-	    remainingDTTW = 0;
-	  double
-	    remainingDTTWD = 0;
-	  double
-	    remainingDTT = 0;
-	  //Resource Allocation Algorithm
-	  dataTransferTimeW =
-	    std::round ((dataSize / dBandWidthW) + (dataSize * delayW));
-	  std::cout << "dataTransferTimeW: " << dataTransferTimeW << std::
-	    endl;
-	  dataTransferTimeWD =
-	    std::round ((dataSize / dBandWidthWD) + (dataSize * delayWD));
-	  std::cout << "dataTransferTimeWD: " << dataTransferTimeWD << std::
-	    endl;
-	    aW = std::min (deadline, LLTW);
-	    aWD = std::min (deadline, LLTWD);
-	  maxDataW = dBandWidthW * (aW - (aW * delayW));
-	  std::cout << "maxDataW: " << maxDataW << std::endl;
-	  maxDataWD = dBandWidthWD * (aWD - (aWD * delayWD));
-	  std::cout << "maxDataWD: " << maxDataWD << std::endl;
+      // rates in MB/s
+      double bandWidthW = 11.0;
+      double bandWidthWD = 24.0;
+      uint16_t deadline = task.get_deadline ();
+      ns3::SplitRequest request;
+      request.size = task.get_task_size ();
+      request.deadline = deadline;
+      request.rateW = bandWidthW / 2;
+      request.rateWD = bandWidthWD / 2;
+      request.usableW = std::min (deadline, node.get_LLTW ());
+      request.usableWD = std::min (deadline, node.get_LLTWD ());
+      request.delayW = delayGen (0.00001, 0.01);
+      request.delayWD = delayGen (0.00001, 0.01);
+      //Resource Allocation Algorithm
+      ns3::SplitResult split = ns3::ResourceAllocator::Split (request);
 
-	  if (maxDataW > dataSize)
-	    {
-	      maxDataW = dataSize;
-	    }
-	  if (maxDataWD > dataSize)
-	    {
-	      maxDataWD = dataSize;
-	    }
-	  if (maxDataWD > maxDataW)
-	    {
-	      remainingData = dataSize - maxDataWD;
-	      remainingDTTW = remainingData / dBandWidthW;
-	      finalData = maxDataWD;
-	      totalData = remainingData + maxDataWD;
-	    }
-	  else
-	    {
-	      remainingData = dataSize - maxDataW;
-	      remainingDTTWD = remainingData / dBandWidthWD;
-	      finalData = maxDataW;
-	      totalData = remainingData + maxDataW;
-	    }
-
-	  remainingDTT = remainingDTTW + remainingDTTWD;
-
-	  std::cout << "remainingData: " << remainingData << std::endl;
-	  std::cout << "remainingDTTW: " << remainingDTTW << std::endl;
-	  std::cout << "remainingDTTWD: " << remainingDTTWD << std::endl;
-	  std::cout << "finalData: " << finalData << std::endl;
-	  std::cout << "totalData: " << totalData << std::endl;
-	  std::cout << "remainingDTT: " << remainingDTT << std::endl;
-
-	  if (totalData < dataSize || remainingDTT > deadline)
-	    {
-	      std::cout << "This data transfer is not possible" << std::endl;
-	      ordered_queue.pop ();
-	      nodes_queue.pop ();
-	    }
-	  else
-	    {
-	      if (maxDataWD > maxDataW)
-		{
-		  if (dataTransferTimeWD < deadline)
-		    {
-		      std::
-			cout << "Sending the maximum data " << finalData <<
-			" to node using Wi-Fi Direct for the time: " <<
-			dataTransferTimeWD << "s" << std::endl;
-		      sDataTransferTimeWD =
-			std::to_string (dataTransferTimeWD);
-		      // appIfTwo(nodes, sBandWidthWD, sDataTransferTimeWD, dataTransferTimeWD);
-		      ordered_queue.pop ();
-		    }
-		  else
-		    {
-		      std::
-			cout << "Sending the maximum data " << finalData <<
-			" to node using Wi-Fi Direct for the time: " <<
-			deadline << "s" << std::endl;
-		      //sDeadline = std::to_string(deadline);
-		      // appIfTwo(nodes, sBandWidthWD, sDeadline, deadline);
-		      ordered_queue.pop ();
-		    }
-
-		  if (remainingData == 0)
-		    {
-		      std::cout << "No need to use another WCT" << std::endl;
-		    }
-		  else
-		    {
-		      std::
-			cout << "Sending the remaining data " << remainingData
-			<< " to node using Wi-Fi for the time: " <<
-			remainingDTTW << "s" << std::endl;
-		      sRemainingDTTW = std::to_string (remainingDTTW);
-		      //appIfOne(nodes, sBandWidthW, sRemainingDTTW, remainingDTTW);
-		      ordered_queue.pop ();
-		    }
-
-		}
-	      else
-		{
-		  if (dataTransferTimeW < deadline)
-		    {
-		      std::
-			cout << "Sending the maximum data " << finalData <<
-			" to node using Wi-Fi for the time: " <<
-			dataTransferTimeW << "s" << std::endl;
-		      sDataTransferTimeW = std::to_string (dataTransferTimeW);
-		      //appIfOne(nodes, sBandWidthW, sDataTransferTimeW, dataTransferTimeW);
-		      ordered_queue.pop ();
-		    }
-		  else
-		    {
-		      std::
-			cout << "Sending the maximum data " << finalData <<
-			" to node using Wi-Fi for the time: " << deadline <<
-			"s" << std::endl;
-		      //sDeadline = std::to_string(deadline);
-		      //appIfOne(nodes, sBandWidthW, sDeadline, deadline);
-		      ordered_queue.pop ();
-		    }
-		  if (remainingData == 0)
-		    {
-		      std::cout << "No need to use another WCT" << std::endl;
-		    }
-		  else
-		    {
-		      std::
-			cout << "Sending the remaining data " << remainingData
-			<< " to node using Wi-Fi Direct" << remainingDTTWD <<
-			"s" << std::endl;
-		      sRemainingDTTW = std::to_string (remainingDTTWD);
-		      //appIfTwo(nodes, sBandWidthW, sRemainingDTTW, remainingDTTWD);
-		      ordered_queue.pop ();
-		    }
-		}
-	    }
-	    }
+      task.print_id ();
+      if (!split.feasible)
+	{
+	  std::cout << "This data transfer is not possible" << std::endl;
+	  nodes_queue.pop ();
+	  continue;
+	}
+      std::cout << "Sending the maximum data " << split.finalData <<
+	" to node using " << (split.wdFirst ? "Wi-Fi Direct" : "Wi-Fi") <<
+	" for the time: " << std::round (split.firstTime) << "s" << std::endl;
+      if (split.remainingData == 0)
+	{
+	  std::cout << "No need to use another WCT" << std::endl;
+	}
+      else
+	{
+	  std::cout << "Sending the remaining data " << split.remainingData <<
+	    " to node using " << (split.wdFirst ? "Wi-Fi" : "Wi-Fi Direct") <<
+	    " for the time: " << split.remainingTime << "s" << std::endl;
 	}
-      return 0;
     }
+  return 0;
+}
@@ -46,9 +46,10 @@
  * the transmit power (as power increases, the impact of mobility
  * decreases and the effective density increases).
  *
- * By default, OLSR is used, but specifying a value of 2 for the protocol
- * will cause AODV to be used, and specifying a value of 3 will cause
- * DSDV to be used.
+ * By default, no routing protocol is installed and tasks only go to
+ * neighbours. A value of 1 for the protocol installs OLSR, 2 AODV, 3 DSDV
+ * and 4 DSR; with one of them, maxHops above 1 lets tasks go to helpers
+ * further away when no neighbour can take them.
  *
  * By default, there are 10 source/sink data pairs sending UDP data
  * at an application rate of 2.048 Kb/s each.    This is typically done
@@ -73,8 +74,11 @@
 #include <cmath>
 #include <ctime>
 #include <queue>
+#include <limits>
 #include <utility>
+#include <tuple>
 #include <functional>
+#include <memory>
 #include <random>
 #include <algorithm>
 #include <iterator>
@@ -99,6 +103,21 @@
 #include "ns3/discovery-application.h"
 #include "ns3/markovchain-mobility-model.h"
 #include "ns3/myrtable.h"
+#include "ns3/traffic-class-tag.h"
+#include "ns3/metrics-sink.h"
+#include "ns3/columnar-metrics.h"
+#include "ns3/cache-aligned-allocator.h"
+#include "ns3/latency-histogram.h"
+#include "ns3/task-tracker.h"
+#include "ns3/event-trace.h"
+#include "ns3/hot-log.h"
+#include "ns3/pcap-ring-capture.h"
+#include "ns3/flow-stats-exporter.h"
+#include "ns3/transfer-application.h"
+#include "ns3/bandwidth-ledger.h"
+#include "ns3/batch-allocator.h"
+#include "ns3/link-lifetime-predictor.h"
+#include "ns3/resource-allocator.h"
 
 
 using namespace ns3;
@@ -115,11 +134,169 @@ struct TaskDetails
     Time dataTransferCompleted;
 };
 
+/// One neighbour and interface a striped task is sent over
+struct TaskStripe
+{
+    Ipv4Address dest;
+    uint8_t iface;    //!< 0 Wi-Fi, 1 Wi-Fi Direct
+    double usable;    //!< seconds the link can be used: the deadline or its predicted lifetime
+    double rate;      //!< Mbps
+    double data;      //!< Mbit
+};
+
+/// A task waiting in the queue of a node
+struct QueuedTask
+{
+    uint32_t taskId;
+    double size;      //!< Mbit
+    Time deadline;    //!< absolute
+    Time queued;
+};
+
+/// Orders a node queue earliest deadline first
+struct QueuedTaskLater
+{
+    bool operator() (const QueuedTask &a, const QueuedTask &b) const
+    {
+        return a.deadline > b.deadline;
+    }
+};
+
+typedef std::priority_queue<QueuedTask, std::vector<QueuedTask>, QueuedTaskLater> NodeTaskQueue;
+
+/// How a task is split between the Wi-Fi and Wi-Fi Direct links of one neighbour
+struct SplitDecision
+{
+    bool feasible;
+    bool wdFirst;          //!< the larger share goes over Wi-Fi Direct
+    Ipv4Address destW;
+    Ipv4Address destWD;
+    double finalData;      //!< Mbit of the larger share
+    double remainingData;  //!< Mbit left for the other interface
+    double completion;     //!< seconds until all data is sent
+    uint32_t hops;         //!< hops to the helper, 1 for a neighbour
+    double rateW;          //!< Mbps the Wi-Fi share is sent at
+    double rateWD;         //!< Mbps the Wi-Fi Direct share is sent at
+    std::vector<uint32_t> relays; //!< nodes forwarding the task to a helper further away
+};
+
+/// A path to a helper found by ComputeMultiHopSplit
+struct HelperPath
+{
+    uint32_t node;
+    uint32_t hops;
+    double rateW;      //!< Mbps left on the Wi-Fi hop with the least
+    double rateWD;     //!< Mbps left on the Wi-Fi Direct hop with the least
+    double lifetimeW;  //!< seconds until the shortest lived Wi-Fi hop breaks
+    double lifetimeWD; //!< seconds until the shortest lived Wi-Fi Direct hop breaks, 0 without a Wi-Fi Direct path
+    std::vector<uint32_t> relays; //!< nodes between the source and the helper
+};
+
+/// Sizes in Mbit and deadlines in seconds of the task catalog, indexed by task class
+static const uint32_t TASK_SIZES[5] = {110, 300, 190, 750, 150};
+static const uint32_t TASK_DEADLINES[5] = {10, 20, 15, 30, 12};
+
+/**
+ * What a split depends on besides the routes of the node. The deadline left
+ * and the bandwidths are rounded down to whole steps, and the split is
+ * computed for the rounded values, so that it holds for every task of the
+ * class that falls in the same steps.
+ */
+struct SplitKey
+{
+    uint32_t taskClass;  //!< index in TASK_SIZES
+    uint32_t deadline;   //!< whole seconds left
+    bool maxProcSpeed;
+    uint32_t rateW;      //!< steps of Mbps available on Wi-Fi
+    uint32_t rateWD;     //!< steps of Mbps available on Wi-Fi Direct
+    bool operator< (const SplitKey &o) const
+    {
+        return std::tie (taskClass, deadline, maxProcSpeed, rateW, rateWD)
+            < std::tie (o.taskClass, o.deadline, o.maxProcSpeed, o.rateW, o.rateWD);
+    }
+};
+
+/// Splits computed by a node since its routes last changed
+struct SplitCache
+{
+    uint64_t epochW = 0;
+    uint64_t epochWD = 0;
+    std::map<SplitKey, SplitDecision> decisions;
+};
+
+/**
+ * Per node counters and state of the experiment. Each node's stats sit on
+ * their own cache lines so that nodes can later be updated concurrently
+ * without false sharing.
+ */
+struct alignas(CACHE_LINE_SIZE) NodeStats
+{
+	uint32_t tasksAssigned = 0;
+	uint32_t tasksFailed = 0;
+	uint32_t tasksStolen = 0; //!< queued tasks of neighbours this node took over
+	uint64_t bytesMigrated = 0; //!< bytes of transfers moved off a broken link
+	double migrationSlack = 0; //!< seconds of deadline slack the migrations used up
+
+	// Reset by CheckThroughput every second
+	uint32_t bytesTotalDisc = 0;
+	uint32_t packetsReceivedDisc = 0;
+	uint32_t bytesTotalWDDisc = 0;
+	uint32_t packetsReceivedWDDisc = 0;
+	uint32_t bytesTotalApp = 0;
+	uint32_t packetsReceivedApp = 0;
+	uint32_t bytesTotalWDApp = 0;
+	uint32_t packetsReceivedWDApp = 0;
+	uint32_t currentSeqNo = 0;
+	uint32_t currentSeqNoWD = 0;
+	uint64_t counterTX = 0;
+	uint64_t counterRX = 0;
+	uint64_t counterAppTX = 0;
+	uint64_t counterAppRX = 0;
+	uint64_t counterTXWD = 0;
+	uint64_t counterRXWD = 0;
+	uint64_t counterAppTXWD = 0;
+	uint64_t counterAppRXWD = 0;
+	long double delay = 0;
+	long double rcv = 0;
+	long double sqhd = 0;
+	long double delayWD = 0;
+	long double rcvWD = 0;
+	long double sqhdWD = 0;
+
+	// Last observed PHY rates in Mbps
+	uint64_t txDataRate = 0;
+	uint64_t rxDataRate = 0;
+	uint64_t txDataRateWD = 0;
+	uint64_t rxDataRateWD = 0;
+
+	// Traffic of the last second in Mbit
+	double mbsApp = 0;
+	double mbsDisc = 0;
+	double mbsWDDisc = 0;
+	double mbsWDApp = 0;
+
+	// Throughput since the first packet, in Mbps
+	double throughputW = 0;
+	double throughputWD = 0;
+	double throughputWApp = 0;
+	double throughputWDApp = 0;
+
+	double timeFirstPktAppSent = 0;
+	double timeFirstPktAppWDSent = 0;
+	double timeFirstPktDiscSent = 0;
+	double timeFirstPktDiscWDSent = 0;
+	bool firstTime = true;
+	bool firstTimeAppPktSent = true;
+	bool firstTimeDiscPktSent = true;
+	bool firstTimeAppWDPktSent = true;
+	bool firstTimeDiscWDPktSent = true;
+};
+
 class RoutingExperiment
 {
 public:
 	RoutingExperiment ();
-	void Run (int nSinks, double txp, std::string CSVfileName);
+	void Run (double txp, std::string CSVfileName);
 	//static void SetMACParam (ns3::NetDeviceContainer & devices,
 	//                                 int slotDistance);
 	std::string CommandSetup (int argc, char **argv);
@@ -137,8 +314,13 @@ private:
 	void ReceiveDiscoveryWD (Ptr<Socket> socket);
 	void ReceiveReply (Ptr<Socket> socket);
 	void ReceiveReplyWD (Ptr<Socket> socket);
-	void CheckIfTaskCompleted(int sourceID, Ipv4Address dest, double dataSize);
-	void CheckThroughput (uint16_t i);
+	void CheckIfTaskCompleted(int sourceID, Ipv4Address dest, double dataSize, uint32_t taskId);
+	void CheckThroughput (uint32_t i);
+	void SampleAllNodes ();
+	void RecordSample (uint32_t i, MetricsRecord &row);
+	void ResetDropCounters ();
+	void WriteLatencySummary ();
+	static MetricsSchema ThroughputSchema ();
 	void RxWD (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise);
 	void Rx (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise);
 	void Tx (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector, MpduInfo aMpdu);
@@ -160,12 +342,53 @@ private:
 	std::vector<std::string> Explode(const std::string& str, const char& ch);
 	void LinkLifeTimer();
 	void CourseChange (std::string context, Ptr<const MobilityModel> model);
-	void AllocateAndSend(int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed);
+	void AllocateAndSend(int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed);
+	bool PlaceTask (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed, TaskDetails &thisTask);
+	SplitDecision DecideSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD);
+	SplitDecision ComputeSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD);
+	SplitDecision ComputeMultiHopSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD);
+	void ScheduleNextTask ();
+	void EnqueueTask (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine);
+	void ServeQueue (uint32_t nodeID);
+	void DropQueuedTask (uint32_t nodeID, const QueuedTask &task);
+	std::vector<uint32_t> Neighbours (uint32_t nodeID);
+	bool StealFrom (uint32_t victim, uint32_t thief);
+	bool OfferToNeighbours (uint32_t nodeID);
+	void Steal (uint32_t thief);
+	void SuperviseTransfers ();
+	bool LinkBroken (uint32_t nodeID, uint8_t iface, Ipv4Address peer);
+	bool MigrateTransfer (uint32_t nodeID, uint8_t iface, const TransferApplication::TransferStatus &transfer,
+			const std::vector<uint32_t> &transferIds);
+	void AvailableBandwidth (int nodeID, double horizon, double &availableBWW, double &availableBWWD);
+	Ipv4Address WifiAddressOf (Ipv4Address addressWD) const;
+	void QueueForBatch (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine);
+	void AllocateBatch ();
+	void SendBatchPiece (uint32_t nodeId, uint8_t iface, Ipv4Address dest, double data, double rate, uint32_t taskId,
+			BandwidthLedger::ReservationId booked);
+	bool AllocateStriped (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed,
+			double availableBWW, double availableBWWD, const std::map<Ipv4Address, RTableEntry> &allRoutesW,
+			const std::map<Ipv4Address, RTableEntry> &allRoutesWD, TaskDetails &thisTask);
 	void StartTaskGeneration();
 	void GenerateTasks();
 	double TimeIntervalToTime(uint16_t interval);
-	void InstallApplicationsW (Ptr<Node> source, Ipv4Address des, double simTime, double dataRate);
-	void InstallApplicationsWD (Ptr<Node> source, Ipv4Address des, double simTime, double dataRate);
+	double PredictLinkLifetime (Ptr<Node> me, Ipv4Address neighbour, uint16_t neighbourInterval);
+	void SendTaskW (Ptr<Node> source, Ipv4Address des, double dataSize, double dataRate, uint32_t taskId,
+			const std::vector<uint32_t> &relays = std::vector<uint32_t> ());
+	void SendTaskWD (Ptr<Node> source, Ipv4Address des, double dataSize, double dataRate, uint32_t taskId,
+			const std::vector<uint32_t> &relays = std::vector<uint32_t> ());
+	void TransferComplete (std::string context, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+			uint64_t bytes, Time duration, double throughput);
+	void TransferCompleteWD (std::string context, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+			uint64_t bytes, Time duration, double throughput);
+	void TaskPieceSent (uint32_t nodeId, uint8_t iface, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+			uint64_t bytes, Time duration, double throughput);
+	void ReserveTransfer (uint32_t nodeId, uint8_t iface, uint32_t transferId, double dataSize, double dataRate,
+			const std::vector<uint32_t> &relays);
+	void ReleaseTransfer (uint32_t nodeId, uint8_t iface, uint32_t transferId);
+	void DeliverTaskData (uint32_t nodeID, const TrafficClassTag &tag, uint32_t bytes);
+	void ExecuteTask (uint32_t taskId);
+	void ReturnResult (uint32_t nodeID, uint32_t taskId, uint64_t bytes);
+	bool PathBack (uint32_t nodeID, uint32_t target, double horizon, double &rate, std::vector<uint32_t> &relays);
 	void LocationDetector(uint16_t myLoc, uint16_t neighLoc, Ipv4Address myAddress, Ipv4Address src_ip);
 	template <typename T> void PopulateQueue(T &user_task_queue);
 	template<typename T> void PrintQueue(T& q);
@@ -174,20 +397,9 @@ private:
 	void PrintRoutingTableWD (Ptr<OutputStreamWrapper> stream, Ptr<Socket> socket, uint16_t id) const;
 	void PrintRoutingTable();
 
-	static constexpr uint16_t nNodes = 5;
-	uint32_t tasksAssigned[nNodes];
-	uint32_t tasksFailed[nNodes];
 	NodeContainer adhocNodes;
 	uint32_t port;
 	uint32_t portWD;
-	uint32_t bytesTotalDisc[nNodes] = {};
-	uint32_t packetsReceivedDisc[nNodes] = {};
-	uint32_t bytesTotalWDDisc[nNodes] = {};
-	uint32_t packetsReceivedWDDisc[nNodes] = {};
-	uint32_t bytesTotalApp[nNodes] = {};
-	uint32_t packetsReceivedApp[nNodes] = {};
-	uint32_t bytesTotalWDApp[nNodes] = {};
-	uint32_t packetsReceivedWDApp[nNodes] = {};
 	std::string m_CSVfileName;
 	uint32_t m_nSinks;
 	std::string m_protocolName;
@@ -195,17 +407,7 @@ private:
 	double m_txp;
 	bool m_traceMobility;
 	uint32_t m_protocol;
-	uint32_t currentSeqNo[nNodes] = {};
-	bool m_firstTime[nNodes] = {true,true,true,true,true};
-	long double delay[nNodes] = {};
-	long double rcv[nNodes] = {};
-	long double sqhd[nNodes] = {};
 	std::map<Ipv4Address, Ipv4Address> m_interfaceMap;
-	uint32_t currentSeqNoWD[nNodes] = {};
-	long double delayWD[nNodes] = {};
-	long double rcvWD[nNodes] = {};
-	long double sqhdWD[nNodes] = {};
-	uint32_t m_nSources;
 	uint32_t MacTxDropCount = 0;
 	uint32_t PhyTxDropCount = 0;
 	uint32_t PhyRxDropCount = 0;
@@ -218,45 +420,79 @@ private:
 	std::map<Ipv4Address, uint64_t>appPktWDRec;
 	uint64_t discPkt = 0;
 	uint64_t discPktWD = 0;
-
-	uint64_t counterTX[nNodes] = {};
-	uint64_t counterRX[nNodes] = {};
-	uint64_t counterAppTX[nNodes] = {};
-	uint64_t counterAppRX[nNodes] = {};
-
-	uint64_t counterTXWD[nNodes] = {};
-	uint64_t counterRXWD[nNodes] = {};
-	uint64_t counterAppTXWD[nNodes] = {};
-	uint64_t counterAppRXWD[nNodes] = {};
-
-	uint64_t m_txDataRate[nNodes] = {};
-	uint64_t m_rxDataRate[nNodes] = {};
-	uint64_t m_txDataRateWD[nNodes] = {};
-	uint64_t m_rxDataRateWD[nNodes] = {};
-
-	double m_throughputDisc[nNodes] = {};
-	double m_throughputWDDisc[nNodes] = {};
-	double m_throughputApp[nNodes] = {};
-	double m_throughputWDApp[nNodes] = {};
-	double mbsApp[nNodes] = {};
-	double mbsDisc[nNodes] = {};
-	double mbsWDDisc[nNodes] = {};
-	double mbsWDApp[nNodes] = {};
 	uint64_t m_timer = 0;
-	double m_timeFirstPktAppSent[nNodes] = {};
-	double m_timeFirstPktAppWDSent[nNodes] = {};
-	double m_timeFirstPktDiscSent[nNodes] = {};
-	double m_timeFirstPktDiscWDSent[nNodes] = {};
-	bool m_firstTimeAppPktSent[nNodes] = {true, true, true, true, true};
-	bool m_firstTimeDiscPktSent[nNodes] = {true, true, true, true, true};
-	bool m_firstTimeAppWDPktSent[nNodes] = {true, true, true, true, true};
-	bool m_firstTimeDiscWDPktSent[nNodes] = {true, true, true, true, true};
 	RTable m_rTableWD, m_rTableW;
 	Ptr<Socket> sink, sinkWD;
 	Ptr<Socket> DiscoverySink, DiscoverySinkWD;
 	Ptr<Socket> ReplySink, ReplySinkWD;
     int m_NodeId;
     std::vector<std::vector<TaskDetails>> allTasks;
+	std::vector<NodeStats, CacheAlignedAllocator<NodeStats> > m_nodeStats; //!< per node state, indexed by node id
+	MetricsSink m_metrics; //!< buffered writer for the throughput metrics
+	std::vector<MetricsSink::Handle> m_throughputOut; //!< output handle of each node
+	bool m_columnarMetrics; //!< one columnar file with a NodeId column instead of a CSV file per node
+	bool m_perNodeSampling; //!< sample each node in its own event, staggered over the period
+	uint64_t m_sampleTick; //!< sampling periods so far
+	std::vector<MetricsRecord> m_sampleRows; //!< rows of the current sampling batch
+	std::vector<LatencyHistogram> m_latency; //!< application latency of each node in the current period, Wi-Fi
+	std::vector<LatencyHistogram> m_latencyWD; //!< application latency of each node in the current period, Wi-Fi Direct
+	LatencyHistogram m_latencyRun; //!< application latency of all nodes over the reported periods, Wi-Fi
+	LatencyHistogram m_latencyRunWD; //!< application latency of all nodes over the reported periods, Wi-Fi Direct
+	TaskTracker m_taskTracker; //!< delivery and completion of every task
+	EventTrace m_eventTrace; //!< binary trace of the events analysed after the run
+	std::string m_eventTraceFile; //!< where the event trace goes, empty to disable it
+	bool m_eventTraceKeepLast; //!< keep only the last events of the trace
+	bool m_verbose; //!< enable the debug log of the experiment
+	bool m_routeDumps; //!< append the routing table to its .routes file on every discovery and reply
+	std::string m_captureMode; //!< full, ring or off
+	double m_captureWindow; //!< seconds of frames kept per device in ring mode
+	std::string m_captureClass; //!< traffic class kept in ring mode, or all
+	int32_t m_captureNode; //!< node whose frames are kept in ring mode, or -1 for all
+	std::unique_ptr<PcapRingCapture> m_capture; //!< ring capture, only in ring mode
+	uint32_t m_inActiveRoutes; //!< inactive routes at the last LinkLifeTimer
+	double m_flowmonInterval; //!< seconds between two flow delta exports, 0 to disable them
+	bool m_flowmonXml; //!< write the FlowMonitor XML file at the end of the run
+	std::unique_ptr<FlowStatsExporter> m_flowExporter; //!< streams per flow deltas to the metrics sink
+	uint32_t m_maxActiveTransfers; //!< transfers an interface sends at once, 0 for no limit
+	bool m_striping; //!< split tasks across several neighbours and both interfaces
+	uint32_t m_stripeWidth; //!< most neighbours per interface a striped task uses
+	double m_batchWindow; //!< seconds tasks are collected before a batch assignment, 0 to assign them one by one
+	std::vector<BatchTask> m_batch; //!< tasks waiting for the next batch assignment
+	std::vector<Time> m_batchQueued; //!< when each task of m_batch was queued
+	EventId m_batchEvent; //!< next AllocateBatch
+	bool m_nodeQueues; //!< queue tasks per node in deadline order instead of rejecting those that cannot be placed at once
+	bool m_stealing; //!< let idle neighbours take over queued tasks
+	std::vector<NodeTaskQueue> m_taskQueues; //!< per node tasks waiting to be placed, earliest deadline first
+	std::vector<EventId> m_serveEvents; //!< per node next retry of its queue
+	std::map<Ipv4Address, uint32_t> m_addressNode; //!< Wi-Fi address to node id
+	bool m_supervise; //!< move transfers off links that break
+	double m_superviseInterval; //!< seconds between two checks of the transfers
+	double m_linkBreakTimeout; //!< seconds without a frame from a peer before its link counts as broken
+	std::vector<std::map<Ipv4Address, Time> > m_lastFrame; //!< per node last frame sniffed from each neighbour address
+	std::string m_linkLifetime; //!< interval, expected or quantile
+	double m_lifetimeRisk; //!< probability of a link breaking before the lifetime planned with, in quantile mode
+	LinkLifetimePredictor m_lifetimePredictor;
+	bool m_splitCache; //!< reuse the split of a task until the routes of the node change
+	std::vector<SplitCache> m_splitCaches; //!< per node splits of the current routing table epochs
+	double m_splitRateStep; //!< Mbps the bandwidths of a cached split are rounded down to
+	uint64_t m_splitHits; //!< splits answered from m_splitCaches
+	uint64_t m_splitMisses; //!< splits computed
+	bool m_execution; //!< run tasks on the neighbours that receive them and send the results back
+	double m_cyclesPerBit; //!< CPU cycles a task needs per bit of its data
+	double m_resultRatio; //!< size of the results relative to the data a neighbour received
+	std::vector<double> m_cpuSpeed; //!< per node processor speed it last advertised, in GHz, 0 before its first reply
+	std::vector<Time> m_cpuFree; //!< per node time its CPU has run the parts queued on it
+	uint32_t m_maxHops; //!< most hops to a helper, above 1 only with a routing protocol
+	std::vector<Ptr<TransferApplication> > m_transferW; //!< per node sender of task data on W
+	std::vector<Ptr<TransferApplication> > m_transferWD; //!< per node sender of task data on WD
+	std::map<uint32_t, uint32_t> m_piecesInFlight; //!< task id to pieces not fully sent yet
+	EventId m_generateEvent; //!< next GenerateTasks
+	std::vector<BandwidthLedger> m_ledgerW; //!< per node rate committed to task transfers on W
+	std::vector<BandwidthLedger> m_ledgerWD; //!< per node rate committed to task transfers on WD
+	std::map<std::tuple<uint32_t, uint8_t, uint32_t>, std::vector<std::pair<uint32_t, BandwidthLedger::ReservationId> > >
+		m_pieceReservations; //!< (node, interface, transfer id) to the reservations of that transfer on the node and its relays
+	std::map<std::tuple<uint32_t, uint8_t, uint32_t>, std::pair<uint32_t, QueuedTask> >
+		m_handoffs; //!< (victim, interface, transfer id) of a stolen task on its way to the thief, to the thief and the task
 
 };
 
@@ -303,14 +539,13 @@ template<typename T> void RoutingExperiment::PrintQueue(T& q){
 template <typename T>
 void RoutingExperiment::PopulateQueue(T &userTaskQueue){
 	srand((int) time(NULL));
-    uint32_t taskSizeArray[5] = {110, 300, 190, 750, 150};
-    uint32_t taskDeadlineArray[5] = {10, 20, 15, 30, 12};
     int i = 0;
 	while (i < 5){
-        uint32_t ds = taskSizeArray[i];
+        uint32_t ds = TASK_SIZES[i];
 
-        uint32_t dl = taskDeadlineArray[i];
+        uint32_t dl = TASK_DEADLINES[i];
 
+		m_taskTracker.Create (i, Simulator::Now ());
 		userTaskQueue.push(UserTask(dl,ds,i));
 		i++;
 		std::this_thread::sleep_for(std::chrono::milliseconds(rand() % 2000 + 1));
@@ -358,8 +593,14 @@ void RoutingExperiment::PrintRoutingTable()
 }
 
 void
-RoutingExperiment::CheckIfTaskCompleted(int sourceID, Ipv4Address dest, double dataSize)
+RoutingExperiment::CheckIfTaskCompleted(int sourceID, Ipv4Address dest, double dataSize, uint32_t taskId)
 {
+	if (m_taskTracker.IsInFlight (taskId))
+	{
+		NS_LOG_DEBUG("Task " << taskId << " of node " << sourceID << " missed its deadline");
+		if (m_capture)
+			m_capture->Trigger ("manet-routing-compare-ring", "deadline");
+	}
 	Ptr<Node> source = NodeList::GetNode(sourceID);
 	Ipv4Address sourceIPW = source->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
 	Ipv4Address sourceIPWD = source->GetObject<Ipv4>()->GetAddress(2,0).GetLocal();
@@ -376,69 +617,291 @@ RoutingExperiment::CheckIfTaskCompleted(int sourceID, Ipv4Address dest, double d
 	appPktWDRec[destIPWD] = 0;
 }
 
+// The allocator works in Mbit against Mbps
+static uint64_t
+TransferBytes (double dataSize)
+{
+	return static_cast<uint64_t> (std::ceil (dataSize * 1e6 / 8));
+}
+
+void
+RoutingExperiment::SendTaskW (Ptr<Node> source, Ipv4Address des, double dataSize, double dataRate, uint32_t taskId,
+		const std::vector<uint32_t> &relays)
+{
+	HOT_LOG_DEBUG ("Sending " << dataSize << " Mbit of task " << taskId << " through W to " << des << " port " << port + 1);
+	uint32_t transferId = m_transferW[source->GetId ()]->StartTransfer (InetSocketAddress (des, port + 1), TransferBytes (dataSize),
+			DataRate (static_cast<uint64_t> (dataRate * 1e6)), taskId);
+	if (transferId == 0)
+		return;
+	m_piecesInFlight[taskId]++;
+	ReserveTransfer (source->GetId (), 0, transferId, dataSize, dataRate, relays);
+}
+
+void
+RoutingExperiment::SendTaskWD (Ptr<Node> source, Ipv4Address des, double dataSize, double dataRate, uint32_t taskId,
+		const std::vector<uint32_t> &relays)
+{
+	HOT_LOG_DEBUG ("Sending " << dataSize << " Mbit of task " << taskId << " through WD to " << des << " port " << portWD + 1);
+	uint32_t transferId = m_transferWD[source->GetId ()]->StartTransfer (InetSocketAddress (des, portWD + 1), TransferBytes (dataSize),
+			DataRate (static_cast<uint64_t> (dataRate * 1e6)), taskId);
+	if (transferId == 0)
+		return;
+	m_piecesInFlight[taskId]++;
+	ReserveTransfer (source->GetId (), 1, transferId, dataSize, dataRate, relays);
+}
+
+void
+RoutingExperiment::TransferComplete (std::string context, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+		uint64_t bytes, Time duration, double throughput)
+{
+	TaskPieceSent (std::stoi (context), 0, transferId, taskId, trafficClass, bytes, duration, throughput);
+}
+
+void
+RoutingExperiment::TransferCompleteWD (std::string context, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+		uint64_t bytes, Time duration, double throughput)
+{
+	TaskPieceSent (std::stoi (context), 1, transferId, taskId, trafficClass, bytes, duration, throughput);
+}
+
+// Ledger ids are only unique within the ledger of one node and interface, transfer ids within one sender.
+// Every relay forwards the transfer at its rate, so it is booked in their ledgers as well.
+void
+RoutingExperiment::ReserveTransfer (uint32_t nodeId, uint8_t iface, uint32_t transferId, double dataSize, double dataRate,
+		const std::vector<uint32_t> &relays)
+{
+	std::vector<BandwidthLedger> &ledgers = iface == 0 ? m_ledgerW : m_ledgerWD;
+	std::vector<std::pair<uint32_t, BandwidthLedger::ReservationId> > &reservations =
+			m_pieceReservations[std::make_tuple (nodeId, iface, transferId)];
+	ledgers[nodeId].Expire (Simulator::Now ());
+	reservations.push_back (std::make_pair (nodeId, ledgers[nodeId].Reserve (Simulator::Now (), Seconds (dataSize / dataRate), dataRate)));
+	for (std::size_t i = 0; i < relays.size (); i++)
+	{
+		ledgers[relays[i]].Expire (Simulator::Now ());
+		reservations.push_back (std::make_pair (relays[i], ledgers[relays[i]].Reserve (Simulator::Now (), Seconds (dataSize / dataRate), dataRate)));
+	}
+}
+
+void
+RoutingExperiment::ReleaseTransfer (uint32_t nodeId, uint8_t iface, uint32_t transferId)
+{
+	std::map<std::tuple<uint32_t, uint8_t, uint32_t>, std::vector<std::pair<uint32_t, BandwidthLedger::ReservationId> > >::iterator
+			reservation = m_pieceReservations.find (std::make_tuple (nodeId, iface, transferId));
+	if (reservation == m_pieceReservations.end ())
+		return;
+	for (std::size_t i = 0; i < reservation->second.size (); i++)
+		(iface == 0 ? m_ledgerW : m_ledgerWD)[reservation->second[i].first].Release (reservation->second[i].second, Simulator::Now ());
+	m_pieceReservations.erase (reservation);
+}
+
+void
+RoutingExperiment::TaskPieceSent (uint32_t nodeId, uint8_t iface, uint32_t transferId, uint32_t taskId, TrafficClassTag::TrafficClass trafficClass,
+		uint64_t bytes, Time duration, double throughput)
+{
+	ReleaseTransfer (nodeId, iface, transferId);
+	std::map<std::tuple<uint32_t, uint8_t, uint32_t>, std::pair<uint32_t, QueuedTask> >::iterator
+			handoff = m_handoffs.find (std::make_tuple (nodeId, iface, transferId));
+	if (handoff != m_handoffs.end ())
+	{
+		// the data of a stolen task is on the thief now: it queues there like one of its own
+		uint32_t thief = handoff->second.first;
+		m_taskQueues[thief].push (handoff->second.second);
+		m_eventTrace.Record (EVENT_QUEUE_DEPTH, thief, 0, taskId, m_taskQueues[thief].size ());
+		m_handoffs.erase (handoff);
+		ServeQueue (thief);
+		return;
+	}
+	// results sent back by a helper are no piece of a task the node placed
+	if (trafficClass != TrafficClassTag::APPLICATION)
+		return;
+	NS_LOG_DEBUG ("Node " << nodeId << " sent " << bytes << " bytes of task " << taskId << " in "
+			<< duration.GetSeconds () << "s at " << throughput / 1e6 << "Mbps");
+	m_eventTrace.Record (EVENT_TRANSFER_COMPLETE, nodeId, iface, taskId, throughput / 1e6);
+	std::map<uint32_t, uint32_t>::iterator pieces = m_piecesInFlight.find (taskId);
+	if (pieces == m_piecesInFlight.end () || --pieces->second > 0)
+		return;
+	m_piecesInFlight.erase (pieces);
+	if (m_nodeQueues)
+	{
+		ServeQueue (nodeId);
+		if (m_stealing && m_taskQueues[nodeId].empty ())
+			Steal (nodeId);
+	}
+	// the task has left the node: start the next queued one now rather than after the random gap
+	if (!orderedQueue.empty () && m_generateEvent.IsRunning ())
+	{
+		m_generateEvent.Cancel ();
+		GenerateTasks ();
+	}
+}
+
 void
-RoutingExperiment::InstallApplicationsW (Ptr<Node> source, Ipv4Address des, double simTime, double dataRate)
-{
-	std::string rate = std::to_string(dataRate)+"Mbps";
-	NS_LOG_DEBUG("Sending the task through W");
-	OnOffHelper onoff1 ("ns3::UdpSocketFactory", Address (InetSocketAddress (des, port + 1)));
-	NS_LOG_DEBUG("Interface Address of WiFi: " << des << "and Port Number: " << port + 1);
-	onoff1.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1.0]"));
-	onoff1.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
-	onoff1.SetAttribute ("DataRate", DataRateValue(DataRate(rate)));
-	onoff1.SetAttribute ("PacketSize", StringValue("1024"));
-	ApplicationContainer apps = onoff1.Install (source);
-	apps.Start (Seconds(0));
-	NS_LOG_DEBUG( "Wifi App Started" );
-	NS_LOG_DEBUG("WiFi Interface APP Port Number: " << port);
-	apps.Stop (Seconds(simTime));
-	NS_LOG_DEBUG( "Wifi App Stopped at: " << simTime );
-	int nApplications = source->GetNApplications();
-	int nodeIndex = source->GetId();
-	std::stringstream oss;
-	oss << "/NodeList/" << nodeIndex <<"/ApplicationList/" << nApplications - 1 <<"/$ns3::OnOffApplication/TxWithAddresses";
-	Config::ConnectWithoutContext(oss.str(), MakeCallback(&RoutingExperiment::txApp, this));
-}
-
-void RoutingExperiment::InstallApplicationsWD(Ptr<Node> source, Ipv4Address des, double simTime, double dataRate)
-{
-	std::string rate = std::to_string(dataRate)+"Mbps";
-	NS_LOG_DEBUG("Sending the task through WD");
-	OnOffHelper onoff1 ("ns3::UdpSocketFactory", Address (InetSocketAddress (des, portWD + 1)));
-	NS_LOG_DEBUG("Interface Address of WiFi: " << des << " and Port Number: " << portWD + 1);
-	onoff1.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1.0]"));
-	onoff1.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
-	onoff1.SetAttribute ("DataRate", StringValue (rate));
-	onoff1.SetAttribute ("PacketSize", StringValue("1024"));
-	ApplicationContainer apps = onoff1.Install (source);
-	apps.Start (Seconds(0));
-	NS_LOG_DEBUG( "Wifi App Started" );
-	NS_LOG_DEBUG("WiFi Interface APP Port Number: " << portWD);
-	apps.Stop (Seconds(simTime));
-	NS_LOG_DEBUG( "Wifi App Stopped at: " << simTime );
-	int nApplications = source->GetNApplications();
-	int nodeIndex = source->GetId();
-	std::stringstream oss;
-	oss << "/NodeList/" << nodeIndex <<"/ApplicationList/" << nApplications - 1 <<"/$ns3::OnOffApplication/TxWithAddresses";
-	Config::ConnectWithoutContext(oss.str(), MakeCallback(&RoutingExperiment::txAppWD, this));
+RoutingExperiment::DeliverTaskData (uint32_t nodeID, const TrafficClassTag &tag, uint32_t bytes)
+{
+	if (tag.GetTrafficClass () == TrafficClassTag::RESULT)
+		m_taskTracker.DeliverResult (tag.GetTaskId (), bytes, Simulator::Now ());
+	else if (tag.GetTrafficClass () == TrafficClassTag::APPLICATION
+			&& m_taskTracker.Deliver (tag.GetTaskId (), tag.GetInterfaceKind (), bytes, Simulator::Now (), nodeID) && m_execution)
+		ExecuteTask (tag.GetTaskId ());
 }
 
+// Every neighbour runs the part of the task it received once its CPU has run the parts queued before,
+// at the processor speed it last advertised, or the lowest one it could advertise if it has not replied
+// to any discovery yet, then sends its share of the results back.
+void
+RoutingExperiment::ExecuteTask (uint32_t taskId)
+{
+	std::map<uint32_t, uint64_t> parts = m_taskTracker.GetReceived (taskId);
+	Time now = Simulator::Now ();
+	for (std::map<uint32_t, uint64_t>::const_iterator part = parts.begin (); part != parts.end (); ++part)
+	{
+		double cycles = part->second * 8 * m_cyclesPerBit;
+		double speed = m_cpuSpeed[part->first] > 0 ? m_cpuSpeed[part->first] : 1.0;
+		Time start = std::max (now, m_cpuFree[part->first]);
+		Time end = start + Seconds (cycles / (speed * 1e9));
+		m_cpuFree[part->first] = end;
+		uint64_t result = std::max<uint64_t> (1, static_cast<uint64_t> (std::ceil (part->second * m_resultRatio)));
+		m_taskTracker.Execute (taskId, start, end);
+		m_taskTracker.ExpectResult (taskId, result);
+		m_eventTrace.Record (EVENT_TASK_EXECUTED, part->first, 0, taskId, (end - now).GetSeconds ());
+		NS_LOG_DEBUG ("Node " << part->first << " runs " << part->second << " bytes of task " << taskId
+				<< " at " << speed << "GHz from " << start.GetSeconds () << "s to " << end.GetSeconds () << "s");
+		Simulator::Schedule (end - now, &RoutingExperiment::ReturnResult, this, part->first, taskId, result);
+	}
+}
+
+// Send the results over the interface with a route back to the source and the most bandwidth left
+void
+RoutingExperiment::ReturnResult (uint32_t nodeID, uint32_t taskId, uint64_t bytes)
+{
+	Ptr<Node> node = NodeList::GetNode (nodeID);
+	Ptr<Node> source = NodeList::GetNode (m_taskTracker.GetSourceNode (taskId));
+	double left = std::max ((m_taskTracker.GetDeadline (taskId) - Simulator::Now ()).GetSeconds (), 1.0);
+	double availableBWW, availableBWWD;
+	AvailableBandwidth (nodeID, left, availableBWW, availableBWWD);
+	int32_t iface = -1;
+	double best = 0;
+	Ipv4Address dest;
+	for (uint8_t k = 0; k < 2; k++)
+	{
+		double rate = k == 0 ? availableBWW : availableBWWD;
+		Ipv4Address me = node->GetObject<Ipv4> ()->GetAddress (k + 1, 0).GetLocal ();
+		Ipv4Address peer = source->GetObject<Ipv4> ()->GetAddress (k + 1, 0).GetLocal ();
+		RTableEntry route;
+		if (rate > best && (k == 0 ? m_rTableW : m_rTableWD).LookupRoute (peer, me, route))
+		{
+			iface = k;
+			best = rate;
+			dest = peer;
+		}
+	}
+	// a helper further away reaches the source over the routing protocol, along a path of the neighbour tables
+	std::vector<uint32_t> relays;
+	if (iface < 0 && m_maxHops > 1 && PathBack (nodeID, source->GetId (), left, best, relays))
+	{
+		iface = 0;
+		dest = source->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+	}
+	if (iface < 0)
+	{
+		NS_LOG_DEBUG ("Node " << nodeID << " has no link back to the source of task " << taskId << ", its results are lost");
+		return;
+	}
+	NS_LOG_DEBUG ("Node " << nodeID << " returns " << bytes << " bytes of results of task " << taskId
+			<< " over " << (iface == 0 ? "W" : "WD") << " at " << best << "Mbps through " << relays.size () << " relays");
+	uint32_t transferId = (iface == 0 ? m_transferW : m_transferWD)[nodeID]->StartTransfer (
+			InetSocketAddress (dest, (iface == 0 ? port : portWD) + 1), bytes, DataRate (static_cast<uint64_t> (best * 1e6)),
+			taskId, TrafficClassTag::RESULT);
+	if (transferId != 0)
+		ReserveTransfer (nodeID, iface, transferId, bytes * 8 / 1e6, best, relays);
+}
+
+// Breadth first search over the Wi-Fi neighbour tables for a path of at most m_maxHops hops from nodeID to
+// target, as ComputeMultiHopSplit looks for helpers. rate is the least bandwidth left on the way shared by
+// the hops, and relays the nodes between the two.
+bool
+RoutingExperiment::PathBack (uint32_t nodeID, uint32_t target, double horizon, double &rate, std::vector<uint32_t> &relays)
+{
+	std::vector<bool> seen (NodeList::GetNNodes (), false);
+	seen[nodeID] = true;
+	std::queue<HelperPath> open;
+	HelperPath start = {nodeID, 0, std::numeric_limits<double>::max (), 0, horizon, 0};
+	open.push (start);
+	while (!open.empty ())
+	{
+		HelperPath path = open.front ();
+		open.pop ();
+		if (path.hops >= m_maxHops)
+			continue;
+		double bwW, bwWD;
+		AvailableBandwidth (path.node, horizon, bwW, bwWD);
+		std::map<Ipv4Address, RTableEntry> routesW =
+				m_rTableW.GetAllRoutesWithIP (NodeList::GetNode (path.node)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ());
+		for (std::map<Ipv4Address, RTableEntry>::const_iterator i = routesW.begin (); i != routesW.end (); ++i)
+		{
+			std::map<Ipv4Address, uint32_t>::const_iterator node = m_addressNode.find (i->first);
+			if (node == m_addressNode.end () || seen[node->second])
+				continue;
+			seen[node->second] = true;
+			HelperPath next = path;
+			next.node = node->second;
+			next.hops = path.hops + 1;
+			next.rateW = std::min (path.rateW, bwW);
+			if (path.hops > 0)
+				next.relays.push_back (path.node);
+			if (next.node == target)
+			{
+				rate = next.rateW / next.hops;
+				relays = next.relays;
+				return rate > 0;
+			}
+			open.push (next);
+		}
+	}
+	return false;
+}
 
 RoutingExperiment::RoutingExperiment ()
 : port (9),
   portWD (80),
   m_CSVfileName ("manet-routing.output.csv"),
+  m_nSinks (5),
   m_traceMobility (true),
-  m_protocol (0),
-  m_nSources(nNodes)// DSDV
+  m_protocol (0),// DSDV
+  m_columnarMetrics (false),
+  m_perNodeSampling (false),
+  m_sampleTick (0),
+  m_taskTracker (2 * 1024), // a partial last packet on each interface
+  m_eventTraceKeepLast (false),
+  m_verbose (false),
+  m_routeDumps (false),
+  m_captureMode ("full"),
+  m_captureWindow (5.0),
+  m_captureClass ("all"),
+  m_captureNode (-1),
+  m_inActiveRoutes (0),
+  m_flowmonInterval (1.0),
+  m_flowmonXml (true),
+  m_maxActiveTransfers (0),
+  m_striping (false),
+  m_stripeWidth (3),
+  m_batchWindow (0),
+  m_nodeQueues (false),
+  m_stealing (true),
+  m_supervise (false),
+  m_superviseInterval (0.5),
+  m_linkBreakTimeout (2.0),
+  m_linkLifetime ("interval"),
+  m_lifetimeRisk (0.1),
+  m_splitCache (true),
+  m_splitRateStep (1.0),
+  m_splitHits (0),
+  m_splitMisses (0),
+  m_execution (false),
+  m_cyclesPerBit (10),
+  m_resultRatio (0.1),
+  m_maxHops (1)
 {
-    for(uint32_t i = 0;i<m_nSources;i++)
-	{
-		tasksAssigned[i] = 0;
-		tasksFailed[i] = 0;
-        std::vector<TaskDetails> temp;
-        allTasks.push_back(temp);
-	}
     m_NodeId = 0;
 }
 
@@ -453,6 +916,20 @@ RoutingExperiment::TimeIntervalToTime(uint16_t interval)
 	default: return 10;
 	}
 }
+// neighbour is the Wi-Fi address of the neighbour
+double
+RoutingExperiment::PredictLinkLifetime (Ptr<Node> me, Ipv4Address neighbour, uint16_t neighbourInterval)
+{
+	Ptr<MarkovChainMobilityModel> mine = me->GetObject<MarkovChainMobilityModel>();
+	std::map<Ipv4Address, uint32_t>::const_iterator node = m_addressNode.find (neighbour);
+	if (m_linkLifetime == "interval" || node == m_addressNode.end ())
+		return std::min(TimeIntervalToTime(neighbourInterval), TimeIntervalToTime(mine->GetNextTime()));
+	m_lifetimePredictor.Predict (mine, NodeList::GetNode (node->second)->GetObject<MarkovChainMobilityModel>());
+	if (m_linkLifetime == "quantile")
+		return m_lifetimePredictor.GetQuantile (m_lifetimeRisk);
+	return m_lifetimePredictor.GetExpectation ();
+}
+
 void
 RoutingExperiment::StartTaskGeneration()
 {
@@ -473,39 +950,698 @@ RoutingExperiment::GenerateTasks()
 	NS_LOG_DEBUG("DataSize: " << dataSize << "MB");
 //	Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable>();
 //	x->SetAttribute("Min",DoubleValue(0));
-//	x->SetAttribute("Max",DoubleValue(m_nSources-1));
+//	x->SetAttribute("Max",DoubleValue(m_nSinks-1));
 //	int nodeID = x->GetInteger();
-    int nodeID = m_NodeId++;
+    int nodeID = m_NodeId++ % m_nSinks;
 	NS_LOG_DEBUG("Node ID: " << nodeID << ", Data Size: " << dataSize << "MB, Deadline: " << deadline << "s");
-	AllocateAndSend(nodeID, dataSize, deadline, false);
+	if (m_batchWindow > 0)
+		QueueForBatch (nodeID, task.getTaskId(), dataSize, deadline);
+	else if (m_nodeQueues)
+		EnqueueTask (nodeID, task.getTaskId(), dataSize, deadline);
+	else
+		AllocateAndSend(nodeID, task.getTaskId(), dataSize, deadline, false);
+}
+
+void
+RoutingExperiment::QueueForBatch (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine)
+{
+	m_nodeStats[nodeID].tasksAssigned++;
+	BatchTask pending = {taskId, static_cast<uint32_t> (nodeID), tDataSize, tDeadLine};
+	m_batch.push_back (pending);
+	m_batchQueued.push_back (Simulator::Now ());
+	orderedQueue.pop ();
+	if (!m_batchEvent.IsRunning ())
+		m_batchEvent = Simulator::Schedule (Seconds (m_batchWindow), &RoutingExperiment::AllocateBatch, this);
+	ScheduleNextTask ();
+}
+
+void
+RoutingExperiment::AllocateBatch ()
+{
+	Time now = Simulator::Now ();
+	std::vector<BatchTask> tasks (m_batch);
+	std::map<uint32_t, double> horizon;
+	for (std::size_t t = 0; t < tasks.size (); t++)
+	{
+		// waiting for the batch ate into the deadline
+		tasks[t].deadline = std::max (0.0, tasks[t].deadline - (now - m_batchQueued[t]).GetSeconds ());
+		horizon[tasks[t].node] = std::max (horizon[tasks[t].node], tasks[t].deadline);
+	}
+
+	std::vector<BatchLink> links;
+	std::vector<Ipv4Address> linkDest;
+	for (std::map<uint32_t, double>::const_iterator n = horizon.begin (); n != horizon.end (); ++n)
+	{
+		double availableBWW, availableBWWD;
+		AvailableBandwidth (n->first, n->second, availableBWW, availableBWWD);
+		Ptr<Node> source = NodeList::GetNode (n->first);
+		std::map<Ipv4Address, RTableEntry> allRoutesW = m_rTableW.GetAllRoutesWithIP (source->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ());
+		std::map<Ipv4Address, RTableEntry> allRoutesWD = m_rTableWD.GetAllRoutesWithIP (source->GetObject<Ipv4> ()->GetAddress (2, 0).GetLocal ());
+		for (std::map<Ipv4Address, RTableEntry>::const_iterator i = allRoutesW.begin (); i != allRoutesW.end (); ++i)
+		{
+			BatchLink link = {n->first, i->first.Get (), 0, availableBWW, std::max (0.0, i->second.getLinkLifeTime ())};
+			links.push_back (link);
+			linkDest.push_back (i->first);
+		}
+		for (std::map<Ipv4Address, RTableEntry>::const_iterator i = allRoutesWD.begin (); i != allRoutesWD.end (); ++i)
+		{
+			BatchLink link = {n->first, WifiAddressOf (i->first).Get (), 1, availableBWWD, std::max (0.0, i->second.getLinkLifeTime ())};
+			links.push_back (link);
+			linkDest.push_back (i->first);
+		}
+	}
+
+	BatchResult result = BatchAllocator::Assign (tasks, links);
+	NS_LOG_DEBUG ("Batch of " << tasks.size () << " tasks over " << links.size () << " links: " << result.GetAccepted () << " accepted");
+
+	std::vector<TaskDetails> details (tasks.size ());
+	std::vector<int32_t> firstPiece (tasks.size (), -1);
+	for (std::size_t p = 0; p < result.pieces.size (); p++)
+	{
+		const BatchPiece &piece = result.pieces[p];
+		const BatchLink &link = links[piece.link];
+		Ptr<Node> source = NodeList::GetNode (link.node);
+		if (piece.start > 0)
+		{
+			// queued behind the earlier pieces of the interface: book it now, send it at its start
+			BandwidthLedger::ReservationId booked = (link.iface == 0 ? m_ledgerW : m_ledgerWD)[link.node].Reserve (now + Seconds (piece.start),
+					Seconds (piece.duration), link.rate);
+			m_piecesInFlight[tasks[piece.task].taskId]++;
+			Simulator::Schedule (Seconds (piece.start), &RoutingExperiment::SendBatchPiece, this, link.node, link.iface,
+					linkDest[piece.link], piece.data, link.rate, tasks[piece.task].taskId, booked);
+		}
+		else if (link.iface == 0)
+			SendTaskW (source, linkDest[piece.link], piece.data, link.rate, tasks[piece.task].taskId);
+		else
+			SendTaskWD (source, linkDest[piece.link], piece.data, link.rate, tasks[piece.task].taskId);
+		if (firstPiece[piece.task] < 0)
+			firstPiece[piece.task] = p;
+		details[piece.task].dataTransferCompleted = std::max (details[piece.task].dataTransferCompleted,
+				now + Seconds (piece.start + piece.duration));
+	}
+	for (std::size_t t = 0; t < tasks.size (); t++)
+	{
+		const BatchTask &task = tasks[t];
+		TaskDetails &thisTask = details[t];
+		thisTask.assignTime = m_batchQueued[t];
+		thisTask.success = result.accepted[t];
+		if (thisTask.success)
+		{
+			thisTask.dataTransferStart = now;
+			const BatchLink &link = links[result.pieces[firstPiece[t]].link];
+			Simulator::Schedule (Seconds (task.deadline), &RoutingExperiment::CheckIfTaskCompleted, this, task.node,
+					Ipv4Address (link.neighbour), task.size, task.taskId);
+			m_taskTracker.Allocate (task.taskId, task.node, now, Seconds (task.deadline),
+					task.size * 1e6 / 8, thisTask.dataTransferCompleted);
+			m_eventTrace.Record (EVENT_TASK_ALLOCATED, task.node, link.iface, task.taskId,
+					(thisTask.dataTransferCompleted - now).GetSeconds ());
+		}
+		else
+		{
+			m_nodeStats[task.node].tasksFailed++;
+			m_taskTracker.Reject (task.taskId, task.node, now, Seconds (task.deadline));
+			m_eventTrace.Record (EVENT_TASK_REJECTED, task.node, 0, task.taskId, task.deadline);
+		}
+		allTasks[task.node].push_back (thisTask);
+	}
+	m_batch.clear ();
+	m_batchQueued.clear ();
+}
+
+void
+RoutingExperiment::SendBatchPiece (uint32_t nodeId, uint8_t iface, Ipv4Address dest, double data, double rate, uint32_t taskId,
+		BandwidthLedger::ReservationId booked)
+{
+	// the send books the piece again, under its transfer id
+	(iface == 0 ? m_ledgerW : m_ledgerWD)[nodeId].Release (booked, Simulator::Now ());
+	m_piecesInFlight[taskId]--;
+	if (iface == 0)
+		SendTaskW (NodeList::GetNode (nodeId), dest, data, rate, taskId);
+	else
+		SendTaskWD (NodeList::GetNode (nodeId), dest, data, rate, taskId);
+}
+
+void
+RoutingExperiment::EnqueueTask (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine)
+{
+	m_nodeStats[nodeID].tasksAssigned++;
+	QueuedTask task = {taskId, tDataSize, Simulator::Now () + Seconds (tDeadLine), Simulator::Now ()};
+	m_taskQueues[nodeID].push (task);
+	m_eventTrace.Record (EVENT_QUEUE_DEPTH, nodeID, 0, taskId, m_taskQueues[nodeID].size ());
+	orderedQueue.pop ();
+	ServeQueue (nodeID);
+	ScheduleNextTask ();
+}
+
+void
+RoutingExperiment::ServeQueue (uint32_t nodeID)
+{
+	NodeTaskQueue &queue = m_taskQueues[nodeID];
+	while (!queue.empty ())
+	{
+		QueuedTask task = queue.top ();
+		double left = (task.deadline - Simulator::Now ()).GetSeconds ();
+		if (left <= 0)
+		{
+			queue.pop ();
+			DropQueuedTask (nodeID, task);
+			continue;
+		}
+		TaskDetails thisTask;
+		thisTask.assignTime = task.queued;
+		if (PlaceTask (nodeID, task.taskId, task.size, left, false, thisTask))
+		{
+			queue.pop ();
+			allTasks[nodeID].push_back (thisTask);
+			m_eventTrace.Record (EVENT_QUEUE_DEPTH, nodeID, 0, task.taskId, queue.size ());
+			continue;
+		}
+		if (m_stealing && OfferToNeighbours (nodeID))
+			continue;
+		// the links of the node are busy: try again when one of its tasks is sent, or in a second
+		if (!m_serveEvents[nodeID].IsRunning ())
+			m_serveEvents[nodeID] = Simulator::Schedule (Seconds (std::min (left, 1.0)), &RoutingExperiment::ServeQueue, this, nodeID);
+		return;
+	}
+}
+
+void
+RoutingExperiment::DropQueuedTask (uint32_t nodeID, const QueuedTask &task)
+{
+	NS_LOG_DEBUG ("Task " << task.taskId << " of node " << nodeID << " missed its deadline in the queue");
+	TaskDetails thisTask;
+	thisTask.assignTime = task.queued;
+	thisTask.success = false;
+	m_nodeStats[nodeID].tasksFailed++;
+	m_taskTracker.Reject (task.taskId, nodeID, task.queued, task.deadline - task.queued);
+	m_eventTrace.Record (EVENT_TASK_REJECTED, nodeID, 0, task.taskId, (task.deadline - task.queued).GetSeconds ());
+	m_eventTrace.Record (EVENT_QUEUE_DEPTH, nodeID, 0, task.taskId, m_taskQueues[nodeID].size ());
+	allTasks[nodeID].push_back (thisTask);
+}
+
+std::vector<uint32_t>
+RoutingExperiment::Neighbours (uint32_t nodeID)
+{
+	std::vector<uint32_t> neighbours;
+	Ipv4Address address = NodeList::GetNode (nodeID)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+	std::map<Ipv4Address, RTableEntry> routes = m_rTableW.GetAllRoutesWithIP (address);
+	for (std::map<Ipv4Address, RTableEntry>::const_iterator i = routes.begin (); i != routes.end (); ++i)
+	{
+		std::map<Ipv4Address, uint32_t>::const_iterator node = m_addressNode.find (i->first);
+		if (node != m_addressNode.end () && node->second != nodeID)
+			neighbours.push_back (node->second);
+	}
+	return neighbours;
+}
+
+// The data of the task is on the victim, so it first goes to the thief over their link with the most bandwidth
+// left. The thief takes the task only if it could still place it once the data is there; it queues the task
+// when the hand-off ends, and takes over no other task before.
+bool
+RoutingExperiment::StealFrom (uint32_t victim, uint32_t thief)
+{
+	NodeTaskQueue &queue = m_taskQueues[victim];
+	QueuedTask task = queue.top ();
+	double left = (task.deadline - Simulator::Now ()).GetSeconds ();
+	if (left <= 0)
+		return false;
+	for (std::map<std::tuple<uint32_t, uint8_t, uint32_t>, std::pair<uint32_t, QueuedTask> >::const_iterator i = m_handoffs.begin ();
+			i != m_handoffs.end (); ++i)
+		if (i->second.first == thief)
+			return false;
+
+	Ptr<Node> from = NodeList::GetNode (victim);
+	Ptr<Node> to = NodeList::GetNode (thief);
+	double availableBWW, availableBWWD;
+	AvailableBandwidth (victim, left, availableBWW, availableBWWD);
+	int32_t iface = -1;
+	double rate = 0;
+	Ipv4Address dest;
+	for (uint8_t k = 0; k < 2; k++)
+	{
+		double available = k == 0 ? availableBWW : availableBWWD;
+		Ipv4Address me = from->GetObject<Ipv4> ()->GetAddress (k + 1, 0).GetLocal ();
+		Ipv4Address peer = to->GetObject<Ipv4> ()->GetAddress (k + 1, 0).GetLocal ();
+		RTableEntry route;
+		if (available > rate && (k == 0 ? m_rTableW : m_rTableWD).LookupRoute (peer, me, route))
+		{
+			iface = k;
+			rate = available;
+			dest = peer;
+		}
+	}
+	if (iface < 0 || task.size / rate >= left)
+		return false;
+	double handoff = task.size / rate;
+	AvailableBandwidth (thief, left - handoff, availableBWW, availableBWWD);
+	if (!DecideSplit (thief, task.size, left - handoff, false, availableBWW, availableBWWD).feasible)
+		return false;
+
+	uint32_t transferId = (iface == 0 ? m_transferW : m_transferWD)[victim]->StartTransfer (
+			InetSocketAddress (dest, (iface == 0 ? port : portWD) + 1), TransferBytes (task.size),
+			DataRate (static_cast<uint64_t> (rate * 1e6)), task.taskId);
+	if (transferId == 0)
+		return false;
+	ReserveTransfer (victim, iface, transferId, task.size, rate, std::vector<uint32_t> ());
+	m_handoffs[std::make_tuple (victim, static_cast<uint8_t> (iface), transferId)] = std::make_pair (thief, task);
+	NS_LOG_DEBUG ("Node " << thief << " takes over task " << task.taskId << " of node " << victim << ", "
+			<< handoff << "s to hand it over on " << (iface == 0 ? "W" : "WD"));
+	queue.pop ();
+	m_nodeStats[thief].tasksStolen++;
+	m_eventTrace.Record (EVENT_TASK_STOLEN, thief, iface, task.taskId, victim);
+	m_eventTrace.Record (EVENT_QUEUE_DEPTH, victim, 0, task.taskId, queue.size ());
+	return true;
+}
+
+// The head of the queue of nodeID cannot be placed: hand it to an idle neighbour that can
+bool
+RoutingExperiment::OfferToNeighbours (uint32_t nodeID)
+{
+	std::vector<uint32_t> neighbours = Neighbours (nodeID);
+	for (std::size_t i = 0; i < neighbours.size (); i++)
+		if (m_taskQueues[neighbours[i]].empty () && StealFrom (nodeID, neighbours[i]))
+			return true;
+	return false;
+}
+
+// thief has nothing queued: take over the head of the deepest queue among its neighbours
+void
+RoutingExperiment::Steal (uint32_t thief)
+{
+	std::vector<uint32_t> victims = Neighbours (thief);
+	std::sort (victims.begin (), victims.end (),
+			[this] (uint32_t a, uint32_t b) { return m_taskQueues[a].size () > m_taskQueues[b].size (); });
+	for (std::size_t i = 0; i < victims.size () && !m_taskQueues[victims[i]].empty (); i++)
+		if (StealFrom (victims[i], thief))
+			return;
+}
+
+void
+RoutingExperiment::SuperviseTransfers ()
+{
+	for (uint32_t i = 0; i < m_transferW.size (); i++)
+		for (uint8_t iface = 0; iface < 2; iface++)
+		{
+			std::vector<TransferApplication::TransferStatus> transfers = (iface == 0 ? m_transferW : m_transferWD)[i]->GetTransfers ();
+			// a task can have several transfers to one peer and StopTransfers stops them together, so they move as one
+			std::map<std::pair<Ipv4Address, uint32_t>, TransferApplication::TransferStatus> merged;
+			std::map<std::pair<Ipv4Address, uint32_t>, std::vector<uint32_t> > transferIds;
+			for (std::size_t t = 0; t < transfers.size (); t++)
+			{
+				// a hand-off has to reach its thief, there is no other node to move it to
+				if (transfers[t].trafficClass != TrafficClassTag::APPLICATION
+						|| m_handoffs.count (std::make_tuple (i, iface, transfers[t].transferId)))
+					continue;
+				std::pair<Ipv4Address, uint32_t> key (InetSocketAddress::ConvertFrom (transfers[t].peer).GetIpv4 (), transfers[t].taskId);
+				if (transferIds[key].empty ())
+					merged[key] = transfers[t];
+				else
+					merged[key].remaining += transfers[t].remaining;
+				transferIds[key].push_back (transfers[t].transferId);
+			}
+			for (std::map<std::pair<Ipv4Address, uint32_t>, TransferApplication::TransferStatus>::const_iterator t = merged.begin ();
+					t != merged.end (); ++t)
+				if (LinkBroken (i, iface, t->first.first))
+					MigrateTransfer (i, iface, t->second, transferIds[t->first]);
+		}
+	Simulator::Schedule (Seconds (m_superviseInterval), &RoutingExperiment::SuperviseTransfers, this);
+}
+
+bool
+RoutingExperiment::LinkBroken (uint32_t nodeID, uint8_t iface, Ipv4Address peer)
+{
+	Ipv4Address me = NodeList::GetNode (nodeID)->GetObject<Ipv4> ()->GetAddress (iface + 1, 0).GetLocal ();
+	RTableEntry route;
+	if (!(iface == 0 ? m_rTableW : m_rTableWD).LookupRoute (peer, me, route))
+		return true;
+	// the tables count a route silent for 5 s inactive, see RTable::GetInActiveRoutes
+	Time now = Simulator::Now ();
+	if (now - route.getTimePktRcvd () > Seconds (5.0))
+		return true;
+	Time heard = route.getTimePktRcvd ();
+	std::map<Ipv4Address, Time>::const_iterator frame = m_lastFrame[nodeID].find (peer);
+	if (frame != m_lastFrame[nodeID].end ())
+		heard = std::max (heard, frame->second);
+	return now - heard > Seconds (m_linkBreakTimeout);
+}
+
+// Send what is left of the transfers of a task to one peer, merged into transfer, on the link of nodeID, other than
+// the broken one, with the most room before the deadline. Leaves them alone if no link can carry them in time, in
+// case the broken link comes back.
+bool
+RoutingExperiment::MigrateTransfer (uint32_t nodeID, uint8_t iface, const TransferApplication::TransferStatus &transfer,
+		const std::vector<uint32_t> &transferIds)
+{
+	Ipv4Address peer = InetSocketAddress::ConvertFrom (transfer.peer).GetIpv4 ();
+	Time deadline = m_taskTracker.GetDeadline (transfer.taskId);
+	double left = (deadline - Simulator::Now ()).GetSeconds ();
+	double data = transfer.remaining * 8 / 1e6;
+	if (left <= 0 || transfer.remaining == 0)
+		return false;
+
+	double availableBWW, availableBWWD;
+	AvailableBandwidth (nodeID, left, availableBWW, availableBWWD);
+	Ptr<Node> source = NodeList::GetNode (nodeID);
+	Ipv4Address dest;
+	int32_t destIface = -1;
+	double best = data;
+	for (uint8_t k = 0; k < 2; k++)
+	{
+		double rate = k == 0 ? availableBWW : availableBWWD;
+		if (rate <= 0)
+			continue;
+		std::map<Ipv4Address, RTableEntry> routes = (k == 0 ? m_rTableW : m_rTableWD).GetAllRoutesWithIP (
+				source->GetObject<Ipv4> ()->GetAddress (k + 1, 0).GetLocal ());
+		for (std::map<Ipv4Address, RTableEntry>::const_iterator i = routes.begin (); i != routes.end (); ++i)
+		{
+			double capacity = rate * std::min (left, i->second.getLinkLifeTime ());
+			if (i->first != peer && capacity >= best && !LinkBroken (nodeID, k, i->first))
+			{
+				best = capacity;
+				dest = i->first;
+				destIface = k;
+			}
+		}
+	}
+	if (destIface < 0)
+	{
+		NS_LOG_DEBUG ("No link of node " << nodeID << " can take over the " << data << " Mbit of task " << transfer.taskId << " left for " << peer);
+		return false;
+	}
+
+	uint64_t bytes = (iface == 0 ? m_transferW : m_transferWD)[nodeID]->StopTransfers (transfer.peer, transfer.taskId);
+	if (bytes == 0)
+		return false;
+	// the new piece replaces the stopped ones
+	for (std::size_t t = 0; t < transferIds.size (); t++)
+		ReleaseTransfer (nodeID, iface, transferIds[t]);
+	m_piecesInFlight[transfer.taskId] -= transferIds.size ();
+	data = bytes * 8 / 1e6;
+	double rate = destIface == 0 ? availableBWW : availableBWWD;
+	if (destIface == 0)
+		SendTaskW (source, dest, data, rate, transfer.taskId);
+	else
+		SendTaskWD (source, dest, data, rate, transfer.taskId);
+
+	// slack used up: how much later the bytes now end than they would have on the old link
+	double slack = data / rate - bytes * 8.0 / transfer.rate.GetBitRate ();
+	NS_LOG_DEBUG ("Node " << nodeID << " moved " << bytes << " bytes of task " << transfer.taskId << " from " << peer
+			<< " to " << dest << ", " << slack << "s of slack used");
+	m_nodeStats[nodeID].bytesMigrated += bytes;
+	m_nodeStats[nodeID].migrationSlack += std::max (slack, 0.0);
+	m_eventTrace.Record (EVENT_TRANSFER_MIGRATED, nodeID, destIface, transfer.taskId, slack);
+	return true;
 }
 
 // lambda is evaluated at compile time using constexpr
 //constexpr auto cmp_proSpeed =[] (RTableEntry left, RTableEntry right) {
 //  return (left.getCurrProSpeed()) > (right.getCurrProSpeed());
 //};
+// Application traffic is recognised by its TrafficClassTag; untagged frames (ARP, routing, control) are counted with discovery
+static bool
+IsApplicationPacket (Ptr<const Packet> packet)
+{
+	TrafficClassTag tag;
+	return packet->PeekPacketTag (tag)
+			&& (tag.GetTrafficClass () == TrafficClassTag::APPLICATION || tag.GetTrafficClass () == TrafficClassTag::RESULT);
+}
+
 bool comparator(RTableEntry &left, RTableEntry &right)
 {
 	return (left.getCurrProSpeed() < right.getCurrProSpeed());
 }
 
 void
-RoutingExperiment::AllocateAndSend(int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed)
+RoutingExperiment::AvailableBandwidth (int nodeID, double horizon, double &availableBWW, double &availableBWWD)
 {
+	// the sampled application rate is up to a second old and misses transfers admitted since, so the
+	// rate still committed until the horizon counts instead whenever it is higher
+	m_ledgerW[nodeID].Expire (Simulator::Now ());
+	m_ledgerWD[nodeID].Expire (Simulator::Now ());
+	double reservedW = m_ledgerW[nodeID].GetReserved (Simulator::Now (), Seconds (horizon));
+	double reservedWD = m_ledgerWD[nodeID].GetReserved (Simulator::Now (), Seconds (horizon));
+	availableBWW = m_nodeStats[nodeID].txDataRate - (std::max (m_nodeStats[nodeID].mbsApp, reservedW) + m_nodeStats[nodeID].mbsDisc);
+	availableBWWD = m_nodeStats[nodeID].txDataRateWD - (std::max (m_nodeStats[nodeID].mbsWDApp, reservedWD) + m_nodeStats[nodeID].mbsWDDisc);
+}
 
-    std::vector<RTableEntry> sortedRoutes;
-    tasksAssigned[nodeID]++;
+Ipv4Address
+RoutingExperiment::WifiAddressOf (Ipv4Address addressWD) const
+{
+	for (std::map<Ipv4Address, Ipv4Address>::const_iterator i = m_interfaceMap.begin (); i != m_interfaceMap.end (); ++i)
+		if (i->second == addressWD)
+			return i->first;
+	return addressWD;
+}
+
+// Candidate stripes of one interface, longest usable first
+static std::vector<TaskStripe>
+StripeCandidates (const std::map<Ipv4Address, RTableEntry> &routes, uint8_t iface, double tDeadLine, bool maxProcSpeed)
+{
+	std::vector<TaskStripe> candidates;
+	for (std::map<Ipv4Address, RTableEntry>::const_iterator i = routes.begin (); i != routes.end (); ++i)
+	{
+		TaskStripe stripe;
+		stripe.dest = i->first;
+		stripe.iface = iface;
+		stripe.usable = maxProcSpeed ? tDeadLine : std::min (tDeadLine, i->second.getLinkLifeTime ());
+		stripe.rate = 0;
+		stripe.data = 0;
+		if (stripe.usable > 0)
+			candidates.push_back (stripe);
+	}
+	std::sort (candidates.begin (), candidates.end (),
+			[] (const TaskStripe &a, const TaskStripe &b) { return a.usable > b.usable; });
+	return candidates;
+}
+
+// Mbit the first count candidates can carry when the interface rate is split among them in proportion to
+// their usable time, so that every stripe ends with its link: rate * sum (usable^2) / sum (usable)
+static double
+StripeCapacity (const std::vector<TaskStripe> &candidates, uint32_t count, double rate)
+{
+	double sum = 0, sumSquares = 0;
+	for (uint32_t i = 0; i < count && i < candidates.size (); i++)
+	{
+		sum += candidates[i].usable;
+		sumSquares += candidates[i].usable * candidates[i].usable;
+	}
+	return sum > 0 ? rate * sumSquares / sum : 0;
+}
+
+bool
+RoutingExperiment::AllocateStriped (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed,
+		double availableBWW, double availableBWWD, const std::map<Ipv4Address, RTableEntry> &allRoutesW,
+		const std::map<Ipv4Address, RTableEntry> &allRoutesWD, TaskDetails &thisTask)
+{
+	std::vector<TaskStripe> candidatesW = StripeCandidates (allRoutesW, 0, tDeadLine, maxProcSpeed);
+	std::vector<TaskStripe> candidatesWD = StripeCandidates (allRoutesWD, 1, tDeadLine, maxProcSpeed);
+	double rateW = std::max (availableBWW, 0.0);
+	double rateWD = std::max (availableBWWD, 0.0);
+	uint32_t countW = candidatesW.empty () || rateW == 0 ? 0 : 1;
+	uint32_t countWD = candidatesWD.empty () || rateWD == 0 ? 0 : 1;
+	// the longest lived link of each interface carries the most; a further neighbour only spreads the task
+	// over more links, so it is added only while the task still fits
+	if (StripeCapacity (candidatesW, countW, rateW) + StripeCapacity (candidatesWD, countWD, rateWD) < tDataSize)
+	{
+		NS_LOG_DEBUG ("Task " << taskId << " does not fit on the best links of node " << nodeID);
+		return false;
+	}
+	while (countW > 0 && countW < std::min<std::size_t> (m_stripeWidth, candidatesW.size ())
+			&& StripeCapacity (candidatesW, countW + 1, rateW) + StripeCapacity (candidatesWD, countWD, rateWD) >= tDataSize)
+		countW++;
+	while (countWD > 0 && countWD < std::min<std::size_t> (m_stripeWidth, candidatesWD.size ())
+			&& StripeCapacity (candidatesW, countW, rateW) + StripeCapacity (candidatesWD, countWD + 1, rateWD) >= tDataSize)
+		countWD++;
+
+	std::vector<TaskStripe> stripes (candidatesW.begin (), candidatesW.begin () + countW);
+	stripes.insert (stripes.end (), candidatesWD.begin (), candidatesWD.begin () + countWD);
+	double usableW = 0, usableWD = 0;
+	for (std::size_t i = 0; i < stripes.size (); i++)
+		(stripes[i].iface == 0 ? usableW : usableWD) += stripes[i].usable;
+	double capacity = 0;
+	for (std::size_t i = 0; i < stripes.size (); i++)
+	{
+		stripes[i].rate = stripes[i].iface == 0 ? rateW * stripes[i].usable / usableW : rateWD * stripes[i].usable / usableWD;
+		capacity += stripes[i].rate * stripes[i].usable;
+	}
+
+	// every stripe gets its share of the capacity, so all of them need the same fraction of their usable time
+	Ptr<Node> source = NodeList::GetNode (nodeID);
+	double fraction = tDataSize / capacity;
+	double longest = 0;
+	for (std::size_t i = 0; i < stripes.size (); i++)
+	{
+		stripes[i].data = stripes[i].rate * stripes[i].usable * fraction;
+		longest = std::max (longest, stripes[i].usable * fraction);
+		NS_LOG_DEBUG ("Stripe of task " << taskId << ": " << stripes[i].data << " Mbit to " << stripes[i].dest
+				<< (stripes[i].iface == 0 ? " on W at " : " on WD at ") << stripes[i].rate << "Mbps");
+		if (stripes[i].iface == 0)
+			SendTaskW (source, stripes[i].dest, stripes[i].data, stripes[i].rate, taskId);
+		else
+			SendTaskWD (source, stripes[i].dest, stripes[i].data, stripes[i].rate, taskId);
+	}
+
+	thisTask.success = true;
+	thisTask.dataTransferStart = Simulator::Now ();
+	thisTask.dataTransferCompleted = Simulator::Now () + Seconds (longest);
+	// CheckIfTaskCompleted takes the Wi-Fi address of a neighbour
+	Ipv4Address dest = stripes[0].iface == 1 ? WifiAddressOf (stripes[0].dest) : stripes[0].dest;
+	Simulator::Schedule (Seconds (tDeadLine), &RoutingExperiment::CheckIfTaskCompleted, this, nodeID, dest, tDataSize, taskId);
+	m_taskTracker.Allocate (taskId, nodeID, thisTask.dataTransferStart, Seconds (tDeadLine),
+			tDataSize * 1e6 / 8, thisTask.dataTransferCompleted);
+	m_eventTrace.Record (EVENT_TASK_ALLOCATED, nodeID, countWD > countW ? 1 : 0, taskId, longest);
+	return true;
+}
+
+void
+RoutingExperiment::AllocateAndSend(int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed)
+{
+    m_nodeStats[nodeID].tasksAssigned++;
     TaskDetails thisTask;
     thisTask.assignTime = Simulator::Now();
-	bool transferPossible = false;
-	double speedW = m_txDataRate[nodeID]; //Mbps
-	double speedWD = m_txDataRateWD[nodeID];
-	double remainingData, finalData, totalData;
-	double remainingTimeW = 0;
-	double remainingTimeWD = 0;
+	if (!PlaceTask (nodeID, taskId, tDataSize, tDeadLine, maxProcSpeed, thisTask))
+	{
+		m_nodeStats[nodeID].tasksFailed++;
+        thisTask.success = false;
+		m_taskTracker.Reject (taskId, nodeID, Simulator::Now (), Seconds (tDeadLine));
+		m_eventTrace.Record (EVENT_TASK_REJECTED, nodeID, 0, taskId, tDeadLine);
+	}
+	orderedQueue.pop();
+    allTasks[nodeID].push_back(thisTask);
+	ScheduleNextTask ();
+}
+
+void
+RoutingExperiment::ScheduleNextTask ()
+{
+	if (orderedQueue.size() != 0)
+	{
+		Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable>();
+		x->SetAttribute("Min",DoubleValue(0));
+		x->SetAttribute("Max",DoubleValue(10));
+		int time = x->GetInteger();
+		m_generateEvent = Simulator::Schedule(Seconds(time), &RoutingExperiment::GenerateTasks, this);
+	}
+}
+
+bool
+RoutingExperiment::PlaceTask (int nodeID, uint32_t taskId, double tDataSize, double tDeadLine, bool maxProcSpeed, TaskDetails &thisTask)
+{
 	NS_LOG_DEBUG("Allocating the task");
-	NS_LOG_DEBUG("DataRate W: " << m_txDataRate[nodeID] << "Mbps, DataRate WD: " << m_txDataRateWD[nodeID] << "Mbps");
-	//	double proSpeed = std::max(cmp_proSpeed, header.GetCurrProSpeed());
+	NS_LOG_DEBUG("DataRate W: " << m_nodeStats[nodeID].txDataRate << "Mbps, DataRate WD: " << m_nodeStats[nodeID].txDataRateWD << "Mbps");
+	Ptr<Node> source = NodeList::GetNode(nodeID);
+	double availableBWW = 0.0;
+	double availableBWWD = 0.0;
+	AvailableBandwidth (nodeID, tDeadLine, availableBWW, availableBWWD);
+	NS_LOG_DEBUG("Available BW on W: " << availableBWW << "Mbps, Available BW on WD: " << availableBWWD << "Mbps");
+
+	if (m_striping)
+	{
+		Ipv4Address sourceIPW = source->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
+		Ipv4Address sourceIPWD = source->GetObject<Ipv4>()->GetAddress(2,0).GetLocal();
+		return AllocateStriped (nodeID, taskId, tDataSize, tDeadLine, maxProcSpeed, availableBWW, availableBWWD,
+				m_rTableW.GetAllRoutesWithIP(sourceIPW), m_rTableWD.GetAllRoutesWithIP(sourceIPWD), thisTask);
+	}
+
+	SplitDecision split = DecideSplit (nodeID, tDataSize, tDeadLine, maxProcSpeed, availableBWW, availableBWWD);
+	if (!split.feasible)
+	{
+		NS_LOG_DEBUG("This data transfer is not possible");
+		return false;
+	}
+	thisTask.success = true;
+	thisTask.dataTransferStart = Simulator::Now();
+	thisTask.dataTransferCompleted = Simulator::Now() + Seconds(split.completion);
+
+	Simulator::Schedule(Seconds(tDeadLine), &RoutingExperiment::CheckIfTaskCompleted, this, nodeID, split.destW, tDataSize, taskId);
+	if (split.wdFirst)
+	{
+		NS_LOG_DEBUG("Sending the maximum data " << split.finalData << " to node using Wi-Fi Direct");
+		SendTaskWD (source, split.destWD, split.finalData, split.rateWD, taskId, split.relays);
+		if(split.remainingData == 0){
+			NS_LOG_DEBUG("No need to use another WCT");
+		} else {
+			NS_LOG_DEBUG("Sending the remaining data " << split.remainingData << " to node using Wi-Fi");
+			SendTaskW (source, split.destW, split.remainingData, split.rateW, taskId, split.relays);
+		}
+	}
+	else
+	{
+		NS_LOG_DEBUG("Sending the maximum data " << split.finalData << " to node using Wi-Fi");
+		SendTaskW (source, split.destW, split.finalData, split.rateW, taskId, split.relays);
+		if(split.remainingData == 0){
+			NS_LOG_DEBUG("No need to use another WCT");
+		} else {
+			NS_LOG_DEBUG("Sending the remaining data " << split.remainingData << " to node using Wi-Fi Direct");
+			SendTaskWD (source, split.destWD, split.remainingData, split.rateWD, taskId, split.relays);
+		}
+	}
+	// the allocator works in Mbit against Mbps, so the task is tDataSize Mbit long
+	m_taskTracker.Allocate (taskId, nodeID, thisTask.dataTransferStart, Seconds (tDeadLine),
+			tDataSize * 1e6 / 8, thisTask.dataTransferCompleted);
+	if (split.hops > 1)
+		NS_LOG_DEBUG ("Task " << taskId << " goes to a helper " << split.hops << " hops away");
+	m_eventTrace.Record (EVENT_TASK_ALLOCATED, nodeID, split.wdFirst ? 1 : 0, taskId, split.completion);
+	return true;
+}
+
+/*
+ * The split only depends on the task, the bandwidth available on both
+ * interfaces and the routes of the node. At high task rates the same task
+ * class is split again and again against routes that have not changed, above
+ * all when queued tasks are retried, so the splits are kept per node until
+ * the epoch of either routing table moves on. Helpers further away depend
+ * on the routes of other nodes too, so with maxHops above 1 nothing is kept.
+ */
+SplitDecision
+RoutingExperiment::DecideSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD)
+{
+	const uint32_t *taskClass = std::find (TASK_SIZES, TASK_SIZES + 5, tDataSize);
+	if (!m_splitCache || m_maxHops > 1 || taskClass == TASK_SIZES + 5 || m_splitRateStep <= 0)
+		return ComputeSplit (nodeID, tDataSize, tDeadLine, maxProcSpeed, availableBWW, availableBWWD);
+
+	Ptr<Node> source = NodeList::GetNode(nodeID);
+	uint64_t epochW = m_rTableW.GetEpoch (source->GetObject<Ipv4>()->GetAddress(1,0).GetLocal());
+	uint64_t epochWD = m_rTableWD.GetEpoch (source->GetObject<Ipv4>()->GetAddress(2,0).GetLocal());
+	SplitCache &cache = m_splitCaches[nodeID];
+	// the available bandwidth is part of the key, so keep the cache small between route changes
+	if (cache.epochW != epochW || cache.epochWD != epochWD || cache.decisions.size () >= 64)
+	{
+		cache.decisions.clear ();
+		cache.epochW = epochW;
+		cache.epochWD = epochWD;
+	}
+	SplitKey key = {static_cast<uint32_t> (taskClass - TASK_SIZES), static_cast<uint32_t> (std::max (0.0, std::floor (tDeadLine))),
+			maxProcSpeed, static_cast<uint32_t> (std::max (0.0, std::floor (availableBWW / m_splitRateStep))),
+			static_cast<uint32_t> (std::max (0.0, std::floor (availableBWWD / m_splitRateStep)))};
+	std::map<SplitKey, SplitDecision>::const_iterator it = cache.decisions.find (key);
+	if (it != cache.decisions.end ())
+	{
+		m_splitHits++;
+		return it->second;
+	}
+	m_splitMisses++;
+	// less time and bandwidth than the task has, so the split stays feasible for all of the steps
+	SplitDecision split = ComputeSplit (nodeID, tDataSize, key.deadline, maxProcSpeed, key.rateW * m_splitRateStep,
+			key.rateWD * m_splitRateStep);
+	cache.decisions[key] = split;
+	return split;
+}
+
+SplitDecision
+RoutingExperiment::ComputeSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD)
+{
+	SplitDecision split;
+	split.feasible = false;
+	split.wdFirst = false;
+	split.finalData = 0;
+	split.remainingData = 0;
+	split.completion = 0;
+	split.hops = 1;
+	split.rateW = availableBWW;
+	split.rateWD = availableBWWD;
+
+    std::vector<RTableEntry> sortedRoutes;
 	Ptr<Node> source = NodeList::GetNode(nodeID);
 	Ipv4Address sourceIPW = source->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
 	Ipv4Address sourceIPWD = source->GetObject<Ipv4>()->GetAddress(2,0).GetLocal();
@@ -520,154 +1656,174 @@ RoutingExperiment::AllocateAndSend(int nodeID, double tDataSize, double tDeadLin
 	}
 	uint16_t rtWSize = allRoutesW.size();
 	uint16_t rtWDSize = allRoutesWD.size();
-	double availableBWW = 0.0;
-	double availableBWWD = 0.0;
 	NS_LOG_DEBUG("Routing table W Size: " << rtWSize << ", Routing Table WD Size: " << rtWDSize);
 
-	availableBWW = speedW -(mbsApp[nodeID] + mbsDisc[nodeID]);
-	availableBWWD = speedWD - (mbsWDApp[nodeID] + mbsWDDisc[nodeID]);
-	NS_LOG_DEBUG("Available BW on W: " << availableBWW << "Mbps, Available BW on WD: " << availableBWWD << "Mbps");
+	if (availableBWWD <= 0 || availableBWW <= 0)
+		return split;
+
+	for(uint16_t k = 0; k < sortedRoutes.size(); k++)
+	{
+		RTableEntry entry = sortedRoutes[k];
+		NS_LOG_DEBUG("Map Entry First: " << entry.getDestAddress().GetAny() << ", Map Entry Second: " << entry.getMyAddress());
+		double T_DT_W = (tDataSize/availableBWW);
+		NS_LOG_DEBUG("Data Transfer Time W: " << T_DT_W);
+		double T_DT_WD = (tDataSize/availableBWWD);
+		NS_LOG_DEBUG("Data Transfer Time WD: " << T_DT_WD);
+		double aW, aWD;
+
+		Ipv4Address ipWD = m_interfaceMap[entry.getDestAddress()];
+
+		if(rtWSize == 0){
+			if(T_DT_WD > tDeadLine){
+				NS_LOG_DEBUG("This task cannot be allocated ");
+				continue;
+			}
+		}
 
-	if (availableBWWD > 0 && availableBWW > 0){
-		//for (auto const map_entry : allRoutesW)
-		for(uint16_t k = 0; k < sortedRoutes.size(); k++)
+		if(rtWDSize == 0){
+			if(T_DT_W > tDeadLine){
+				NS_LOG_DEBUG("This task cannot be allocated ");
+				continue;
+			}
+		}
+
+		if(maxProcSpeed == true)
 		{
-			RTableEntry entry = sortedRoutes[k];
-			NS_LOG_DEBUG("Map Entry First: " << entry.getDestAddress().GetAny() << ", Map Entry Second: " << entry.getMyAddress());
-			NS_LOG_DEBUG("Inside AllRoutes W");
-			double T_DT_W = (tDataSize/availableBWW);
-			NS_LOG_DEBUG("Data Transfer Time W: " << T_DT_W);
-			double T_DT_WD = (tDataSize/availableBWWD);
-			NS_LOG_DEBUG("Data Transfer Time WD: " << T_DT_WD);
-			double aW, aWD;
-
-            Ipv4Address ipWD = m_interfaceMap[entry.getDestAddress()];
-
-            if(rtWSize == 0){
-            	if(T_DT_WD > tDeadLine){
-            		NS_LOG_DEBUG("This task cannot be allocated ");
-            		continue;
-            	}
-            }
+			aW = tDeadLine;
+			aWD = tDeadLine;
+		}
+		else
+		{
+			aW = std::min(tDeadLine, entry.getLinkLifeTime());
+			NS_LOG_DEBUG("Minimum value among deadline or link lifetime at W: " << aW);
+			if(allRoutesWD.find(ipWD) == allRoutesWD.end())
+				continue;
+			aWD = std::min(tDeadLine, allRoutesWD.at(ipWD).getLinkLifeTime());
+			NS_LOG_DEBUG("Minimum value among deadline or link lifetime at WD: " << aWD);
+		}
 
-            if(rtWDSize == 0){
-            	if(T_DT_W > tDeadLine){
-            		NS_LOG_DEBUG("This task cannot be allocated ");
-            		continue;
-            	}
-            }
+		SplitRequest request = {tDataSize, tDeadLine, availableBWW, availableBWWD, aW, aWD, 0, 0};
+		SplitResult result = ResourceAllocator::Split (request);
+		if(!result.feasible){
+			NS_LOG_DEBUG("This data transfer is not possible over " << entry.getDestAddress());
+			continue;
+		}
+		split.feasible = true;
+		split.wdFirst = result.wdFirst;
+		split.destW = entry.getDestAddress();
+		split.destWD = ipWD;
+		split.finalData = result.finalData;
+		split.remainingData = result.remainingData;
+		split.completion = result.completion;
+		break;
+	}
+	if (!split.feasible && m_maxHops > 1)
+		return ComputeMultiHopSplit (nodeID, tDataSize, tDeadLine, maxProcSpeed, availableBWW, availableBWWD);
+	return split;
+}
 
+/*
+ * Helpers two or more hops away, for when no neighbour can take a task.
+ * The discovery tables only know neighbours, so the paths are walked breadth
+ * first over the tables of the nodes on the way, fewest hops first, and the
+ * routing protocol carries the task along. A path lasts as long as its
+ * shortest lived hop and carries the least bandwidth any of its senders has
+ * left, shared among its hops since every relay sends on the same channel.
+ */
+SplitDecision
+RoutingExperiment::ComputeMultiHopSplit (int nodeID, double tDataSize, double tDeadLine, bool maxProcSpeed, double availableBWW, double availableBWWD)
+{
+	SplitDecision split;
+	split.feasible = false;
+	split.wdFirst = false;
+	split.finalData = 0;
+	split.remainingData = 0;
+	split.completion = 0;
+	split.hops = 0;
+	split.rateW = 0;
+	split.rateWD = 0;
+
+	std::vector<bool> seen (NodeList::GetNNodes (), false);
+	seen[nodeID] = true;
+	std::queue<HelperPath> open;
+	HelperPath start = {static_cast<uint32_t> (nodeID), 0, availableBWW, availableBWWD, tDeadLine, tDeadLine};
+	open.push (start);
+	while (!open.empty ())
+	{
+		HelperPath path = open.front ();
+		open.pop ();
+		if (path.hops >= m_maxHops)
+			continue;
+		Ptr<Ipv4> ipv4 = NodeList::GetNode (path.node)->GetObject<Ipv4> ();
+		double bwW = availableBWW, bwWD = availableBWWD;
+		if (path.hops > 0)
+			AvailableBandwidth (path.node, tDeadLine, bwW, bwWD);
+		std::map<Ipv4Address, RTableEntry> routesW = m_rTableW.GetAllRoutesWithIP (ipv4->GetAddress (1, 0).GetLocal ());
+		std::map<Ipv4Address, RTableEntry> routesWD = m_rTableWD.GetAllRoutesWithIP (ipv4->GetAddress (2, 0).GetLocal ());
+		for (std::map<Ipv4Address, RTableEntry>::const_iterator i = routesW.begin (); i != routesW.end (); ++i)
+		{
+			std::map<Ipv4Address, uint32_t>::const_iterator node = m_addressNode.find (i->first);
+			if (node == m_addressNode.end () || seen[node->second])
+				continue;
+			seen[node->second] = true;
+			Ipv4Address ipWD = m_interfaceMap[i->first];
+			std::map<Ipv4Address, RTableEntry>::const_iterator hopWD = routesWD.find (ipWD);
+			HelperPath next;
+			next.node = node->second;
+			next.hops = path.hops + 1;
+			next.rateW = std::min (path.rateW, bwW);
+			next.rateWD = std::min (path.rateWD, bwWD);
+			next.lifetimeW = std::min (path.lifetimeW, i->second.getLinkLifeTime ());
+			next.lifetimeWD = hopWD == routesWD.end () ? 0 : std::min (path.lifetimeWD, hopWD->second.getLinkLifeTime ());
+			next.relays = path.relays;
+			if (path.hops > 0)
+				next.relays.push_back (path.node);
+			open.push (next);
+			// neighbours have been tried by ComputeSplit
+			if (next.hops < 2)
+				continue;
 
-            if(maxProcSpeed == true)
+			double rateW = next.rateW / next.hops;
+			double rateWD = next.rateWD / next.hops;
+			if (rateW <= 0)
+				continue;
+			double aW = maxProcSpeed ? tDeadLine : std::min (tDeadLine, next.lifetimeW);
+			SplitResult result;
+			if (next.lifetimeWD == 0 || rateWD <= 0)
 			{
-				aW = tDeadLine;
-				aWD = tDeadLine;
+				// no Wi-Fi Direct path or no room on it: the whole task has to go over Wi-Fi
+				result.feasible = rateW * aW >= tDataSize;
+				result.wdFirst = false;
+				result.finalData = tDataSize;
+				result.remainingData = 0;
+				result.completion = tDataSize / rateW;
 			}
 			else
 			{
-				aW = std::min(tDeadLine, entry.getLinkLifeTime());
-				NS_LOG_DEBUG("Minimum value among deadline or link lifetime at W: " << aW);
-                if(allRoutesWD.find(ipWD) == allRoutesWD.end())
-                    continue;
-                aWD = std::min(tDeadLine, allRoutesWD.at(ipWD).getLinkLifeTime());
-				NS_LOG_DEBUG("Minimum value among deadline or link lifetime at WD: " << aWD);
+				double aWD = maxProcSpeed ? tDeadLine : std::min (tDeadLine, next.lifetimeWD);
+				SplitRequest request = {tDataSize, tDeadLine, rateW, rateWD, aW, aWD, 0, 0};
+				result = ResourceAllocator::Split (request);
 			}
-
-			double maxDataW = availableBWW * aW;
-			double maxDataWD = availableBWWD * aWD;
-			if (maxDataW > tDataSize)
-				maxDataW = tDataSize;
-
-			if (maxDataWD > tDataSize)
-				maxDataWD = tDataSize;
-
-			if(maxDataWD > maxDataW){
-				remainingData = tDataSize - maxDataWD;
-				remainingTimeW = remainingData*(1/availableBWW);
-				finalData = maxDataWD;
-				totalData = remainingData + maxDataWD;
-			} else {
-				remainingData = tDataSize - maxDataW;
-				remainingTimeWD = remainingData*(1/availableBWWD);
-				finalData = maxDataW;
-				totalData = remainingData + maxDataW;
-			}
-
-			double remainingTime = remainingTimeW + remainingTimeWD;
-
-			NS_LOG_DEBUG("IPWD: " << ipWD << ", Source IP: " << source->GetId());
-
-			if(totalData < tDataSize || remainingTime > tDeadLine){
-				NS_LOG_DEBUG("This data transfer is not possible");
+			if (!result.feasible)
+			{
+				NS_LOG_DEBUG ("This data transfer is not possible over " << next.hops << " hops to " << i->first);
 				continue;
 			}
-			else {
-				transferPossible = true;
-                thisTask.success = true;
-                thisTask.dataTransferStart = Simulator::Now();
-
-                Simulator::Schedule(Seconds(tDeadLine), &RoutingExperiment::CheckIfTaskCompleted, this, nodeID, entry.getDestAddress(), tDataSize);
-                if(maxDataWD >= maxDataW) {
-                    if(T_DT_WD < tDeadLine){
-						NS_LOG_DEBUG("Sending the maximum data " << finalData << " to node using Wi-Fi Direct for the time: " << T_DT_WD << "s");
-						InstallApplicationsWD (source, ipWD, T_DT_WD, availableBWWD);
-                        thisTask.dataTransferCompleted = Simulator::Now() + Seconds(T_DT_WD);
-                        orderedQueue.pop();
-					} else {
-                        thisTask.dataTransferCompleted = Simulator::Now() + Seconds(std::max(aWD, remainingTimeW ));
-						NS_LOG_DEBUG("Sending the maximum data " << finalData << " to node using Wi-Fi Direct for the time: " << aWD << "s");
-						InstallApplicationsWD (source, ipWD, aWD, availableBWWD);
-						orderedQueue.pop();
-					}
-					if(remainingData == 0){
-						NS_LOG_DEBUG("No need to use another WCT");
-					} else {
-						NS_LOG_DEBUG("Sending the remaining data " << remainingData << " to node using Wi-Fi for the time: " << remainingTimeW << "s");
-						InstallApplicationsW (source, entry.getDestAddress(), remainingTimeW, availableBWW);
-						//ordered_queue.pop();
-					}
-
-				} else {
-					if(T_DT_W < tDeadLine) {
-						NS_LOG_DEBUG("Sending the maximum data " << finalData << " to node using Wi-Fi for the time: " << T_DT_W << "s");
-                        thisTask.dataTransferCompleted = Simulator::Now() + Seconds(T_DT_W);
-						InstallApplicationsW (source, entry.getDestAddress(), T_DT_W, availableBWW);
-						orderedQueue.pop();
-					} else {
-						NS_LOG_DEBUG("Sending the maximum data " << finalData << " to node using Wi-Fi for the time: " << aW << "s" );
-                        thisTask.dataTransferCompleted = Simulator::Now() + Seconds(std::max(aW, remainingTimeWD ));
-						InstallApplicationsW (source, entry.getDestAddress(), aW, availableBWW);
-						orderedQueue.pop();
-					}
-					if(remainingData == 0){
-						NS_LOG_DEBUG( "No need to use another WCT" );
-					} else {
-						NS_LOG_DEBUG("Sending the remaining data " << remainingData << " to node using Wi-Fi Direct" << remainingTimeWD << "s" );
-						InstallApplicationsWD (source,ipWD,remainingTimeWD, availableBWWD);
-						//ordered_queue.pop();
-					}
-				}
-			}
-			if(transferPossible == true)
-				break;
+			split.feasible = true;
+			split.wdFirst = result.wdFirst;
+			split.destW = i->first;
+			split.destWD = ipWD;
+			split.finalData = result.finalData;
+			split.remainingData = result.remainingData;
+			split.completion = result.completion;
+			split.hops = next.hops;
+			split.rateW = rateW;
+			split.rateWD = rateWD;
+			split.relays = next.relays;
+			return split;
 		}
 	}
-
-	if(transferPossible == false)
-	{
-		tasksFailed[nodeID]++;
-        thisTask.success = false;
-		orderedQueue.pop();
-	}
-    allTasks[nodeID].push_back(thisTask);
-	if (orderedQueue.size() != 0)
-	{
-		Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable>();
-		x->SetAttribute("Min",DoubleValue(0));
-        x->SetAttribute("Max",DoubleValue(10));
-		int time = x->GetInteger();
-		Simulator::Schedule(Seconds(time), &RoutingExperiment::GenerateTasks, this);
-	}
+	return split;
 }
 std::vector<std::string> RoutingExperiment::Explode(const std::string& str, const char& ch){
 	std::string next;
@@ -879,37 +2035,37 @@ RoutingExperiment::Tx (std::string context, Ptr <const Packet> packet, uint16_t
 	//context will include info about the source of this event. Use string manipulation if you want to extract info.
 	//std::cout << BOLD_CODE <<  context << END_CODE << std::endl;
 	//Print the info.
-	NS_LOG_DEBUG("TxW-------------------------------------------------------");
-	NS_LOG_DEBUG("ContextW: " << context << "Packet size: "<<packet->GetSize());
+	HOT_LOG_DEBUG("TxW-------------------------------------------------------");
+	HOT_LOG_DEBUG("ContextW: " << context << "Packet size: "<<packet->GetSize());
 	std::vector<std::string> result = Explode(context, '/');
 	uint32_t nodeId = std::stoi(result[1]);
 	Ipv4Address myAddress = NodeList::GetNode(nodeId)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-	if(packet->GetSize() >= 500){
-		counterAppTX[nodeId]++;
+	if(IsApplicationPacket(packet)){
+		m_nodeStats[nodeId].counterAppTX++;
 		appPktSend[myAddress]++;
-		if(m_firstTimeAppPktSent[nodeId]){
-			m_timeFirstPktAppSent[nodeId] = Simulator::Now().GetSeconds();
-			m_firstTimeAppPktSent[nodeId] = false;
+		if(m_nodeStats[nodeId].firstTimeAppPktSent){
+			m_nodeStats[nodeId].timeFirstPktAppSent = Simulator::Now().GetSeconds();
+			m_nodeStats[nodeId].firstTimeAppPktSent = false;
 		}
 	} else {
-		counterTX[nodeId]++;
-		if(m_firstTimeDiscPktSent[nodeId]){
-			m_timeFirstPktDiscSent[nodeId] = Simulator::Now().GetSeconds();
-			m_firstTimeDiscPktSent[nodeId] = false;
+		m_nodeStats[nodeId].counterTX++;
+		if(m_nodeStats[nodeId].firstTimeDiscPktSent){
+			m_nodeStats[nodeId].timeFirstPktDiscSent = Simulator::Now().GetSeconds();
+			m_nodeStats[nodeId].firstTimeDiscPktSent = false;
 		}
 	}
-	NS_LOG_DEBUG(" Size = " << packet->GetSize()
+	HOT_LOG_DEBUG(" Size = " << packet->GetSize()
 			<< " Freq = "<<channelFreqMhz
 			<< " Mode = " << txVector.GetMode()
 			<< " TransmissionDataRate = " << txVector.GetMode().GetDataRate(txVector)
-			<< " TX Counter of Node: " << nodeId << ": " << counterTX[nodeId] << "\t TX APP Counter: " << counterAppTX[nodeId]);
-	m_txDataRate[nodeId] = txVector.GetMode().GetDataRate(txVector)/1000000;
+			<< " TX Counter of Node: " << nodeId << ": " << m_nodeStats[nodeId].counterTX << "\t TX APP Counter: " << m_nodeStats[nodeId].counterAppTX);
+	m_nodeStats[nodeId].txDataRate = txVector.GetMode().GetDataRate(txVector)/1000000;
 
 	//We can also examine the WifiMacHeader
 	WifiMacHeader hdr;
 	if (packet->PeekHeader(hdr))
 	{
-		NS_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
+		HOT_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
 	}
 }
 
@@ -917,37 +2073,37 @@ void
 RoutingExperiment::TxWD (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector,MpduInfo aMpdu){
 	//context will include info about the source of this event. Use string manipulation if you want to extract info.
 	//Print the info.
-	NS_LOG_DEBUG("TxWD-------------------------------------------------------");
-	NS_LOG_DEBUG("ContextWD: " << context << "Packet size: "<<packet->GetSize());
+	HOT_LOG_DEBUG("TxWD-------------------------------------------------------");
+	HOT_LOG_DEBUG("ContextWD: " << context << "Packet size: "<<packet->GetSize());
 	std::vector<std::string> result = Explode(context, '/');
 	uint32_t nodeId = std::stoi(result[1]);
 	Ipv4Address myAddress = NodeList::GetNode(nodeId)->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
-	if(packet->GetSize() >= 500){
-		counterAppTXWD[nodeId]++;
+	if(IsApplicationPacket(packet)){
+		m_nodeStats[nodeId].counterAppTXWD++;
 		appPktSend[myAddress]++;
-		if(m_firstTimeAppWDPktSent[nodeId]){
-			m_timeFirstPktAppWDSent[nodeId] = Simulator::Now().GetSeconds();
-			m_firstTimeAppWDPktSent[nodeId] = false;
+		if(m_nodeStats[nodeId].firstTimeAppWDPktSent){
+			m_nodeStats[nodeId].timeFirstPktAppWDSent = Simulator::Now().GetSeconds();
+			m_nodeStats[nodeId].firstTimeAppWDPktSent = false;
 		}
 	} else {
-		counterTXWD[nodeId]++;
-		if(m_firstTimeDiscWDPktSent[nodeId]){
-			m_timeFirstPktDiscWDSent[nodeId] = Simulator::Now().GetSeconds();
-			m_firstTimeDiscWDPktSent[nodeId] = false;
+		m_nodeStats[nodeId].counterTXWD++;
+		if(m_nodeStats[nodeId].firstTimeDiscWDPktSent){
+			m_nodeStats[nodeId].timeFirstPktDiscWDSent = Simulator::Now().GetSeconds();
+			m_nodeStats[nodeId].firstTimeDiscWDPktSent = false;
 		}
 	}
-	NS_LOG_DEBUG("\tSize = " << packet->GetSize()
+	HOT_LOG_DEBUG("\tSize = " << packet->GetSize()
 			<< " Freq = "<<channelFreqMhz
 			<< " Mode = " << txVector.GetMode()
 			<< " TransmissionDataRate = " << txVector.GetMode().GetDataRate(txVector)
-			<< " TX Counter of Node: " << nodeId <<": " << counterTXWD[nodeId] << "\t TX APP Counter: " << counterAppTXWD[nodeId]);
-	m_txDataRateWD[nodeId] = txVector.GetMode().GetDataRate(txVector)/1000000;
+			<< " TX Counter of Node: " << nodeId <<": " << m_nodeStats[nodeId].counterTXWD << "\t TX APP Counter: " << m_nodeStats[nodeId].counterAppTXWD);
+	m_nodeStats[nodeId].txDataRateWD = txVector.GetMode().GetDataRate(txVector)/1000000;
 
 	//We can also examine the WifiMacHeader
 	WifiMacHeader hdr;
 	if (packet->PeekHeader(hdr))
 	{
-		NS_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
+		HOT_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
 	}
 }
 
@@ -955,8 +2111,8 @@ void
 RoutingExperiment::RxWD (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise){
 	//context will include info about the source of this event. Use string manipulation if you want to extract info.
 
-	NS_LOG_DEBUG("RxWD-------------------------------------------------------");
-	NS_LOG_DEBUG("ContextWD: " << context << "Packet size: "<<packet->GetSize());
+	HOT_LOG_DEBUG("RxWD-------------------------------------------------------");
+	HOT_LOG_DEBUG("ContextWD: " << context << "Packet size: "<<packet->GetSize());
 	std::vector<std::string> result = Explode(context, '/');
 	uint32_t nodeId = std::stoi(result[1]);
 	uint32_t iface = std::stoi(result[3]);
@@ -990,38 +2146,40 @@ RoutingExperiment::RxWD (std::string context, Ptr <const Packet> packet, uint16_
 	Vector myLocation;
 	Ptr<MobilityModel> myMobilityModel = node->GetObject<MobilityModel>();
 	myLocation = myMobilityModel->GetPosition();
-	NS_LOG_DEBUG("WD My Location: " << myLocation << ", Neighbor Node Location: " << neighborNodeLocation);
+	HOT_LOG_DEBUG("WD My Location: " << myLocation << ", Neighbor Node Location: " << neighborNodeLocation);
 	double distance = std::sqrt((myLocation.x-neighborNodeLocation.x) * (myLocation.x-neighborNodeLocation.x)+ (myLocation.y-neighborNodeLocation.y)
 			* (myLocation.y-neighborNodeLocation.y));
-	NS_LOG_DEBUG("WD Distance among us is: " << distance);
+	HOT_LOG_DEBUG("WD Distance among us is: " << distance);
 
 	Ptr<MarkovChainMobilityModel> model = CreateObject<MarkovChainMobilityModel>();
 	uint16_t myLoc = model->PositionToLocation(myLocation);
 	uint16_t neighLoc = model->PositionToLocation(neighborNodeLocation);
 
 	LocationDetector(myLoc, neighLoc, myAddress, src_ip);
+	if (m_supervise)
+		m_lastFrame[nodeId][src_ip] = Simulator::Now ();
 
 
-	if(packet->GetSize() >= 500){
-		counterAppRXWD[nodeId]++;
+	if(IsApplicationPacket(packet)){
+		m_nodeStats[nodeId].counterAppRXWD++;
 		//		NS_LOG_DEBUG("WIFI Direct Packet Received from: " << src_ip << ", Destination address in Packet: " << des_ip);
 	} else {
-		counterRXWD[nodeId]++;
+		m_nodeStats[nodeId].counterRXWD++;
 	}
 
-	NS_LOG_DEBUG(myAddress <<" WD Received Packet from the Source Address: " << src_ip << ", With the Destination address in Packet: " << des_ip
+	HOT_LOG_DEBUG(myAddress <<" WD Received Packet from the Source Address: " << src_ip << ", With the Destination address in Packet: " << des_ip
 			<< ", Size = " << packet->GetSize()
 			<< ", Freq = "<<channelFreqMhz
 			<< ", Mode = " << txVector.GetMode()
 			<< ", ReceptionDataRate = " << txVector.GetMode().GetDataRate(txVector)
-			<< ", RX Counter: " << counterRXWD[nodeId] << ",\t RX APP Counter: " << counterAppRXWD[nodeId]);
-	m_rxDataRateWD[nodeId] = txVector.GetMode().GetDataRate(txVector)/1000000;
+			<< ", RX Counter: " << m_nodeStats[nodeId].counterRXWD << ",\t RX APP Counter: " << m_nodeStats[nodeId].counterAppRXWD);
+	m_nodeStats[nodeId].rxDataRateWD = txVector.GetMode().GetDataRate(txVector)/1000000;
 
 	//We can also examine the WifiMacHeader
 	WifiMacHeader hdr;
 	if (packet->PeekHeader(hdr))
 	{
-		NS_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
+		HOT_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
 	}
 }
 
@@ -1029,8 +2187,8 @@ void
 RoutingExperiment::Rx (std::string context, Ptr <const Packet> packet, uint16_t channelFreqMhz,  WifiTxVector txVector, MpduInfo aMpdu, SignalNoiseDbm signalNoise){
 	//context will include info about the source of this event. Use string manipulation if you want to extract info.
 
-	NS_LOG_DEBUG("Rx-------------------------------------------------------");
-	NS_LOG_DEBUG("ContextW: " << context << "Packet size: "<<packet->GetSize());
+	HOT_LOG_DEBUG("Rx-------------------------------------------------------");
+	HOT_LOG_DEBUG("ContextW: " << context << "Packet size: "<<packet->GetSize());
 	std::vector<std::string> result = Explode(context, '/');
 	uint32_t nodeId = std::stoi(result[1]);
 	uint32_t iface = std::stoi(result[3]);
@@ -1063,37 +2221,39 @@ RoutingExperiment::Rx (std::string context, Ptr <const Packet> packet, uint16_t
 	Vector myLocation;
 	Ptr<MobilityModel> myMobilityModel = node->GetObject<MobilityModel>();
 	myLocation = myMobilityModel->GetPosition();
-	NS_LOG_DEBUG("W My Location: " << myLocation << ", Neighbor Node Location: " << neighborNodeLocation);
+	HOT_LOG_DEBUG("W My Location: " << myLocation << ", Neighbor Node Location: " << neighborNodeLocation);
 	double distance = std::sqrt((myLocation.x-neighborNodeLocation.x) * (myLocation.x-neighborNodeLocation.x)+ (myLocation.y-neighborNodeLocation.y)
 			* (myLocation.y-neighborNodeLocation.y));
-	NS_LOG_DEBUG("W Distance among us is: " << distance);
+	HOT_LOG_DEBUG("W Distance among us is: " << distance);
 
 	Ptr<MarkovChainMobilityModel> model = CreateObject<MarkovChainMobilityModel>();
 	uint16_t myLoc = model->PositionToLocation(myLocation);
 	uint16_t neighLoc = model->PositionToLocation(neighborNodeLocation);
 
 	LocationDetector(myLoc, neighLoc, myAddress, src_ip);
+	if (m_supervise)
+		m_lastFrame[nodeId][src_ip] = Simulator::Now ();
 
-	if(packet->GetSize() >= 500){
-		counterAppRX[nodeId]++;
+	if(IsApplicationPacket(packet)){
+		m_nodeStats[nodeId].counterAppRX++;
 
 	} else {
-		counterRX[nodeId]++;
+		m_nodeStats[nodeId].counterRX++;
 	}
 	//
-	NS_LOG_DEBUG(myAddress << " W Received Packet from Source Address: " << src_ip << ", With Destination address in Packet: " << des_ip
+	HOT_LOG_DEBUG(myAddress << " W Received Packet from Source Address: " << src_ip << ", With Destination address in Packet: " << des_ip
 			<< ", Size = " << packet->GetSize()
 			<< ", Freq = "<<channelFreqMhz
 			<< ", Mode = " << txVector.GetMode()
 			<< ", ReceptionDataRate = " << txVector.GetMode().GetDataRate(txVector)
-			<< ", RX Counter: " << counterRX[nodeId] << ",\t RX APP Counter: " << counterAppRX[nodeId]);
-	m_rxDataRate[nodeId] = txVector.GetMode().GetDataRate(txVector)/1000000;
+			<< ", RX Counter: " << m_nodeStats[nodeId].counterRX << ",\t RX APP Counter: " << m_nodeStats[nodeId].counterAppRX);
+	m_nodeStats[nodeId].rxDataRate = txVector.GetMode().GetDataRate(txVector)/1000000;
 
 	//We can also examine the WifiMacHeader
 	WifiMacHeader hdr;
 	if (packet->PeekHeader(hdr))
 	{
-		NS_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
+		HOT_LOG_DEBUG("\tDestination MAC : " << hdr.GetAddr1() << "\tSource MAC : " << hdr.GetAddr2());
 	}
 }
 
@@ -1103,33 +2263,38 @@ RoutingExperiment::ReceivePacket (Ptr<Socket> socket)
 	Ptr<Packet> packet;
 	Address senderAddress;
 	//
-	NS_LOG_DEBUG("Sender Address before while: " << senderAddress);
+	HOT_LOG_DEBUG("Sender Address before while: " << senderAddress);
 	while ((packet = socket->RecvFrom (senderAddress)))
 	{
 		Ptr<Node> node = socket->GetNode();
 		uint16_t nodeID = node->GetId();
+		TrafficClassTag tag;
+		if (packet->PeekPacketTag (tag))
+			DeliverTaskData (nodeID, tag, packet->GetSize ());
 		SeqTsHeader seqTsx;
 		packet->RemoveHeader (seqTsx);
-		currentSeqNo[nodeID] = seqTsx.GetSeq ();
+		m_nodeStats[nodeID].currentSeqNo = seqTsx.GetSeq ();
 		//m_rxDataRate = GetDRate(packet);
 
-		bytesTotalApp[nodeID] += packet->GetSize ();
-		packetsReceivedApp[nodeID] += 1;
-		NS_LOG_DEBUG("Current Seq No.: " << currentSeqNo[nodeID]);
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalApp[nodeID] );
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedApp[nodeID]);
+		m_nodeStats[nodeID].bytesTotalApp += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedApp += 1;
+		HOT_LOG_DEBUG("Current Seq No.: " << m_nodeStats[nodeID].currentSeqNo);
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalApp );
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedApp);
 		//NS_LOG_UNCOND (PrintReceivedPacket (socket, packet, senderAddress));
-		rcv[nodeID] = Simulator::Now().GetSeconds();
-		sqhd[nodeID] = seqTsx.GetTs().GetSeconds();
-		NS_LOG_DEBUG("Seq No " << currentSeqNo[nodeID] << " Packet Transmitted at: " << sqhd[nodeID] << "s, Packet Received at: " << rcv[nodeID] << "s" );//Just to check seq number and Tx time
+		m_nodeStats[nodeID].rcv = Simulator::Now().GetSeconds();
+		m_nodeStats[nodeID].sqhd = seqTsx.GetTs().GetSeconds();
+		HOT_LOG_DEBUG("Seq No " << m_nodeStats[nodeID].currentSeqNo << " Packet Transmitted at: " << m_nodeStats[nodeID].sqhd << "s, Packet Received at: " << m_nodeStats[nodeID].rcv << "s" );//Just to check seq number and Tx time
 
 		//InetSocketAddress sender = InetSocketAddress::ConvertFrom(senderAddress);
 		Ipv4Address myIP = node->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
 		appPktRec[myIP]++;
 		//if(rcv>sqhd)
-		delay[nodeID] = rcv[nodeID] - sqhd[nodeID]; //delay calculation
+		m_nodeStats[nodeID].delay = m_nodeStats[nodeID].rcv - m_nodeStats[nodeID].sqhd; //delay calculation
+		m_latency[nodeID].Record (Simulator::Now () - seqTsx.GetTs ());
+		m_eventTrace.Record (EVENT_APP_RX, nodeID, 0, tag.GetTaskId (), (Simulator::Now () - seqTsx.GetTs ()).GetSeconds ());
 
-		NS_LOG_DEBUG("Delay: " << delay[nodeID] << "s");
+		HOT_LOG_DEBUG("Delay: " << m_nodeStats[nodeID].delay << "s");
 
 	}
 }
@@ -1145,27 +2310,32 @@ RoutingExperiment::ReceivePacketWD (Ptr<Socket> socket)
 	{
 		Ptr<Node> node = socket->GetNode();
 		uint16_t nodeID = node->GetId();
+		TrafficClassTag tag;
+		if (packet->PeekPacketTag (tag))
+			DeliverTaskData (nodeID, tag, packet->GetSize ());
 		SeqTsHeader seqTsx;
 		packet->RemoveHeader (seqTsx);
-		currentSeqNoWD[nodeID] = seqTsx.GetSeq ();
+		m_nodeStats[nodeID].currentSeqNoWD = seqTsx.GetSeq ();
 		//m_rxDataRate = GetDRate(packet);
 
-		bytesTotalWDApp[nodeID] += packet->GetSize ();
-		packetsReceivedWDApp[nodeID] += 1;
-		NS_LOG_DEBUG("Current Seq No.: " << currentSeqNo[nodeID]);
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalWDApp[nodeID] );
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedWDApp[nodeID]);
+		m_nodeStats[nodeID].bytesTotalWDApp += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedWDApp += 1;
+		HOT_LOG_DEBUG("Current Seq No.: " << m_nodeStats[nodeID].currentSeqNo);
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalWDApp );
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedWDApp);
 		//NS_LOG_UNCOND (PrintReceivedPacketWD (socket, packet, senderAddress));
-		rcvWD[nodeID] = Simulator::Now().GetSeconds();
-		sqhdWD[nodeID] = seqTsx.GetTs().GetSeconds();
-		NS_LOG_DEBUG("WD Seq No " << currentSeqNoWD[nodeID] << " Packet Transmitted at: " << sqhdWD[nodeID] << "s, Packet Received at: " << rcvWD[nodeID] << "s" );//Just to check seq number and Tx time
+		m_nodeStats[nodeID].rcvWD = Simulator::Now().GetSeconds();
+		m_nodeStats[nodeID].sqhdWD = seqTsx.GetTs().GetSeconds();
+		HOT_LOG_DEBUG("WD Seq No " << m_nodeStats[nodeID].currentSeqNoWD << " Packet Transmitted at: " << m_nodeStats[nodeID].sqhdWD << "s, Packet Received at: " << m_nodeStats[nodeID].rcvWD << "s" );//Just to check seq number and Tx time
 
 		// if(rcvWD>sqhdWD)
-		delayWD[nodeID] = rcvWD[nodeID] - sqhdWD[nodeID]; //delay calculation
+		m_nodeStats[nodeID].delayWD = m_nodeStats[nodeID].rcvWD - m_nodeStats[nodeID].sqhdWD; //delay calculation
+		m_latencyWD[nodeID].Record (Simulator::Now () - seqTsx.GetTs ());
+		m_eventTrace.Record (EVENT_APP_RX, nodeID, 1, tag.GetTaskId (), (Simulator::Now () - seqTsx.GetTs ()).GetSeconds ());
 		//InetSocketAddress sender = InetSocketAddress::ConvertFrom(senderAddress);
 		Ipv4Address myIP = node->GetObject<Ipv4>()->GetAddress(2,0).GetLocal();
 		appPktWDRec[myIP]++;
-		NS_LOG_DEBUG("Delay: " << delayWD[nodeID] << "s");
+		HOT_LOG_DEBUG("Delay: " << m_nodeStats[nodeID].delayWD << "s");
 	}
 
 }
@@ -1210,7 +2380,7 @@ void
 RoutingExperiment::ReceiveDiscovery(Ptr<Socket> socket)
 {
 	uint32_t context = Simulator::GetContext();
-	NS_LOG_DEBUG("Context: " << context);
+	HOT_LOG_DEBUG("Context: " << context);
 	Ptr<Packet> packet;
 	Address senderAddress;
 	Ptr<Node> thisNode = NodeList::GetNode(context);
@@ -1221,11 +2391,12 @@ RoutingExperiment::ReceiveDiscovery(Ptr<Socket> socket)
 		packet->RemoveHeader(header);
 		Ptr<Node> node = socket->GetNode();
 		uint16_t nodeID = node->GetId();
-		bytesTotalDisc[nodeID] += packet->GetSize ();
-		packetsReceivedDisc[nodeID] += 1;
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalDisc[nodeID]);
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedDisc[nodeID]);
+		m_nodeStats[nodeID].bytesTotalDisc += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedDisc += 1;
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalDisc);
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedDisc);
 		Ipv4Address src_ip = header.GetSource();
+		m_eventTrace.Record (EVENT_DISCOVERY_RX, nodeID, 0, src_ip.Get (), 0);
 		Vector myLocation = thisNode->GetObject<MobilityModel>()->GetPosition();
 		Vector neighborNodeLocation;
 		Ipv4Address myAddress = thisNode->GetObject<Ipv4>()->GetAddress(1,0).GetLocal();
@@ -1249,23 +2420,26 @@ RoutingExperiment::ReceiveDiscovery(Ptr<Socket> socket)
 		uint16_t nextLoc = thisNode->GetObject<MarkovChainMobilityModel>()->GetNextLocation();
 		uint16_t nextTime = thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime();
 		double proSpeed = ProSpeedGen(1.0,2.4);
-		NS_LOG_DEBUG("W Next Location in Header: " << header.GetNextLocation() << ", My next Location: " << nextLoc);
+		HOT_LOG_DEBUG("W Next Location in Header: " << header.GetNextLocation() << ", My next Location: " << nextLoc);
 		if (header.GetNextLocation() == nextLoc)
 		{
+			// the speed the reply below advertises
+			m_cpuSpeed[context] = proSpeed;
 			RTableEntry rTableEntryW;
-            NS_LOG_DEBUG("Header source " << header.GetSource() << " MyAddress " << myAddress);
+            HOT_LOG_DEBUG("Header source " << header.GetSource() << " MyAddress " << myAddress);
             bool permanentTableVerifier = m_rTableW.LookupRoute (header.GetSource(), myAddress, rTableEntryW);
-			NS_LOG_DEBUG("Is the route inside the table? " << permanentTableVerifier);
+			HOT_LOG_DEBUG("Is the route inside the table? " << permanentTableVerifier);
 			if (permanentTableVerifier == false)
 			{
 				app->SendReplyPacketW(thisNode, myAddress, src_ip, nextLoc, nextTime, proSpeed);
-				NS_LOG_DEBUG ("Received New WRoute!");
+				HOT_LOG_DEBUG ("Received New WRoute!");
 				RTableEntry newEntry(/*My Address=*/ myAddress, /*destination address=*/ header.GetSource(), /*time connected=*/0.0, /*time packet received=*/
 						Simulator::Now (), /*time First packet received=*/ Simulator::Now (), /*my location=*/ myLocation, /*neighbor location=*/ neighborNodeLocation,
 						/*neighbor next location=*/header.GetNextLocation(), /*neighbor next interval=*/0, /*neighbor link lifetime=*/0.0, /*neighbor current
 						 * processor speed=*/ 0.0);
 				m_rTableW.AddRoute (newEntry);
-				NS_LOG_DEBUG ("New WRoute added to Wtable!");
+				m_eventTrace.Record (EVENT_ROUTE_ADDED, nodeID, 0, src_ip.Get (), 0);
+				HOT_LOG_DEBUG ("New WRoute added to Wtable!");
 			}
 			else
 			{
@@ -1279,15 +2453,19 @@ RoutingExperiment::ReceiveDiscovery(Ptr<Socket> socket)
 				rTableEntryW.setNeighborNodeLocation(neighborNodeLocation);
 				rTableEntryW.setNextLocation(nextLoc);
 				m_rTableW.Update(rTableEntryW);
-				NS_LOG_DEBUG ("Route Updated in WTable!");
+				m_eventTrace.Record (EVENT_ROUTE_UPDATED, nodeID, 0, src_ip.Get (), timeConnected);
+				HOT_LOG_DEBUG ("Route Updated in WTable!");
 			}
-			NS_LOG_DEBUG("Values in the rTableW are: ");
+			HOT_LOG_DEBUG("Values in the rTableW are: ");
 			if(m_rTableW.RTableSize() > 0)
 			{
 				m_rTableW.GetListOfAllRoutes();
 				m_rTableW.GetListofAllRoutes(myAddress);
-				Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtDiscW + ".routes"), std::ios::app);
-				PrintRoutingTableW(routingStream,socket, nodeID);
+				if (m_routeDumps)
+				{
+					Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtDiscW + ".routes"), std::ios::app);
+					PrintRoutingTableW(routingStream,socket, nodeID);
+				}
 			}
 		}
 	}
@@ -1297,7 +2475,7 @@ void
 RoutingExperiment::ReceiveDiscoveryWD(Ptr<Socket> socket)
 {
 	uint32_t context = Simulator::GetContext();
-	NS_LOG_DEBUG("Context: " << context);
+	HOT_LOG_DEBUG("Context: " << context);
 	Ptr<Packet> packet;
 	Address senderAddress;
 	Ptr<Node> thisNode = NodeList::GetNode(context);
@@ -1307,11 +2485,12 @@ RoutingExperiment::ReceiveDiscoveryWD(Ptr<Socket> socket)
 	{
 		DiscoveryPacketHeader header;
 		packet->RemoveHeader(header);
-		bytesTotalWDDisc[nodeID] += packet->GetSize ();
-		packetsReceivedWDDisc[nodeID] += 1;
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalWDDisc[nodeID]);
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedWDDisc[nodeID]);
+		m_nodeStats[nodeID].bytesTotalWDDisc += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedWDDisc += 1;
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalWDDisc);
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedWDDisc);
 		Ipv4Address src_ip = header.GetSource();
+		m_eventTrace.Record (EVENT_DISCOVERY_RX, nodeID, 1, src_ip.Get (), 0);
 		Vector myLocation = thisNode->GetObject<MobilityModel>()->GetPosition();
 		Vector neighborNodeLocation;
 		Ipv4Address myAddress = thisNode->GetObject<Ipv4>()->GetAddress(2,0).GetLocal();
@@ -1335,23 +2514,26 @@ RoutingExperiment::ReceiveDiscoveryWD(Ptr<Socket> socket)
 		uint16_t nextLoc = thisNode->GetObject<MarkovChainMobilityModel>()->GetNextLocation();
 		uint16_t nextTime = thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime();
 		double proSpeed = ProSpeedGen(1.0,2.4);
-		NS_LOG_DEBUG("WD Next Location in Header: " << header.GetNextLocation() << ", My next Location: " << nextLoc);
+		HOT_LOG_DEBUG("WD Next Location in Header: " << header.GetNextLocation() << ", My next Location: " << nextLoc);
 		if (header.GetNextLocation() == nextLoc)
 		{
+			// the speed the reply below advertises
+			m_cpuSpeed[context] = proSpeed;
 			RTableEntry rTableEntryWD;
-            NS_LOG_DEBUG("Header source " << header.GetSource() << " MyAddress " << myAddress);
+            HOT_LOG_DEBUG("Header source " << header.GetSource() << " MyAddress " << myAddress);
             bool permanentTableVerifier = m_rTableWD.LookupRoute (header.GetSource(), myAddress,rTableEntryWD);
-			NS_LOG_DEBUG("Is the route inside the WDtable? " << permanentTableVerifier);
+			HOT_LOG_DEBUG("Is the route inside the WDtable? " << permanentTableVerifier);
 			if (permanentTableVerifier == false)
 			{
 				app->SendReplyPacketWD(thisNode, myAddress, src_ip, nextLoc, nextTime, proSpeed);
-				NS_LOG_DEBUG ("Received New WDRoute!");
+				HOT_LOG_DEBUG ("Received New WDRoute!");
 				RTableEntry newEntry(/*My Address=*/ myAddress, /*destination address=*/ header.GetSource(), /*time connected=*/0.0, /*time packet received=*/
 						Simulator::Now (), /*time First packet received=*/ Simulator::Now (), /*my location=*/ myLocation, /*neighbor location=*/ neighborNodeLocation,
 						/*neighbor next location=*/header.GetNextLocation(), /*neighbor next interval=*/0, /*neighbor link lifetime=*/0.0,/*neighbor current processor
 						 * speed=*/ 0.0);
 				m_rTableWD.AddRoute (newEntry);
-				NS_LOG_DEBUG ("New WDRoute added to WDtable!");
+				m_eventTrace.Record (EVENT_ROUTE_ADDED, nodeID, 1, src_ip.Get (), 0);
+				HOT_LOG_DEBUG ("New WDRoute added to WDtable!");
 			}
 			else
 			{
@@ -1365,15 +2547,19 @@ RoutingExperiment::ReceiveDiscoveryWD(Ptr<Socket> socket)
 				rTableEntryWD.setNeighborNodeLocation(neighborNodeLocation);
 				rTableEntryWD.setNextLocation(nextLoc);
 				m_rTableWD.Update(rTableEntryWD);
-				NS_LOG_DEBUG ("Route Updated in WDTable!");
+				m_eventTrace.Record (EVENT_ROUTE_UPDATED, nodeID, 1, src_ip.Get (), timeConnected);
+				HOT_LOG_DEBUG ("Route Updated in WDTable!");
 			}
-			NS_LOG_DEBUG("Values in the rTableWD are: ");
+			HOT_LOG_DEBUG("Values in the rTableWD are: ");
 			if(m_rTableWD.RTableSize() > 0)
 			{
 				m_rTableWD.GetListOfAllRoutes();
 				m_rTableWD.GetListofAllRoutes(myAddress);
-				Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtDiscWD + ".routes"), std::ios::app);
-				PrintRoutingTableWD(routingStream,socket, nodeID);
+				if (m_routeDumps)
+				{
+					Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtDiscWD + ".routes"), std::ios::app);
+					PrintRoutingTableWD(routingStream,socket, nodeID);
+				}
 			}
 
 		}
@@ -1386,7 +2572,7 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
 {
 
 	uint32_t context = Simulator::GetContext();
-	NS_LOG_DEBUG("Context: " << context);
+	HOT_LOG_DEBUG("Context: " << context);
 	Ptr<Packet> packet;
 	Address senderAddress;
 	Ptr<Node> thisNode = NodeList::GetNode(context);
@@ -1396,10 +2582,10 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
 	{
 		ReplyPacketHeader header;
 		packet->RemoveHeader(header);
-		bytesTotalDisc[nodeID] += packet->GetSize ();
-		packetsReceivedDisc[nodeID] += 1;
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalDisc[nodeID]);
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedDisc[nodeID]);
+		m_nodeStats[nodeID].bytesTotalDisc += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedDisc += 1;
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalDisc);
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedDisc);
 		Ipv4Address src_ip = header.GetSource();
 		Vector myLocation = thisNode->GetObject<MobilityModel>()->GetPosition();
 		Vector neighborNodeLocation;
@@ -1420,24 +2606,24 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
 				neighborNodeLocation = neighborNodeModel->GetPosition();
 			}
 		}
-		NS_LOG_DEBUG("Next Time interval in Header: " << header.GetNextTimeInterval() << ", My Next Time Interval: " << thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime());
-		double llt = std::min(TimeIntervalToTime(header.GetNextTimeInterval()), TimeIntervalToTime(thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime()));
-		NS_LOG_DEBUG("Link LifetimeW: " << llt);
+		HOT_LOG_DEBUG("Next Time interval in Header: " << header.GetNextTimeInterval() << ", My Next Time Interval: " << thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime());
+		double llt = PredictLinkLifetime (thisNode, src_ip, header.GetNextTimeInterval());
+		HOT_LOG_DEBUG("Link LifetimeW: " << llt);
 		RTableEntry rTableEntryW;
 
-        NS_LOG_DEBUG("Header source " << src_ip << " MyAddress " << myAddress);
+        HOT_LOG_DEBUG("Header source " << src_ip << " MyAddress " << myAddress);
         bool permanentTableVerifier = m_rTableW.LookupRoute (src_ip, myAddress, rTableEntryW);
-		NS_LOG_DEBUG("Is the route inside the RTableW? " << permanentTableVerifier);
+		HOT_LOG_DEBUG("Is the route inside the RTableW? " << permanentTableVerifier);
 		if (permanentTableVerifier == false)
 		{
-			NS_LOG_DEBUG ("Received New WRoute!");
+			HOT_LOG_DEBUG ("Received New WRoute!");
 			RTableEntry newEntry(/*My Address=*/ myAddress, /*destination address=*/ header.GetSource(), /*time connected=*/0.0, /*time packet received=*/
 					Simulator::Now (), /*time First packet received=*/ Simulator::Now (), /*my location=*/ myLocation, /*neighbor location=*/ neighborNodeLocation,
 					/*neighbor next location=*/header.GetNextLocation(),/*neighbor next time Interval=*/header.GetNextTimeInterval(),/*neighbor link lifetime=*/
 					llt, /*neighbor current processor speed=*/ header.GetCurrProSpeed());
 
 			m_rTableW.AddRoute (newEntry);
-			NS_LOG_DEBUG ("New WRoute added to Wtable!");
+			HOT_LOG_DEBUG ("New WRoute added to Wtable!");
 		}
 		else
 		{
@@ -1455,8 +2641,8 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
                     rTableEntryW.setLinkLifeTime(llt);
 					rTableEntryW.setCurrProSpeed(header.GetCurrProSpeed());
 					m_rTableW.Update(rTableEntryW);
-					NS_LOG_DEBUG("Routing Table W updated");
-					NS_LOG_DEBUG("No need to update the Routing Table W as the values haven't changed yet!");
+					HOT_LOG_DEBUG("Routing Table W updated");
+					HOT_LOG_DEBUG("No need to update the Routing Table W as the values haven't changed yet!");
 					//}
 				}
 				else
@@ -1468,7 +2654,7 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
 					rTableEntryW.setLinkLifeTime(llt);
 					rTableEntryW.setCurrProSpeed(header.GetCurrProSpeed());
 					m_rTableW.Update(rTableEntryW);
-					NS_LOG_DEBUG("Routing Table W updated");
+					HOT_LOG_DEBUG("Routing Table W updated");
 				}
 
 			}
@@ -1482,17 +2668,20 @@ RoutingExperiment::ReceiveReply(Ptr<Socket> socket)
 				rTableEntryW.setLinkLifeTime(llt);
 				rTableEntryW.setCurrProSpeed(header.GetCurrProSpeed());
 				m_rTableW.Update(rTableEntryW);
-				NS_LOG_DEBUG("Routing Table W updated");
+				HOT_LOG_DEBUG("Routing Table W updated");
 			}
 
 		}
-		NS_LOG_DEBUG("Values in the rTableW are: ");
+		HOT_LOG_DEBUG("Values in the rTableW are: ");
 		if(m_rTableW.RTableSize() > 0)
 		{
 			m_rTableW.GetListOfAllRoutes();
 			m_rTableW.GetListofAllRoutes(myAddress);
-			Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtRcvW + ".routes"), std::ios::app);
-			PrintRoutingTableW(routingStream,socket, nodeID);
+			if (m_routeDumps)
+			{
+				Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtRcvW + ".routes"), std::ios::app);
+				PrintRoutingTableW(routingStream,socket, nodeID);
+			}
 		}
 
 	}
@@ -1501,7 +2690,7 @@ void
 RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
 {
 	uint32_t context = Simulator::GetContext();
-	NS_LOG_DEBUG("Context: " << context);
+	HOT_LOG_DEBUG("Context: " << context);
 	Ptr<Packet> packet;
 	Address senderAddress;
 	Ptr<Node> thisNode = NodeList::GetNode(context);
@@ -1513,10 +2702,10 @@ RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
 	{
 		ReplyPacketHeader header;
 		packet->RemoveHeader(header);
-		bytesTotalWDDisc[nodeID] += packet->GetSize ();
-		packetsReceivedWDDisc[nodeID] += 1;
-		NS_LOG_DEBUG("Bytes total received: " << bytesTotalWDDisc[nodeID]);
-		NS_LOG_DEBUG("Packets total received: " << packetsReceivedWDDisc[nodeID]);
+		m_nodeStats[nodeID].bytesTotalWDDisc += packet->GetSize ();
+		m_nodeStats[nodeID].packetsReceivedWDDisc += 1;
+		HOT_LOG_DEBUG("Bytes total received: " << m_nodeStats[nodeID].bytesTotalWDDisc);
+		HOT_LOG_DEBUG("Packets total received: " << m_nodeStats[nodeID].packetsReceivedWDDisc);
 		Ipv4Address src_ip = header.GetSource();
 		//        uint16_t senderNode;
 		int32_t nNodes = NodeList::GetNNodes ();
@@ -1536,23 +2725,23 @@ RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
 			}
 		}
 
-		NS_LOG_DEBUG("Next Time interval in Header: " << header.GetNextTimeInterval() << ", My Next Time Interval: " << thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime());
-		double llt = std::min(TimeIntervalToTime(header.GetNextTimeInterval()), TimeIntervalToTime(thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime()));
-		NS_LOG_DEBUG("Link LifetimeWD: " << llt);
+		HOT_LOG_DEBUG("Next Time interval in Header: " << header.GetNextTimeInterval() << ", My Next Time Interval: " << thisNode->GetObject<MarkovChainMobilityModel>()->GetNextTime());
+		double llt = PredictLinkLifetime (thisNode, WifiAddressOf (src_ip), header.GetNextTimeInterval());
+		HOT_LOG_DEBUG("Link LifetimeWD: " << llt);
 		RTableEntry rTableEntryWD;
-       NS_LOG_DEBUG("Header source " << src_ip << " MyAddress " << myAddress);
+       HOT_LOG_DEBUG("Header source " << src_ip << " MyAddress " << myAddress);
         bool permanentTableVerifier = m_rTableWD.LookupRoute (src_ip, myAddress, rTableEntryWD);
-		NS_LOG_DEBUG("Is the route inside the RtableWD? " << permanentTableVerifier);
+		HOT_LOG_DEBUG("Is the route inside the RtableWD? " << permanentTableVerifier);
 		if (permanentTableVerifier == false)
 		{
-			NS_LOG_DEBUG ("Received New WDRoute!");
+			HOT_LOG_DEBUG ("Received New WDRoute!");
 			RTableEntry newEntry(/*My Address=*/ myAddress, /*destination address=*/ header.GetSource(), /*time connected=*/0.0, /*time packet received=*/
 					Simulator::Now (), /*time First packet received=*/ Simulator::Now (), /*my location=*/ myLocation, /*neighbor location=*/ neighborNodeLocation,
 					/*neighbor next location=*/header.GetNextLocation(),/*neighbor next time Interval=*/header.GetNextTimeInterval(),/*neighbor link lifetime=*/
 					llt,/*neighbor current processor speed=*/ header.GetCurrProSpeed());
 
 			m_rTableWD.AddRoute (newEntry);
-			NS_LOG_DEBUG ("New WDRoute added to WDtable!");
+			HOT_LOG_DEBUG ("New WDRoute added to WDtable!");
 		}
 		else
 		{
@@ -1569,11 +2758,11 @@ RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
                     rTableEntryWD.setLinkLifeTime(llt);
 					rTableEntryWD.setCurrProSpeed(header.GetCurrProSpeed());
 					m_rTableWD.Update(rTableEntryWD);
-					NS_LOG_DEBUG("Routing Table WD updated");
+					HOT_LOG_DEBUG("Routing Table WD updated");
 					//					if(header.GetCurrProSpeed() == proSpeed){
 					//
 					//					}
-					NS_LOG_DEBUG("No need to update the Routing Table WD as the values haven't changed yet!");
+					HOT_LOG_DEBUG("No need to update the Routing Table WD as the values haven't changed yet!");
 				}
 				else
 				{
@@ -1584,7 +2773,7 @@ RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
 					rTableEntryWD.setLinkLifeTime(llt);
 					rTableEntryWD.setCurrProSpeed(header.GetCurrProSpeed());
 					m_rTableWD.Update(rTableEntryWD);
-					NS_LOG_DEBUG("Routing Table WD updated");
+					HOT_LOG_DEBUG("Routing Table WD updated");
 				}
 
 			}
@@ -1595,116 +2784,271 @@ RoutingExperiment::ReceiveReplyWD(Ptr<Socket> socket)
 				rTableEntryWD.setLinkLifeTime(llt);
 				rTableEntryWD.setCurrProSpeed(header.GetCurrProSpeed());
 				m_rTableW.Update(rTableEntryWD);
-				NS_LOG_DEBUG("Routing Table WD updated");
+				HOT_LOG_DEBUG("Routing Table WD updated");
 			}
 
 		}
-		NS_LOG_DEBUG("Values in the rTableWD are: ");
+		HOT_LOG_DEBUG("Values in the rTableWD are: ");
 		if(m_rTableWD.RTableSize() > 0)
 		{
 			m_rTableWD.GetListOfAllRoutes();
 			m_rTableWD.GetListofAllRoutes(myAddress);
-			Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtRcvWD + ".routes"), std::ios::app);
-			PrintRoutingTableWD(routingStream,socket, nodeID);
+			if (m_routeDumps)
+			{
+				Ptr<OutputStreamWrapper> routingStream = Create<OutputStreamWrapper> ((rtRcvWD + ".routes"), std::ios::app);
+				PrintRoutingTableWD(routingStream,socket, nodeID);
+			}
 		}
 
 	}
 }
 
+// Turns the byte counters of the last second into Mbit and the throughput since the first packet.
+// The inputs and outputs are strided fields of the cache line aligned NodeStats, so the loop over
+// all nodes in SampleAllNodes runs one node at a time; it only saves the per node events.
+static inline void
+ComputeRates (NodeStats &stats, double now)
+{
+	stats.mbsDisc = (stats.bytesTotalDisc * 8.0) / 1000 / 1000;
+	stats.bytesTotalDisc = 0;
+
+	stats.mbsWDDisc = (stats.bytesTotalWDDisc * 8.0) / 1000 / 1000;
+	stats.bytesTotalWDDisc = 0;
+
+	stats.mbsApp = (stats.bytesTotalApp * 8.0) / 1000 / 1000;
+	stats.bytesTotalApp = 0;
+
+	stats.mbsWDApp = (stats.bytesTotalWDApp * 8.0) / 1000 / 1000;
+	stats.bytesTotalWDApp = 0;
+
+	stats.throughputW = stats.mbsDisc/(now - stats.timeFirstPktDiscSent);
+
+	stats.throughputWApp = stats.mbsApp/(now - stats.timeFirstPktAppSent);
+
+	stats.throughputWD = stats.mbsWDDisc/(now - stats.timeFirstPktDiscWDSent);
+
+	stats.throughputWDApp = stats.mbsWDApp/(now - stats.timeFirstPktAppWDSent);
+}
+
 void
-RoutingExperiment::CheckThroughput (uint16_t i)
-{
-	mbsDisc[i] = (bytesTotalDisc[i] * 8.0) / 1000 / 1000;
-	bytesTotalDisc[i] = 0;
-
-	mbsWDDisc[i] = (bytesTotalWDDisc[i] * 8.0) / 1000 / 1000;
-	bytesTotalWDDisc[i] = 0;
-
-	mbsApp[i] = (bytesTotalApp[i] * 8.0) / 1000 / 1000;
-	bytesTotalApp[i] = 0;
-
-	mbsWDApp[i] = (bytesTotalWDApp[i] * 8.0) / 1000 / 1000;
-	bytesTotalWDApp[i] = 0;
-
-	double throughputW = mbsDisc[i]/(Simulator::Now().GetSeconds() - m_timeFirstPktDiscSent[i]);
-
-	double throughputWApp = mbsApp[i]/(Simulator::Now().GetSeconds() - m_timeFirstPktAppSent[i]);
-
-	double throughputWD = mbsWDDisc[i]/(Simulator::Now().GetSeconds() - m_timeFirstPktDiscWDSent[i]);
-
-	double throughputWDApp = mbsWDApp[i]/(Simulator::Now().GetSeconds() - m_timeFirstPktAppWDSent[i]);
-
-	NS_LOG_DEBUG("Performance Metrics: mbsDisc: " << mbsDisc[i] << ", mbsWDDisc: " << mbsWDDisc[i] << ", mbsApp: " << mbsApp[i] << ", mbsWDApp: " << mbsWDApp[i]
-		 << ", throughputW: " << throughputW << ", throughputWApp: " << throughputWApp << ", throughputWD: " << throughputWD << ", throughputWDApp: " << throughputWDApp);
-
-	std::ofstream out (std::to_string(i) + m_CSVfileName.c_str (), std::ios::app);
-	out << (Simulator::Now ()).GetSeconds () << ","
-			<< tasksAssigned[i] << ","
-			<< tasksFailed[i] << ","
-			<< mbsDisc[i] << ","
-			<< mbsWDDisc[i] << ","
-			<< mbsApp[i] << ","
-			<< mbsWDApp[i] << ","
-			<< throughputW << ","
-			<< throughputWD << ","
-			<< throughputWApp << ","
-			<< throughputWDApp << ","
-			<< packetsReceivedDisc[i] << ","
-			<< packetsReceivedWDDisc[i] << ","
-			<< packetsReceivedApp[i] << ","
-			<< packetsReceivedWDApp[i] << ","
-			<< currentSeqNo[i] << ","
-			<< currentSeqNoWD[i] << ","
-			<< m_txDataRate[i] << ","
-			<< m_txDataRateWD[i] << ","
-			<< m_rxDataRate[i] << ","
-			<< m_rxDataRateWD[i] << ","
-			<< delay[i] << ","
-			<< delayWD[i] << ","
-			<< counterAppTX[i] << ","
-			<< counterAppTXWD[i] << ","
-			<< counterAppRX[i] << ","
-			<< counterAppRXWD[i] << ","
-			<< counterTX[i] << ","
-			<< counterTXWD[i] << ","
-			<< counterRX[i] << ","
-			<< counterRXWD[i] << ""
-			<< std::endl;
-
-	out.close ();
-
-	packetsReceivedDisc[i] = 0;
-	packetsReceivedWDDisc[i] = 0;
-	packetsReceivedApp[i] = 0;
-	packetsReceivedWDApp[i] = 0;
-	currentSeqNo[i] = 0;
-	counterTX[i] = 0;
-	counterRX[i] = 0;
-	counterAppTX[i] = 0;
-	counterAppRX[i] = 0;
-	rcv[i] = 0.0;
-	sqhd[i] = 0.0;
-	delay[i] = 0.0;
-	rcvWD[i] = 0.0;
-	sqhdWD[i] = 0.0;
-	delayWD[i] = 0.0;
-	currentSeqNoWD[i] = 0;
-	counterTXWD[i] = 0;
-	counterRXWD[i] = 0;
-	counterAppTXWD[i] = 0;
-	counterAppRXWD[i] = 0;
-	PhyTxDropCount = 0;
-	PhyRxDropCount = 0;
+RoutingExperiment::RecordSample (uint32_t i, MetricsRecord &row)
+{
+	NodeStats &stats = m_nodeStats[i];
+	NS_LOG_DEBUG("Performance Metrics: mbsDisc: " << stats.mbsDisc << ", mbsWDDisc: " << stats.mbsWDDisc << ", mbsApp: " << stats.mbsApp << ", mbsWDApp: " << stats.mbsWDApp
+		 << ", throughputW: " << stats.throughputW << ", throughputWApp: " << stats.throughputWApp << ", throughputWD: " << stats.throughputWD << ", throughputWDApp: " << stats.throughputWDApp);
+
+	row.Clear ();
+	if (m_columnarMetrics)
+		row << i;
+	row << (Simulator::Now ()).GetSeconds ()
+			<< stats.tasksAssigned
+			<< stats.tasksFailed
+			<< stats.mbsDisc
+			<< stats.mbsWDDisc
+			<< stats.mbsApp
+			<< stats.mbsWDApp
+			<< stats.throughputW
+			<< stats.throughputWD
+			<< stats.throughputWApp
+			<< stats.throughputWDApp
+			<< stats.packetsReceivedDisc
+			<< stats.packetsReceivedWDDisc
+			<< stats.packetsReceivedApp
+			<< stats.packetsReceivedWDApp
+			<< stats.currentSeqNo
+			<< stats.currentSeqNoWD
+			<< stats.txDataRate
+			<< stats.txDataRateWD
+			<< stats.rxDataRate
+			<< stats.rxDataRateWD
+			<< (double) stats.delay
+			<< (double) stats.delayWD
+			<< stats.counterAppTX
+			<< stats.counterAppTXWD
+			<< stats.counterAppRX
+			<< stats.counterAppRXWD
+			<< stats.counterTX
+			<< stats.counterTXWD
+			<< stats.counterRX
+			<< stats.counterRXWD
+			<< m_latency[i].GetPercentile (50)
+			<< m_latency[i].GetPercentile (90)
+			<< m_latency[i].GetPercentile (99)
+			<< m_latency[i].GetMax ()
+			<< m_latencyWD[i].GetPercentile (50)
+			<< m_latencyWD[i].GetPercentile (90)
+			<< m_latencyWD[i].GetPercentile (99)
+			<< m_latencyWD[i].GetMax ()
+			<< m_taskQueues[i].size ()
+			<< stats.tasksStolen
+			<< stats.bytesMigrated
+			<< stats.migrationSlack;
+
+	m_latencyRun.Merge (m_latency[i]);
+	m_latencyRunWD.Merge (m_latencyWD[i]);
+	m_latency[i].Reset ();
+	m_latencyWD[i].Reset ();
+	stats.packetsReceivedDisc = 0;
+	stats.packetsReceivedWDDisc = 0;
+	stats.packetsReceivedApp = 0;
+	stats.packetsReceivedWDApp = 0;
+	stats.currentSeqNo = 0;
+	stats.counterTX = 0;
+	stats.counterRX = 0;
+	stats.counterAppTX = 0;
+	stats.counterAppRX = 0;
+	stats.rcv = 0.0;
+	stats.sqhd = 0.0;
+	stats.delay = 0.0;
+	stats.rcvWD = 0.0;
+	stats.sqhdWD = 0.0;
+	stats.delayWD = 0.0;
+	stats.currentSeqNoWD = 0;
+	stats.counterTXWD = 0;
+	stats.counterRXWD = 0;
+	stats.counterAppTXWD = 0;
+	stats.counterAppRXWD = 0;
+}
+
+void
+RoutingExperiment::ResetDropCounters ()
+{
 	PhyTxDropCount = 0;
 	PhyRxDropCount = 0;
 	PhyTxDropCountWD = 0;
 	PhyRxDropCountWD = 0;
 	discPkt = 0;
 	discPktWD = 0;
+}
+
+void
+RoutingExperiment::SampleAllNodes ()
+{
+	m_sampleTick++;
+	LinkLifeTimer();
+
+	if (!m_perNodeSampling)
+	{
+		double now = Simulator::Now().GetSeconds();
+		NodeStats *stats = m_nodeStats.data ();
+		uint32_t n = m_nodeStats.size ();
+		for (uint32_t i = 0; i < n; i++)
+			ComputeRates (stats[i], now);
+
+		m_sampleRows.resize (n);
+		for (uint32_t i = 0; i < n; i++)
+			RecordSample (i, m_sampleRows[i]);
+		m_metrics.AppendBatch (m_throughputOut, m_sampleRows);
+	}
+
+	if (m_sampleTick % 5 == 0)
+	{
+		PrintDrop();
+		PrintDropWD();
+	}
+	if (!m_perNodeSampling)
+		ResetDropCounters();
+
+	Simulator::Schedule (Seconds (1.0), &RoutingExperiment::SampleAllNodes, this);
+}
+
+void
+RoutingExperiment::CheckThroughput (uint32_t i)
+{
+	ComputeRates (m_nodeStats[i], Simulator::Now().GetSeconds());
+	MetricsRecord row;
+	RecordSample (i, row);
+	m_metrics.Append (m_throughputOut[i], row);
+	ResetDropCounters();
 
 	Simulator::Schedule (Seconds (1.0), &RoutingExperiment::CheckThroughput, this, i);
 }
 
+MetricsSchema
+RoutingExperiment::ThroughputSchema ()
+{
+	static const MetricsColumn columns[] = {
+			{"SimulationSecond", METRICS_F64},
+			{"TasksAssigned", METRICS_U64},
+			{"TasksFailed", METRICS_U64},
+			{"ThroughputDisc", METRICS_F64},
+			{"ThroughputWDDisc", METRICS_F64},
+			{"ThroughputApp", METRICS_F64},
+			{"ThroughputWDApp", METRICS_F64},
+			{"ThroughputDiscovery", METRICS_F64},
+			{"ThroughputWDDiscovery", METRICS_F64},
+			{"ThroughputApplication", METRICS_F64},
+			{"ThroughputWDApplication", METRICS_F64},
+			{"PacketsReceivedDisc", METRICS_U64},
+			{"PacketsReceivedWDDisc", METRICS_U64},
+			{"PacketsReceivedApp", METRICS_U64},
+			{"PacketsReceivedWDApp", METRICS_U64},
+			{"TotalPacketsSent", METRICS_U64},
+			{"TotalPacketsSentWD", METRICS_U64},
+			{"TxDataRate", METRICS_U64},
+			{"TxDataRateWD", METRICS_U64},
+			{"RxDataRate", METRICS_U64},
+			{"RxDataRateWD", METRICS_U64},
+			{"Delay", METRICS_F64},
+			{"DelayWD", METRICS_F64},
+			{"NumOfTxAppPkts", METRICS_U64},
+			{"NumOfTxAppPktsWD", METRICS_U64},
+			{"NumOfRxAppPkts", METRICS_U64},
+			{"NumOfRxAppPktsWD", METRICS_U64},
+			{"TxPackets", METRICS_U64},
+			{"TxPacketsWD", METRICS_U64},
+			{"RxPackets", METRICS_U64},
+			{"RxPacketsWD", METRICS_U64},
+			{"DelayP50", METRICS_F64},
+			{"DelayP90", METRICS_F64},
+			{"DelayP99", METRICS_F64},
+			{"DelayMax", METRICS_F64},
+			{"DelayWDP50", METRICS_F64},
+			{"DelayWDP90", METRICS_F64},
+			{"DelayWDP99", METRICS_F64},
+			{"DelayWDMax", METRICS_F64},
+			{"QueueDepth", METRICS_U64},
+			{"TasksStolen", METRICS_U64},
+			{"BytesMigrated", METRICS_U64},
+			{"MigrationSlack", METRICS_F64}
+	};
+	return MetricsSchema (columns, columns + sizeof (columns) / sizeof (columns[0]));
+}
+
+// Merges the latency of the whole run and writes the non-empty buckets to latency-<CSVfileName>
+void
+RoutingExperiment::WriteLatencySummary ()
+{
+	LatencyHistogram total[2] = {m_latencyRun, m_latencyRunWD};
+	for (uint32_t i = 0; i < m_latency.size (); i++)
+	{
+		// samples of the period still in progress were never reported, count them too
+		total[0].Merge (m_latency[i]);
+		total[1].Merge (m_latencyWD[i]);
+	}
+
+	static const MetricsColumn columns[] = {
+			{"Interface", METRICS_U64},
+			{"LatencyUpperBound", METRICS_F64},
+			{"Count", METRICS_U64}
+	};
+	MetricsSink::Handle out = m_metrics.OpenCsv ("latency-" + m_CSVfileName, MetricsSchema (columns, columns + 3));
+	MetricsRecord row;
+	for (uint32_t iface = 0; iface < 2; iface++)
+	{
+		NS_LOG_INFO ((iface == 0 ? "Wi-Fi" : "Wi-Fi Direct") << " latency over " << total[iface].GetCount () << " packets: p50 " << total[iface].GetPercentile (50)
+				<< "s, p90 " << total[iface].GetPercentile (90) << "s, p99 " << total[iface].GetPercentile (99) << "s, max " << total[iface].GetMax () << "s");
+		for (uint32_t b = total[iface].GetFirstBucket (); b < total[iface].GetEndBucket (); b++)
+		{
+			if (total[iface].GetBucketCount (b) == 0)
+				continue;
+			row.Clear ();
+			row << iface << LatencyHistogram::GetBucketUpperBound (b) << total[iface].GetBucketCount (b);
+			m_metrics.Append (out, row);
+		}
+	}
+}
+
 Ptr<Socket>
 RoutingExperiment::SetupPacketReceive (Ipv4Address addr, Ptr<Node> node)
 {
@@ -1788,9 +3132,44 @@ RoutingExperiment::CommandSetup (int argc, char **argv)
 {
 	CommandLine cmd;
 	cmd.AddValue ("CSVfileName", "The name of the CSV output file name", m_CSVfileName);
+	cmd.AddValue ("nNodes", "Number of nodes", m_nSinks);
+	cmd.AddValue ("perNodeSampling", "Sample every node in its own event, staggered over the second, instead of all nodes in one event", m_perNodeSampling);
+	cmd.AddValue ("columnarMetrics", "Write a single columnar binary metrics file instead of one CSV per node", m_columnarMetrics);
 	cmd.AddValue ("traceMobility", "Enable mobility tracing", m_traceMobility);
-	cmd.AddValue ("protocol", "1=OLSR;2=AODV;3=DSDV;4=DSR", m_protocol);
+	cmd.AddValue ("protocol", "0=none;1=OLSR;2=AODV;3=DSDV;4=DSR", m_protocol);
+	cmd.AddValue ("maxHops", "Most hops to a helper; above 1, helpers further away are tried when no neighbour can take a task. "
+			"Needs a routing protocol", m_maxHops);
+	cmd.AddValue ("eventTrace", "Write a binary trace of application, discovery, route and task events to this file", m_eventTraceFile);
+	cmd.AddValue ("eventTraceKeepLast", "Keep only the most recent events of the event trace", m_eventTraceKeepLast);
+	cmd.AddValue ("verbose", "Enable the debug log of the experiment", m_verbose);
+	cmd.AddValue ("routeDumps", "Append the routing table of a node to the rt-*.routes files on every discovery and reply it receives", m_routeDumps);
+	cmd.AddValue ("captureMode", "full: ASCII trace and pcap of the whole run; ring: keep the last frames in memory and write pcap "
+			"on a deadline miss, a link break and at the end; off: no frame capture", m_captureMode);
+	cmd.AddValue ("captureWindow", "Seconds of frames kept per device in ring capture mode", m_captureWindow);
+	cmd.AddValue ("captureClass", "Traffic class kept in ring capture mode: all, application, discovery or reply", m_captureClass);
+	cmd.AddValue ("captureNode", "Only keep frames to or from this node in ring capture mode, -1 for all", m_captureNode);
+	cmd.AddValue ("flowmonInterval", "Seconds between two exports of per flow deltas to <CSVfileName>-flows.llmc, 0 to disable", m_flowmonInterval);
+	cmd.AddValue ("striping", "Split every task across several neighbours and both interfaces", m_striping);
+	cmd.AddValue ("stripeWidth", "Most neighbours per interface a striped task is split across", m_stripeWidth);
+	cmd.AddValue ("nodeQueues", "Queue tasks per node, earliest deadline first, until they can be placed or miss their deadline", m_nodeQueues);
+	cmd.AddValue ("stealing", "With nodeQueues, let idle neighbours take over tasks a node cannot place", m_stealing);
+	cmd.AddValue ("superviseTransfers", "Move the rest of a transfer to another link when its link breaks", m_supervise);
+	cmd.AddValue ("superviseInterval", "Seconds between two checks of the transfers", m_superviseInterval);
+	cmd.AddValue ("linkBreakTimeout", "Seconds without a frame from a neighbour before its link counts as broken", m_linkBreakTimeout);
+	cmd.AddValue ("linkLifetime", "Link lifetime of a route. interval: the shorter of the next time intervals of both nodes; "
+			"expected: mean of the lifetime predicted from the learned Markov chains of both nodes; quantile: lifetime reached with probability 1 - lifetimeRisk", m_linkLifetime);
+	cmd.AddValue ("lifetimeRisk", "Probability of a link breaking before the lifetime planned with, for linkLifetime=quantile", m_lifetimeRisk);
+	cmd.AddValue ("splitCache", "Reuse the Wi-Fi / Wi-Fi Direct split of a task until the routes of the node change", m_splitCache);
+	cmd.AddValue ("splitRateStep", "Mbps the available bandwidths are rounded down to for cached splits", m_splitRateStep);
+	cmd.AddValue ("execution", "Run every task on the neighbours that receive it, at the processor speed they advertise, and send the results back", m_execution);
+	cmd.AddValue ("cyclesPerBit", "CPU cycles per bit of task data, with execution", m_cyclesPerBit);
+	cmd.AddValue ("resultRatio", "Size of the results relative to the task data a neighbour received, with execution", m_resultRatio);
+	cmd.AddValue ("batchWindow", "Seconds tasks are collected and then assigned together by min-cost flow, 0 to assign them one by one", m_batchWindow);
+	cmd.AddValue ("maxActiveTransfers", "Task transfers an interface of a node sends at once, later ones are queued; 0 for no limit", m_maxActiveTransfers);
+	cmd.AddValue ("flowmonXml", "Write the FlowMonitor XML file, with histograms and probes, at the end of the run", m_flowmonXml);
 	cmd.Parse (argc, argv);
+	if (m_verbose)
+		LogComponentEnable ("ManetRoutingCompare", LOG_LEVEL_DEBUG);
 	return m_CSVfileName;
 }
 
@@ -1818,14 +3197,12 @@ void
 RoutingExperiment::PrintDrop()
 {
 	NS_LOG_DEBUG( Simulator::Now().GetSeconds() << "\t MAC TX Drop: " << MacTxDropCount << "\t PHY TX Drop: "<< PhyTxDropCount << "\t PHY RX Drop: " << PhyRxDropCount << "\n");
-	Simulator::Schedule(Seconds(5.0), &RoutingExperiment::PrintDrop,this);
 }
 
 void
 RoutingExperiment::PrintDropWD()
 {
 	NS_LOG_DEBUG( Simulator::Now().GetSeconds() << "\t WDMAC TX Drop: " << MacTxDropCountWD << "\t WDPHY TX Drop: "<< PhyTxDropCountWD << "\t WDPHY RX Drop: " << PhyRxDropCountWD << "\n");
-	Simulator::Schedule(Seconds(5.0), &RoutingExperiment::PrintDropWD, this);
 }
 
 void
@@ -1853,9 +3230,11 @@ RoutingExperiment::PhyRxDropWD(Ptr<const Packet> p, ns3::WifiPhyRxfailureReason
 void
 RoutingExperiment::LinkLifeTimer()
 {
-	m_rTableW.GetInActiveRoutes();
-	m_rTableWD.GetInActiveRoutes();
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::LinkLifeTimer, this);
+	uint32_t inActiveRoutes = m_rTableW.GetInActiveRoutes() + m_rTableWD.GetInActiveRoutes();
+	// a route going silent is the closest thing to a link break the tables know of
+	if (m_capture && inActiveRoutes > m_inActiveRoutes)
+		m_capture->Trigger ("manet-routing-compare-ring", "linkbreak");
+	m_inActiveRoutes = inActiveRoutes;
 }
 
 void
@@ -1868,63 +3247,55 @@ RoutingExperiment::CourseChange (std::string context, Ptr<const MobilityModel> m
 int
 main (int argc, char *argv[])
 {
-	LogComponentEnable ("ManetRoutingCompare", LOG_LEVEL_DEBUG);
 	RoutingExperiment experiment;
-	uint32_t nSinks = 5;
 	std::string CSVfileName = experiment.CommandSetup (argc,argv);
 
-	//blank out the last output file and write the column headers
-	for(uint16_t i = 0; i < nSinks; i++){
-		std::ofstream out (std::to_string(i) + CSVfileName.c_str ());
-		out << "SimulationSecond," <<
-				"TasksAssigned," <<
-				"TasksFailed," <<
-				"ThroughputDisc," <<
-				"ThroughputWDDisc," <<
-				"ThroughputApp," <<
-				"ThroughputWDApp," <<
-				"ThroughputDiscovery," <<
-				"ThroughputWDDiscovery," <<
-				"ThroughputApplication," <<
-				"ThroughputWDApplication," <<
-				"PacketsReceivedDisc," <<
-				"PacketsReceivedWDDisc," <<
-				"PacketsReceivedApp," <<
-				"PacketsReceivedWDApp," <<
-				"TotalPacketsSent," <<
-				"TotalPacketsSentWD," <<
-				"TxDataRate," <<
-				"TxDataRateWD," <<
-				"RxDataRate," <<
-				"RxDataRateWD," <<
-				"Delay," <<
-				"DelayWD," <<
-				"NumOfTxAppPkts," <<
-				"NumOfTxAppPktsWD," <<
-				"NumOfRxAppPkts," <<
-				"NumOfRxAppPktsWD," <<
-				"TxPackets," <<
-				"TxPacketsWD," <<
-				"RxPackets," <<
-				"RxPacketsWD" <<
-				std::endl;
-		out.close ();
-	}
 
 
 	double txp = 7.5;
 
-	experiment.Run (nSinks, txp, CSVfileName);
+	experiment.Run (txp, CSVfileName);
 }
 
 void
-RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
+RoutingExperiment::Run (double txp, std::string CSVfileName)
 {
 	Packet::EnablePrinting ();
-	m_nSinks = nSinks;
 	m_txp = txp;
 	m_CSVfileName = CSVfileName;
-	uint32_t nWifis = nSinks;
+	uint32_t nWifis = m_nSinks;
+	m_nodeStats.assign (nWifis, NodeStats ());
+	allTasks.assign (nWifis, std::vector<TaskDetails> ());
+	m_latency.assign (nWifis, LatencyHistogram ());
+	m_latencyWD.assign (nWifis, LatencyHistogram ());
+
+	//blank out the last output files and write the column headers
+	MetricsSchema throughputSchema = ThroughputSchema ();
+	std::string baseName = m_CSVfileName;
+	if (baseName.size () > 4 && baseName.compare (baseName.size () - 4, 4, ".csv") == 0)
+		baseName.erase (baseName.size () - 4);
+	if (m_columnarMetrics)
+	{
+		MetricsColumn nodeId = {"NodeId", METRICS_U64};
+		throughputSchema.insert (throughputSchema.begin (), nodeId);
+		MetricsSink::Handle out = m_metrics.Open (new ColumnarMetricsOutput (baseName + ".llmc", throughputSchema));
+		m_throughputOut.assign (nWifis, out);
+	}
+	else
+	{
+		for(uint32_t i = 0; i < nWifis; i++){
+			m_throughputOut.push_back (m_metrics.OpenCsv (std::to_string(i) + m_CSVfileName, throughputSchema));
+		}
+	}
+	m_taskTracker.SetOutput (&m_metrics, m_metrics.OpenCsv ("tasks-" + m_CSVfileName, TaskTracker::GetSchema ()));
+	m_taskTracker.SetExecution (m_execution);
+	Simulator::ScheduleDestroy (&MetricsSink::Close, &m_metrics);
+	if (!m_eventTraceFile.empty ())
+	{
+		if (!m_eventTrace.Open (m_eventTraceFile, m_eventTraceKeepLast))
+			NS_FATAL_ERROR ("Cannot create event trace " << m_eventTraceFile);
+		Simulator::ScheduleDestroy (&EventTrace::Close, &m_eventTrace);
+	}
 //	double m_dataStart = 0.01;
 	double TotalTime = 250.0;
 	std::string tr_name ("manet-routing-compare");
@@ -1935,7 +3306,6 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 	int nodeSpeed = 30; //in m/s
 	int nodePause = 0; //in s
 	std::string rtslimit = "2200";
-	m_protocolName = "protocol";
 
 	Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", StringValue (rtslimit));
 	adhocNodes.Create (nWifis);
@@ -2005,31 +3375,95 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 	streamIndex += mobility.AssignStreams (adhocNodes, streamIndex);
 	NS_UNUSED (streamIndex); // From this point, streamIndex is unused);
 
+	AodvHelper aodv;
+	OlsrHelper olsr;
+	DsdvHelper dsdv;
+	DsrHelper dsr;
+	DsrMainHelper dsrMain;
+	Ipv4StaticRoutingHelper staticRouting;
+	Ipv4ListRoutingHelper list;
 	InternetStackHelper stack;
+	switch (m_protocol)
+	{
+	case 0:
+		m_protocolName = "NONE";
+		break;
+	case 1:
+		list.Add (olsr, 100);
+		m_protocolName = "OLSR";
+		break;
+	case 2:
+		list.Add (aodv, 100);
+		m_protocolName = "AODV";
+		break;
+	case 3:
+		list.Add (dsdv, 100);
+		m_protocolName = "DSDV";
+		break;
+	case 4:
+		m_protocolName = "DSR";
+		break;
+	default:
+		NS_FATAL_ERROR ("No such protocol: " << m_protocol);
+	}
+	if (m_maxHops > 1 && m_protocol == 0)
+		NS_FATAL_ERROR ("maxHops above 1 needs a routing protocol");
+	m_maxHops = std::max<uint32_t> (m_maxHops, 1);
+	// the discovery tables only know neighbours, a routing protocol carries tasks to helpers further away.
+	// Static routing stays behind it, so that the subnet broadcasts of discovery, which the protocols have no
+	// route for, still go out on the interface of their subnet.
+	if (m_protocol >= 1 && m_protocol <= 3)
+	{
+		list.Add (staticRouting, 0);
+		stack.SetRoutingHelper (list);
+	}
 	stack.Install (adhocNodes);
+	if (m_protocol == 4)
+		dsrMain.Install (dsr, adhocNodes);
+	NS_LOG_INFO ("Routing protocol: " << m_protocolName);
 
 	NS_LOG_INFO ("assigning ip address");
 
 	Ipv4AddressHelper addressAdhoc, addressAdhocWD;
-	addressAdhoc.SetBase ("10.1.1.0", "255.255.255.0");
-	addressAdhocWD.SetBase ("10.1.2.0", "255.255.255.0");
+	if (nWifis < 255)
+	{
+		addressAdhoc.SetBase ("10.1.1.0", "255.255.255.0");
+		addressAdhocWD.SetBase ("10.1.2.0", "255.255.255.0");
+	}
+	else
+	{
+		// a /24 runs out of host addresses beyond 254 nodes
+		addressAdhoc.SetBase ("10.1.0.0", "255.255.0.0");
+		addressAdhocWD.SetBase ("10.2.0.0", "255.255.0.0");
+	}
 	Ipv4InterfaceContainer adhocInterfaces, adhocInterfacesWD;
 	adhocInterfaces = addressAdhoc.Assign (adhocDevices);
 	adhocInterfacesWD = addressAdhocWD.Assign(adhocDevicesWD);
 
-	for(uint16_t i=0;i < nWifis; i++)
+	for(uint32_t i=0;i < nWifis; i++)
 	{
 		Ptr<Node> node = NodeList::GetNode (i);
 		Ipv4Address nodeAddress = node->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
 		Ipv4Address nodeAddressWD = node->GetObject<Ipv4> ()->GetAddress (2, 0).GetLocal ();
 		m_interfaceMap.insert(std::pair<Ipv4Address, Ipv4Address>(nodeAddress, nodeAddressWD));
+		m_addressNode[nodeAddress] = i;
 		appPktSend.insert(std::pair<Ipv4Address, uint64_t>(nodeAddress,0));
 		appPktRec.insert(std::pair<Ipv4Address, uint64_t>(nodeAddress,0));
 		appPktWDSend.insert(std::pair<Ipv4Address, uint64_t>(nodeAddressWD,0));
 		appPktWDRec.insert(std::pair<Ipv4Address, uint64_t>(nodeAddressWD,0));
 	}
 
-	for(uint16_t i=0;i < nWifis; i++)
+	// 100 ms slots over the longest deadline, and some slack for pieces sent late
+	Time ledgerWindow = Seconds (*std::max_element (TASK_DEADLINES, TASK_DEADLINES + 5) + 10);
+	m_ledgerW.assign (nWifis, BandwidthLedger (MilliSeconds (100), ledgerWindow));
+	m_ledgerWD.assign (nWifis, BandwidthLedger (MilliSeconds (100), ledgerWindow));
+	m_taskQueues.assign (nWifis, NodeTaskQueue ());
+	m_serveEvents.assign (nWifis, EventId ());
+	m_lastFrame.assign (nWifis, std::map<Ipv4Address, Time> ());
+	m_splitCaches.assign (nWifis, SplitCache ());
+	m_cpuSpeed.assign (nWifis, 0);
+	m_cpuFree.assign (nWifis, Time ());
+	for(uint32_t i=0;i < nWifis; i++)
 	{
 		Ptr<Node> node = NodeList::GetNode (i);
 		Ptr<DiscoveryApplication> app = Create<DiscoveryApplication> ();
@@ -2041,6 +3475,26 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 		NS_LOG_DEBUG("Broadcast Address WD: " << broadCast2);
 		node->AddApplication(app);
 		app->Setup(InetSocketAddress(broadCast1, port), InetSocketAddress(broadCast2, portWD), Seconds(1),10, 81);
+		// connected on the pointer rather than through a Config path, which walks the application list of every node
+		app->TraceConnectWithoutContext ("Tx", MakeCallback (&RoutingExperiment::txDiscApp, this));
+		app->TraceConnectWithoutContext ("Tx", MakeCallback (&RoutingExperiment::txDiscAppWD, this));
+		// one persistent task sender per interface, after the discovery application which stays at index 0
+		Ptr<TransferApplication> senderW = CreateObject<TransferApplication> ();
+		senderW->SetAttribute ("InterfaceKind", UintegerValue (TrafficClassTag::IFACE_W));
+		senderW->SetAttribute ("MaxActiveTransfers", UintegerValue (m_maxActiveTransfers));
+		node->AddApplication (senderW);
+		senderW->SetStartTime (Seconds (0));
+		senderW->TraceConnectWithoutContext ("TxWithAddresses", MakeCallback (&RoutingExperiment::txApp, this));
+		senderW->TraceConnect ("TransferComplete", std::to_string (i), MakeCallback (&RoutingExperiment::TransferComplete, this));
+		m_transferW.push_back (senderW);
+		Ptr<TransferApplication> senderWD = CreateObject<TransferApplication> ();
+		senderWD->SetAttribute ("InterfaceKind", UintegerValue (TrafficClassTag::IFACE_WD));
+		senderWD->SetAttribute ("MaxActiveTransfers", UintegerValue (m_maxActiveTransfers));
+		node->AddApplication (senderWD);
+		senderWD->SetStartTime (Seconds (0));
+		senderWD->TraceConnectWithoutContext ("TxWithAddresses", MakeCallback (&RoutingExperiment::txAppWD, this));
+		senderWD->TraceConnect ("TransferComplete", std::to_string (i), MakeCallback (&RoutingExperiment::TransferCompleteWD, this));
+		m_transferWD.push_back (senderWD);
 		DiscoverySink = SetupDiscoveryReceive (broadCast1, node);
 		DiscoverySinkWD = SetupDiscoveryReceiveWD (broadCast2, node);
 		ReplySink = SetupReplyReceive(nodeAddress, node);
@@ -2060,25 +3514,63 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 	//tr_name = tr_name + "_" + m_protocolName +"_" + nodes + "nodes_" + sNodeSpeed + "speed_" + sNodePause + "pause_" + sRate + "rate";
 
 	AsciiTraceHelper ascii;
-	Ptr<OutputStreamWrapper> osw = ascii.CreateFileStream ( (tr_name + ".tr").c_str());
-	wifiPhy.EnableAsciiAll (osw);
-	wifiPhy.EnablePcap("manet-routing-compare", adhocDevices);
+	if (m_captureMode == "full")
+	{
+		Ptr<OutputStreamWrapper> osw = ascii.CreateFileStream ( (tr_name + ".tr").c_str());
+		wifiPhy.EnableAsciiAll (osw);
+		wifiPhy.EnablePcap("manet-routing-compare", adhocDevices);
+	}
+	else if (m_captureMode == "ring")
+	{
+		m_capture.reset (new PcapRingCapture (Seconds (m_captureWindow)));
+		if (m_captureClass == "application")
+		{
+			m_capture->AddClassFilter (TrafficClassTag::APPLICATION);
+			m_capture->AddClassFilter (TrafficClassTag::RESULT);
+		}
+		else if (m_captureClass == "discovery")
+			m_capture->AddClassFilter (TrafficClassTag::DISCOVERY);
+		else if (m_captureClass == "reply")
+			m_capture->AddClassFilter (TrafficClassTag::REPLY);
+		else if (m_captureClass != "all")
+			NS_FATAL_ERROR ("Unknown capture class " << m_captureClass);
+		if (m_captureNode >= 0 && (uint32_t) m_captureNode < nWifis)
+		{
+			m_capture->AddAddressFilter (Mac48Address::ConvertFrom (adhocDevices.Get (m_captureNode)->GetAddress ()));
+			m_capture->AddAddressFilter (Mac48Address::ConvertFrom (adhocDevicesWD.Get (m_captureNode)->GetAddress ()));
+		}
+		m_capture->Install (adhocDevices);
+		m_capture->Install (adhocDevicesWD);
+	}
+	else if (m_captureMode != "off")
+		NS_FATAL_ERROR ("Unknown capture mode " << m_captureMode);
+	if (m_linkLifetime != "interval" && m_linkLifetime != "expected" && m_linkLifetime != "quantile")
+		NS_FATAL_ERROR ("Unknown link lifetime " << m_linkLifetime);
 	MobilityHelper::EnableAsciiAll (ascii.CreateFileStream (tr_name + ".mob"));
 
 	Ptr<FlowMonitor> flowmon;
 	FlowMonitorHelper flowmonHelper;
 	flowmon = flowmonHelper.InstallAll ();
+	if (!m_flowmonXml)
+		FlowStatsExporter::SetCompactMonitor (flowmon);
+	if (m_flowmonInterval > 0)
+	{
+		// flows of finished task transfers are retired after 10 s without traffic
+		m_flowExporter.reset (new FlowStatsExporter (flowmon, DynamicCast<Ipv4FlowClassifier> (flowmonHelper.GetClassifier ()),
+				Seconds (m_flowmonInterval), Seconds (10)));
+		m_flowExporter->Start (&m_metrics, m_metrics.Open (new ColumnarMetricsOutput (baseName + "-flows.llmc", FlowStatsExporter::GetSchema ())));
+	}
 
 	NS_LOG_INFO ("Run Simulation.");
 
-	for(uint16_t i = 0; i < 5; i++){
-		NS_LOG_DEBUG("First Time: " << m_firstTime[i]);
-		if(m_firstTime[i]){
+	for(uint32_t i = 0; i < nWifis; i++){
+		NS_LOG_DEBUG("First Time: " << m_nodeStats[i].firstTime);
+		if(m_nodeStats[i].firstTime){
 			NS_LOG_DEBUG("Ignore checking throughput");
 		}
 		else{
 			CheckThroughput (i);
-			m_firstTime[i] = false;
+			m_nodeStats[i].firstTime = false;
 		}
 	}
 	PrintRoutingTable();
@@ -2089,26 +3581,30 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 	Config::ConnectWithoutContext("/NodeList/*/DeviceList/1/$ns3::WifiNetDevice/Mac/MacTxDrop", MakeCallback(&RoutingExperiment::MacTxDropWD, this));
 	Config::ConnectWithoutContext("/NodeList/*/DeviceList/1/$ns3::WifiNetDevice/Phy/PhyRxDrop", MakeCallback(&RoutingExperiment::PhyRxDropWD, this));
 	Config::ConnectWithoutContext("/NodeList/*/DeviceList/1/$ns3::WifiNetDevice/Phy/PhyTxDrop", MakeCallback(&RoutingExperiment::PhyTxDropWD, this));
-	Config::ConnectWithoutContext("/NodeList/*/ApplicationList/0/$ns3::DiscoveryApplication/Tx", MakeCallback(&RoutingExperiment::txDiscApp, this));
-	Config::ConnectWithoutContext("/NodeList/*/ApplicationList/0/$ns3::DiscoveryApplication/Tx", MakeCallback(&RoutingExperiment::txDiscAppWD, this));
 	Config::Connect("/NodeList/*/DeviceList/0/$ns3::WifiNetDevice/Phy/MonitorSnifferTx", MakeCallback(&RoutingExperiment::Tx, this));
 	Config::Connect("/NodeList/*/DeviceList/0/$ns3::WifiNetDevice/Phy/MonitorSnifferRx", MakeCallback(&RoutingExperiment::Rx, this));
 	Config::Connect("/NodeList/*/DeviceList/1/$ns3::WifiNetDevice/Phy/MonitorSnifferTx", MakeCallback(&RoutingExperiment::TxWD, this));
 	Config::Connect("/NodeList/*/DeviceList/1/$ns3::WifiNetDevice/Phy/MonitorSnifferRx", MakeCallback(&RoutingExperiment::RxWD, this));
 	Config::Connect("/NodeList/*/$ns3::MobilityModel/CourseChange", MakeCallback (&RoutingExperiment::CourseChange, this));
-	Simulator::Schedule(Seconds(5.0), &RoutingExperiment::PrintDrop, this);
-	Simulator::Schedule(Seconds(5.0), &RoutingExperiment::PrintDropWD, this);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::LinkLifeTimer, this);
 	Simulator::Schedule(Seconds(10.0), &RoutingExperiment::StartTaskGeneration, this);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::CheckThroughput, this,0);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::CheckThroughput, this,1);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::CheckThroughput, this,2);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::CheckThroughput, this,3);
-	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::CheckThroughput, this,4);
+	if (m_supervise)
+		Simulator::Schedule(Seconds(10.0 + m_superviseInterval), &RoutingExperiment::SuperviseTransfers, this);
+	// one event per second samples every node, checks link lifetimes and prints the drop counters
+	Simulator::Schedule(Seconds(1.0), &RoutingExperiment::SampleAllNodes, this);
+	if (m_perNodeSampling)
+	{
+		for(uint32_t i = 0; i < nWifis; i++)
+			Simulator::Schedule(Seconds(1.0 + (double) i / nWifis), &RoutingExperiment::CheckThroughput, this, i);
+	}
 	Simulator::Stop (Seconds (TotalTime));
 
 
 	Simulator::Run ();
+	NS_LOG_INFO ("Task splits: " << m_splitHits << " cached, " << m_splitMisses << " computed, "
+			<< (m_splitHits + m_splitMisses > 0 ? 100.0 * m_splitHits / (m_splitHits + m_splitMisses) : 0) << "% hit rate");
+
+	if (m_capture)
+		m_capture->Dump ("manet-routing-compare-ring", "end");
 
 	// Print per flow statistics
 	flowmon->CheckForLostPackets ();
@@ -2130,10 +3626,10 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 //		NS_LOG_UNCOND( "  Throughput: " << iter->second.rxBytes * 8.0 / (iter->second.timeLastRxPacket.GetSeconds()-iter->second.timeFirstTxPacket.GetSeconds()) / 1024 / 1024 << " Mbps");
 
 //	}
-	for(int i=0;i<5;i++)
+	for(uint32_t i = 0; i < nWifis; i++)
 	{
-		NS_LOG_DEBUG("Tasks assigned to node: "<< i <<" : "<<tasksAssigned[i]);
-		NS_LOG_DEBUG("Tasks failed by node: "<< i <<" : "<<tasksFailed[i]);
+		NS_LOG_DEBUG("Tasks assigned to node: "<< i <<" : "<<m_nodeStats[i].tasksAssigned);
+		NS_LOG_DEBUG("Tasks failed by node: "<< i <<" : "<<m_nodeStats[i].tasksFailed);
 	}
 
     NS_LOG_DEBUG("Printing task completion details");
@@ -2160,7 +3656,12 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
         j++;
     }
 
-	flowmon->SerializeToXmlFile ((tr_name + ".flowmon").c_str(), true, true);
+	m_taskTracker.Finish ();
+	WriteLatencySummary ();
+	if (m_flowExporter)
+		m_flowExporter->Finish ();
+	if (m_flowmonXml)
+		flowmon->SerializeToXmlFile ((tr_name + ".flowmon").c_str(), true, true);
 
 	Simulator::Destroy ();
 }